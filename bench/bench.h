@@ -0,0 +1,55 @@
+/**
+ * @file bench.h
+ * @brief Wall clock and failure count shared by the host benchmarks.
+ *
+ * Each benchmark is one source file. It times its cases with now_ns(),
+ * reports a failed check with check() or fail(), and returns
+ * report_failures() from main(), which is 1 if anything failed.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static int failures;
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Prints "FAIL" and the message, and counts a failure.
+ */
+static inline void fail(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    fputs("FAIL ", stdout);
+    vprintf(format, args);
+    putchar('\n');
+    va_end(args);
+    failures++;
+}
+
+static inline void check(bool ok, const char *what) {
+    if (!ok)
+        fail("%s", what);
+}
+
+/**
+ * @brief Prints the failure count.
+ *
+ * @return The exit status of the benchmark.
+ */
+static inline int report_failures(void) {
+    printf("failures: %d\n", failures);
+    return failures ? 1 : 0;
+}
+
+#endif // BENCH_H
@@ -0,0 +1,175 @@
+/**
+ * @file bench_blit.c
+ * @brief Bitmap blits: every raster op and clipping checked against a
+ * per-pixel baseline, and the throughput of both.
+ *
+ * Built once per supported geometry (bench_blit_128x64, _128x32 and
+ * _64x48), like bench_geometry, so the part-filled words of 32- and
+ * 48-row columns are covered. Random bitmaps up to 72 rows high are
+ * blitted at random positions, across every edge, with every raster op.
+ * The framebuffer must equal the one the baseline draws through
+ * ssd1306_pixel, and the dirty boxes must cover every pixel that changed.
+ * Then bitmaps of a few sizes are timed, page-aligned and 3 rows off,
+ * against the baseline.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "../inc/ssd1306.h"
+
+#define CHECKS 20000
+#define ROUNDS 2000
+#define PASSES 5 ///< The fastest is kept, the others had the host scheduler in them
+#define MAX_SIZE 72
+#define MAX_COLUMNS (SSD1306_WIDTH > MAX_SIZE ? SSD1306_WIDTH : MAX_SIZE)
+
+ssd1306_t ssd;
+
+static uint32_t seed = 0x1306;
+static uint8_t bitmap_data[MAX_COLUMNS * ((MAX_SIZE + 7) / 8)];
+
+// xorshift32, so every run checks the same cases
+static uint32_t random_u32(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static int random_in(int low, int high) {
+    return low + (int)(random_u32() % (uint32_t)(high - low + 1));
+}
+
+static bool get_pixel(int x, int y) {
+    return ssd.ram_buffer[1 + y / 8 + x * SSD1306_PAGES] >> (y & 7) & 1;
+}
+
+/**
+ * @brief The blit one pixel at a time: read the panel pixel, apply the
+ * op, write it back with ssd1306_pixel.
+ */
+static void baseline_blit(const ssd1306_bitmap_t *bitmap, int x, int y, ssd1306_rop_t rop) {
+    for (int i = 0; i < bitmap->width; ++i) {
+        for (int j = 0; j < bitmap->height; ++j) {
+            int px = x + i, py = y + j;
+            if (px < 0 || py < 0 || px >= SSD1306_WIDTH || py >= SSD1306_HEIGHT)
+                continue;
+            bool s = bitmap->data[i * bitmap->pages + j / 8] >> (j & 7) & 1;
+            bool d = get_pixel(px, py);
+            if (rop & SSD1306_ROP_INVERTED)
+                s = !s;
+            switch (rop & ~SSD1306_ROP_INVERTED) {
+            case SSD1306_ROP_COPY: d = s; break;
+            case SSD1306_ROP_OR: d = d || s; break;
+            case SSD1306_ROP_AND: d = d && s; break;
+            case SSD1306_ROP_XOR: d = d != s; break;
+            }
+            ssd1306_pixel(&ssd, (uint8_t)px, (uint8_t)py, d);
+        }
+    }
+}
+
+static void clear_dirty(void) {
+    memset(ssd.dirty_x0, 0xFF, sizeof(ssd.dirty_x0));
+    memset(ssd.dirty_x1, 0, sizeof(ssd.dirty_x1));
+}
+
+static ssd1306_bitmap_t random_bitmap(int width, int height) {
+    ssd1306_bitmap_t bitmap = {(uint8_t)width, (uint8_t)height, (uint8_t)((height + 7) / 8), bitmap_data};
+    for (size_t i = 0; i < (size_t)width * bitmap.pages; ++i)
+        bitmap_data[i] = (uint8_t)random_u32();
+    return bitmap;
+}
+
+static void check_random_blits(void) {
+    static uint8_t before[SSD1306_BUFSIZE], expected[SSD1306_BUFSIZE];
+    static const char *const names[] = {"copy", "or", "and", "xor",
+                                        "copy inverted", "or inverted", "and inverted", "xor inverted"};
+    int checked = 0;
+
+    for (int n = 0; n < CHECKS; ++n) {
+        ssd1306_bitmap_t bitmap = random_bitmap(random_in(1, MAX_SIZE), random_in(1, MAX_SIZE));
+        int x = random_in(-bitmap.width - 2, SSD1306_WIDTH + 2);
+        int y = random_in(-bitmap.height - 2, SSD1306_HEIGHT + 2);
+        ssd1306_rop_t rop = (ssd1306_rop_t)random_in(0, 7);
+        for (size_t i = 1; i < SSD1306_BUFSIZE; ++i)
+            ssd.ram_buffer[i] = (uint8_t)random_u32();
+
+        memcpy(before, ssd.ram_buffer, sizeof(before));
+        baseline_blit(&bitmap, x, y, rop);
+        memcpy(expected, ssd.ram_buffer, sizeof(expected));
+        memcpy(ssd.ram_buffer, before, sizeof(before));
+        clear_dirty();
+        ssd1306_blit(&ssd, &bitmap, (int16_t)x, (int16_t)y, rop);
+
+        bool same = memcmp(ssd.ram_buffer, expected, sizeof(expected)) == 0;
+        bool covered = true;
+        for (int px = 0; px < SSD1306_WIDTH; ++px)
+            for (int page = 0; page < SSD1306_PAGES; ++page) {
+                size_t index = 1 + page + px * SSD1306_PAGES;
+                if (ssd.ram_buffer[index] != before[index] &&
+                    (px < ssd.dirty_x0[page] || px > ssd.dirty_x1[page]))
+                    covered = false;
+            }
+        if (!same || !covered) {
+            if (failures < 5)
+                printf("FAIL %s of %dx%d at (%d, %d): %s\n", names[rop], bitmap.width, bitmap.height, x, y,
+                       same ? "changed pixels outside the dirty box" : "framebuffer differs from the baseline");
+            failures++;
+        }
+        checked++;
+    }
+    printf("checked         %d random blits, every op, across every edge\n", checked);
+}
+
+static double time_blits(void (*blit)(const ssd1306_bitmap_t *, int, int, ssd1306_rop_t),
+                         const ssd1306_bitmap_t *bitmap, int x, int y, ssd1306_rop_t rop) {
+    uint64_t best = UINT64_MAX;
+    for (int pass = 0; pass < PASSES; ++pass) {
+        uint64_t start = now_ns();
+        for (int round = 0; round < ROUNDS; ++round)
+            blit(bitmap, x, y, rop);
+        uint64_t elapsed = now_ns() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return (double)best / ROUNDS;
+}
+
+static void word_blit(const ssd1306_bitmap_t *bitmap, int x, int y, ssd1306_rop_t rop) {
+    ssd1306_blit(&ssd, bitmap, (int16_t)x, (int16_t)y, rop);
+}
+
+static void bench_throughput(void) {
+    static const struct {
+        int width, height;
+    } sizes[] = {{8, 8}, {16, 16}, {32, 32}, {SSD1306_WIDTH, SSD1306_HEIGHT - 8}};
+
+    printf("%-16s %-8s %-6s %10s %10s %9s %8s\n", "bitmap", "rows", "op", "blit ns", "pixel ns", "Mpixel/s",
+           "speedup");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        int width = sizes[s].width, height = sizes[s].height;
+        ssd1306_bitmap_t bitmap = random_bitmap(width, height);
+        for (int shifted = 0; shifted < 2; ++shifted) {
+            for (int xor = 0; xor < 2; ++xor) {
+                // Inside the panel, page-aligned or 3 rows down
+                int x = SSD1306_WIDTH - width, y = shifted ? 3 : 0;
+                ssd1306_rop_t rop = xor ? SSD1306_ROP_XOR : SSD1306_ROP_COPY;
+                double blit_ns = time_blits(word_blit, &bitmap, x, y, rop);
+                double pixel_ns = time_blits(baseline_blit, &bitmap, x, y, rop);
+                char name[16];
+                snprintf(name, sizeof(name), "%dx%d", width, height);
+                printf("%-16s %-8s %-6s %10.1f %10.1f %9.0f %7.1fx\n", name, shifted ? "+3" : "aligned",
+                       xor ? "xor" : "copy", blit_ns, pixel_ns, width * height / blit_ns * 1e3, pixel_ns / blit_ns);
+                if (blit_ns >= pixel_ns && width * height >= 256)
+                    fail("%s blit slower than per pixel", name);
+            }
+        }
+    }
+}
+
+int main(void) {
+    printf("geometry        %dx%d, %d pages\n", SSD1306_WIDTH, SSD1306_HEIGHT, SSD1306_PAGES);
+    check_random_blits();
+    bench_throughput();
+    return report_failures();
+}
@@ -0,0 +1,104 @@
+/**
+ * @file bench_flush.c
+ * @brief Measures the I2C traffic of the countdown screen on the mock bus.
+ *
+ * Renders a full 25 minute countdown through update_timer twice: once
+ * forcing a full-frame flush every second, as the driver used to do, and
+ * once with dirty-region flushing. After every partial flush the panel
+ * model is compared with the framebuffer to make sure nothing was lost.
+ *
+ * Bytes on the wire and transactions come from the mock bus and must
+ * match the driver's own counters. Bus time is given for 100 kHz,
+ * 400 kHz and 1 MHz: 9 clocks per byte plus START and STOP.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "../inc/ssd1306.h"
+#include "../src/display_status.h"
+#include "mock_i2c.h"
+
+ssd1306_t ssd;
+#if POMODORO_STATS_DISPLAY
+ssd1306_t ssd_aux; // display_status.c draws the statistics there
+#endif
+
+static bool panel_matches_framebuffer(void) {
+    return memcmp(mock_ssd1306_gddram(i2c1), ssd.ram_buffer + 1, SSD1306_BUFSIZE - 1) == 0;
+}
+
+typedef struct {
+    uint64_t bytes;
+    uint64_t transactions;
+} traffic_t;
+
+static const uint32_t speeds_hz[] = {100000, 400000, 1000000};
+
+static bool counters_match = true;
+static uint32_t driver_bytes, driver_transactions;
+
+static void start_counting(void) {
+    mock_i2c_reset_stats(i2c1);
+    driver_bytes = ssd.bytes_sent;
+    driver_transactions = ssd.transactions;
+}
+
+// What the mock bus saw, checked against the driver's counters, which
+// leave out the address byte of each transaction.
+static traffic_t stop_counting(void) {
+    const mock_i2c_stats_t *stats = mock_i2c_stats(i2c1);
+    traffic_t traffic = {stats->bytes, stats->transactions};
+    uint32_t transactions = ssd.transactions - driver_transactions;
+
+    if (transactions != traffic.transactions || ssd.bytes_sent - driver_bytes + transactions != traffic.bytes)
+        counters_match = false;
+    return traffic;
+}
+
+static double bus_ms(traffic_t traffic, uint32_t hz) {
+    return (traffic.bytes * 9.0 + traffic.transactions * 2.0) * 1000.0 / hz;
+}
+
+static void print_traffic(const char *name, traffic_t traffic, int frames) {
+    printf("%-8s %12.1f %12.2f", name, (double)traffic.bytes / frames, (double)traffic.transactions / frames);
+    for (size_t i = 0; i < sizeof(speeds_hz) / sizeof(speeds_hz[0]); ++i)
+        printf(" %9.3f", bus_ms(traffic, speeds_hz[i]) / frames);
+    printf("\n");
+}
+
+static traffic_t run_countdown(bool full_frames, bool *consistent) {
+    start_counting();
+    for (int t = 25 * 60 - 1; t >= 0; --t) {
+        if (full_frames)
+            ssd1306_invalidate(&ssd);
+        update_timer(t / 60, t % 60, false);
+        display_flush();
+        ssd1306_wait(&ssd);
+        if (!panel_matches_framebuffer())
+            *consistent = false;
+    }
+    return stop_counting();
+}
+
+int main(void) {
+    i2c_init(i2c1, 400 * 1000);
+    ssd1306_init(&ssd, false, 0x3C, i2c1);
+    start_counting();
+    ssd1306_config(&ssd);
+    traffic_t config = stop_counting();
+    ssd1306_send_data(&ssd);
+
+    bool consistent = true;
+    const int frames = 25 * 60;
+    traffic_t full = run_countdown(true, &consistent);
+    traffic_t partial = run_countdown(false, &consistent);
+
+    printf("%-8s %12s %12s %9s %9s %9s\n", "", "bytes/frame", "trans/frame", "ms@100k", "ms@400k", "ms@1M");
+    print_traffic("config", config, 1);
+    print_traffic("full", full, frames);
+    print_traffic("partial", partial, frames);
+    printf("saving: %.1f%%, panel %s framebuffer, driver counters %s mock bus\n",
+           100.0 * (1.0 - (double)partial.bytes / full.bytes), consistent ? "matches" : "DOES NOT match",
+           counters_match ? "match" : "DO NOT match");
+
+    return consistent && counters_match ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file bench_geometry.c
+ * @brief The driver specialised for one panel geometry: drawing and flush
+ * cost, memory, and the panel model checked after every flush.
+ *
+ * Built once per supported geometry (bench_geometry_128x64, _128x32 and
+ * _64x48), each with SSD1306_WIDTH and SSD1306_HEIGHT set and its own copy
+ * of the driver, so every framebuffer index is a constant of that
+ * geometry. The same workload runs on each: pixels, lines, filled boxes
+ * and text, some of it across the edges, then flushes. After every flush
+ * the GDDRAM of the mock panel, shifted by the column offset of the
+ * module, must equal the framebuffer.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "../inc/ssd1306.h"
+#include "../inc/font.h"
+#include "mock_i2c.h"
+
+#define ROUNDS 2000
+#define PASSES 5 ///< The fastest is kept, the others had the host scheduler in them
+
+ssd1306_t ssd;
+
+static bool panel_matches_framebuffer(void) {
+    const uint8_t *gddram = mock_ssd1306_gddram(i2c1);
+    for (uint8_t x = 0; x < SSD1306_WIDTH; ++x)
+        for (uint8_t page = 0; page < SSD1306_PAGES; ++page)
+            if (gddram[page + (x + SSD1306_COLUMN_OFFSET) * MOCK_SSD1306_PAGES] !=
+                ssd.ram_buffer[1 + page + x * SSD1306_PAGES])
+                return false;
+    return true;
+}
+
+static void flush_and_check(const char *what) {
+    ssd1306_send_data(&ssd);
+    if (!panel_matches_framebuffer())
+        fail("panel differs from the framebuffer after %s", what);
+}
+
+static void run_pixels(int round) {
+    for (uint8_t y = 0; y < SSD1306_HEIGHT; ++y)
+        for (uint8_t x = 0; x < SSD1306_WIDTH; ++x)
+            ssd1306_pixel(&ssd, x, y, (x ^ y ^ round) & 1);
+}
+
+static void run_lines(int round) {
+    for (uint8_t y = 0; y < SSD1306_HEIGHT; ++y)
+        ssd1306_hline(&ssd, 0, SSD1306_WIDTH - 1, y, (y + round) & 1);
+    for (uint8_t x = 0; x < SSD1306_WIDTH; ++x)
+        ssd1306_vline(&ssd, x, 0, SSD1306_HEIGHT - 1, (x + round) & 1);
+}
+
+// Boxes that also cross the right and bottom edges
+static void run_boxes(int round) {
+    for (uint8_t i = 0; i < 16; ++i)
+        ssd1306_rect(&ssd, (uint8_t)(i * 5 + round) % SSD1306_HEIGHT, (uint8_t)(i * 11 + round) % SSD1306_WIDTH,
+                     24, 20, (i + round) & 1, true);
+}
+
+static void run_text(int round) {
+    char text[8];
+    snprintf(text, sizeof(text), "%02d:%02d", round / 60 % 60, round % 60);
+    ssd1306_draw_text(&ssd, &font_8x8, text, 0, 0);
+    ssd1306_draw_text(&ssd, &font_8x8, text, 3, 13);
+    ssd1306_draw_text(&ssd, &font_16x16, text, 0, 16);
+}
+
+static void run_fill(int round) {
+    ssd1306_fill(&ssd, round & 1);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(int round);
+    uint32_t operations; ///< Per round, to report the cost of one
+} workload_t;
+
+static const workload_t workloads[] = {
+    {"pixel", run_pixels, SSD1306_WIDTH * SSD1306_HEIGHT},
+    {"hline+vline", run_lines, SSD1306_WIDTH + SSD1306_HEIGHT},
+    {"rect fill", run_boxes, 16},
+    {"draw_text", run_text, 3},
+    {"fill", run_fill, 1},
+};
+
+int main(void) {
+    i2c_init(i2c1, 400 * 1000);
+    ssd1306_init(&ssd, false, 0x3C, i2c1);
+    ssd1306_config(&ssd);
+    flush_and_check("init");
+
+    printf("geometry        %dx%d, %d pages, column offset %d\n", SSD1306_WIDTH, SSD1306_HEIGHT, SSD1306_PAGES,
+           SSD1306_COLUMN_OFFSET);
+    printf("memory          %zu bytes per panel (framebuffer %zu, shadow %zu, DMA words %zu)\n", sizeof(ssd1306_t),
+           sizeof(ssd.ram_buffer), sizeof(ssd.shadow_buffer), sizeof(ssd.front_buffer));
+    printf("%-16s %10s\n", "workload", "ns per op");
+    for (size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); ++w) {
+        uint64_t best = UINT64_MAX;
+        for (int pass = 0; pass < PASSES; ++pass) {
+            uint64_t elapsed = 0;
+            for (int round = 0; round < ROUNDS; ++round) {
+                uint64_t start = now_ns();
+                workloads[w].run(round);
+                elapsed += now_ns() - start;
+                // Checking every round would dominate the run; a sample is enough
+                if (round % 97 == 0)
+                    flush_and_check(workloads[w].name);
+            }
+            best = elapsed < best ? elapsed : best;
+        }
+        flush_and_check(workloads[w].name);
+        printf("%-16s %10.1f\n", workloads[w].name, (double)best / ROUNDS / workloads[w].operations);
+    }
+
+    // A whole frame and a single changed byte, on the wire
+    uint32_t before = ssd.bytes_sent;
+    ssd1306_invalidate(&ssd);
+    uint64_t start = now_ns();
+    flush_and_check("full frame");
+    double full_ns = (double)(now_ns() - start);
+    uint32_t full = ssd.bytes_sent - before;
+    before = ssd.bytes_sent;
+    ssd1306_pixel(&ssd, SSD1306_WIDTH - 1, SSD1306_HEIGHT - 1, !(ssd.ram_buffer[SSD1306_BUFSIZE - 1] & 0x80));
+    flush_and_check("one pixel");
+    printf("flush           %lu bytes full frame (%.0f ns to send), %lu for one pixel\n", (unsigned long)full,
+           full_ns, (unsigned long)(ssd.bytes_sent - before));
+
+    return report_failures();
+}
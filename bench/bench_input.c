@@ -0,0 +1,186 @@
+/**
+ * @file bench_input.c
+ * @brief Debouncer latency and event sequences against bouncing switches.
+ *
+ * The input subsystem runs on the virtual clock with the same main loop
+ * shape as the firmware: the GPIO IRQ notes edges, the loop feeds them to
+ * input_edge() and services the timer wheel. Recorded bounce waveforms are
+ * replayed on the pins, and each scenario checks the exact events that
+ * come out. Every press must be reported within 10 ms of its first edge.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "sim_clock.h"
+#include "bounce.h"
+#include "hardware/gpio.h"
+#include "hardware/timer.h"
+#include "../src/event_queue.h"
+#include "../src/input.h"
+
+#define BUTTON_A 5
+#define BUTTON_B 6
+#define BUTTON_JS 22
+#define MAX_EVENTS 64
+#define LATENCY_MAX_US 10000
+
+static timer_wheel_t timers;
+static input_t input;
+static event_queue_t queue;
+static input_event_t events[MAX_EVENTS];
+static int event_count;
+static int wake;
+static uint64_t wake_us;
+
+static const char *const type_names[] = {
+    [INPUT_PRESS] = "press",
+    [INPUT_RELEASE] = "release",
+    [INPUT_LONG_PRESS] = "long",
+    [INPUT_REPEAT] = "repeat",
+    [INPUT_CHORD] = "chord",
+};
+
+static void record(const input_event_t *event, void *data) {
+    if (event_count < MAX_EVENTS)
+        events[event_count++] = *event;
+}
+
+static void irq_handler(uint gpio, uint32_t edges) {
+    if (input_irq(&input, gpio))
+        event_queue_post(&queue, EVENT_BUTTON, (uint8_t)gpio);
+}
+
+static void nothing(void *context) {
+}
+
+// The firmware's loop, with a scheduler event standing in for the alarm
+static void main_loop(void) {
+    for (;;) {
+        event_t event;
+        while (event_queue_pop(&queue, &event))
+            input_edge(&input, event.arg, event.time_us);
+        timer_wheel_advance(&timers, time_us_64());
+
+        uint64_t next;
+        if (timer_wheel_next(&timers, &next) && next != wake_us) {
+            sim_cancel(wake);
+            wake_us = next;
+            wake = sim_schedule_at(next, nothing, NULL);
+        }
+        sim_step();
+    }
+}
+
+static uint64_t scenario_start(void) {
+    event_count = 0;
+    return time_us_64() + 100000;
+}
+
+static void run(void) {
+    sim_run(main_loop, UINT64_MAX);
+}
+
+/**
+ * @brief Compares the events with the expected "type:gpio" list and
+ * prints both on a mismatch.
+ */
+static void expect(const char *scenario, const char *expected) {
+    char got[512] = "";
+    for (int i = 0; i < event_count; ++i) {
+        char one[24];
+        snprintf(one, sizeof(one), "%s%s:%u", i ? " " : "", type_names[events[i].type], events[i].gpio);
+        strncat(got, one, sizeof(got) - strlen(got) - 1);
+    }
+    if (strcmp(got, expected))
+        fail("%s\n  expected %s\n  got      %s", scenario, expected, got);
+}
+
+static void press_release(uint gpio, const sim_bounce_t *press, const sim_bounce_t *release,
+                          uint64_t at_us, uint64_t held_us) {
+    sim_play_bounce(gpio, press, at_us);
+    sim_play_bounce(gpio, release, at_us + held_us);
+}
+
+static void check_waveforms(void) {
+    printf("%-14s %-14s %12s %12s\n", "press", "release", "press us", "release us");
+    for (int p = 0; p < sim_press_bounce_count; ++p) {
+        for (int r = 0; r < sim_release_bounce_count; ++r) {
+            uint64_t start = scenario_start();
+            press_release(BUTTON_A, &sim_press_bounces[p], &sim_release_bounces[r], start, 50000);
+            run();
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s press, %s release", sim_press_bounces[p].name,
+                     sim_release_bounces[r].name);
+            expect(name, "press:5 release:5");
+            if (event_count != 2)
+                continue;
+
+            uint64_t press_us = events[0].time_us - start;
+            uint64_t release_us = events[1].time_us - start - 50000;
+            printf("%-14s %-14s %12llu %12llu\n", sim_press_bounces[p].name, sim_release_bounces[r].name,
+                   (unsigned long long)press_us, (unsigned long long)release_us);
+            if (press_us > LATENCY_MAX_US || release_us > LATENCY_MAX_US)
+                fail("%s: slower than %u us", name, LATENCY_MAX_US);
+        }
+    }
+}
+
+static void check_scenarios(void) {
+    const sim_bounce_t *press = &sim_press_bounces[1], *release = &sim_release_bounces[1];
+    uint64_t start;
+
+    start = scenario_start();
+    sim_play_bounce(BUTTON_A, &sim_glitch, start);
+    run();
+    expect("glitch", "");
+
+    // B right after A was released: the old shared 300 ms window lost it
+    start = scenario_start();
+    press_release(BUTTON_A, press, release, start, 40000);
+    press_release(BUTTON_B, press, release, start + 60000, 40000);
+    run();
+    expect("A then B", "press:5 release:5 press:6 release:6");
+
+    // Held 2 s: long press at 0.6 s, then a repeat every 150 ms
+    start = scenario_start();
+    press_release(BUTTON_B, press, release, start, 2000000);
+    run();
+    expect("held 2 s", "press:6 long:6 repeat:6 repeat:6 repeat:6 repeat:6 repeat:6 repeat:6 "
+                       "repeat:6 repeat:6 repeat:6 release:6");
+
+    // The contacts chatter once while held
+    start = scenario_start();
+    press_release(BUTTON_A, press, release, start, 400000);
+    sim_play_bounce(BUTTON_A, &(sim_bounce_t){"dirty", (const sim_edge_t[]){{0, 1}, {30, 0}}, 2}, start + 200000);
+    run();
+    expect("chatter while held", "press:5 release:5");
+
+    // B, then the joystick 40 ms later while B is held, both held for 1 s
+    start = scenario_start();
+    press_release(BUTTON_B, press, release, start, 1000000);
+    press_release(BUTTON_JS, press, release, start + 40000, 1000000);
+    run();
+    expect("chord", "press:6 chord:22 release:6 release:22");
+    if (event_count > 1 && events[1].held != 0x6)
+        fail("chord: held 0x%x, expected 0x6", events[1].held);
+}
+
+int main(void) {
+    uint pins[] = {BUTTON_A, BUTTON_B, BUTTON_JS};
+
+    timer_wheel_init(&timers, time_us_64());
+    input_init(&input, &timers, record, NULL);
+    for (int i = 0; i < 3; ++i) {
+        gpio_init(pins[i]);
+        gpio_set_dir(pins[i], GPIO_IN);
+        gpio_pull_up(pins[i]);
+        input_add_button(&input, pins[i]);
+        gpio_set_irq_enabled_with_callback(pins[i], GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, irq_handler);
+    }
+
+    check_waveforms();
+    check_scenarios();
+    printf("bounces filtered: %lu\n", (unsigned long)input.bounces);
+    return report_failures();
+}
@@ -0,0 +1,261 @@
+/**
+ * @file bench_link.c
+ * @brief The binary USB protocol: codec cost, then a loopback against the
+ * simulator.
+ *
+ * The codec is checked on messages of every length (roundtrip, no zero
+ * byte inside a frame, a flipped bit rejected) and timed. Then the whole
+ * firmware is started with Pomodoro-Timer-sim --pty and driven through the
+ * host client library: the commands must change the timer as documented,
+ * the round-trip time of a ping is measured, the status stream must keep
+ * the requested rate, and pipelined pings give the throughput.
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench.h"
+#include "link_client.h"
+
+#define CODEC_ROUNDS 200000
+#define PINGS 2000
+#define PIPELINE 4       ///< Pings in flight during the throughput run
+#define THROUGHPUT_MS 1000
+#define STREAM_MS 2000
+#define STREAM_PERIOD_MS 5
+#define REPLY_TIMEOUT_MS 1000
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_codec(void) {
+    link_message_t message, decoded;
+    uint8_t wire[LINK_WIRE_MAX];
+
+    for (int length = 0; length <= LINK_PAYLOAD_MAX; ++length) {
+        // Zeros and 0xff alternate with counting bytes to stress the COBS runs
+        uint8_t payload[LINK_PAYLOAD_MAX];
+        for (int i = 0; i < length; ++i)
+            payload[i] = i % 3 == 0 ? 0x00 : i % 3 == 1 ? 0xff : (uint8_t)i;
+        link_message(&message, LINK_PING, (uint8_t)(length + 1), payload, (uint8_t)length);
+
+        size_t size = link_encode(&message, wire);
+        check(wire[0] == 0 && wire[size - 1] == 0 && memchr(wire + 1, 0, size - 2) == NULL, "zero inside a frame");
+        check(size <= LINK_WIRE_MAX, "frame longer than LINK_WIRE_MAX");
+        check(link_decode(wire + 1, size - 2, &decoded) && decoded.type == message.type &&
+                  decoded.seq == message.seq && decoded.length == message.length &&
+                  !memcmp(decoded.payload, message.payload, message.length),
+              "roundtrip");
+        for (size_t i = 1; i < size - 1; ++i) {
+            wire[i] ^= 0x10;
+            check(wire[i] == 0 || !link_decode(wire + 1, size - 2, &decoded), "corrupt frame accepted");
+            wire[i] ^= 0x10;
+        }
+    }
+
+    link_message(&message, LINK_PING, 1, wire, LINK_PAYLOAD_MAX);
+    uint64_t start = now_ns();
+    size_t bytes = 0;
+    for (int i = 0; i < CODEC_ROUNDS; ++i) {
+        message.seq = (uint8_t)i;
+        size_t size = link_encode(&message, wire);
+        bytes += size;
+        check(link_decode(wire + 1, size - 2, &decoded), "decode");
+    }
+    double ns = (double)(now_ns() - start);
+    printf("codec           %.0f ns per max-size message encoded and decoded, %.1f MB/s\n", ns / CODEC_ROUNDS,
+           bytes / ns * 1e3);
+}
+
+/**
+ * @brief Starts the simulator behind a pseudo-terminal.
+ *
+ * @param path At least 256 bytes, receives the terminal path.
+ * @return Its pid, -1 if it did not start.
+ */
+static pid_t start_sim(char *path) {
+    int out[2];
+    if (pipe(out))
+        return -1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(out[1], STDOUT_FILENO);
+        close(out[0]);
+        execl(SIM_PATH, SIM_PATH, "--pty", (char *)NULL);
+        _exit(127);
+    }
+    close(out[1]);
+
+    FILE *report = fdopen(out[0], "r");
+    char line[256];
+    path[0] = '\0';
+    while (fgets(line, sizeof(line), report))
+        if (sscanf(line, "pty %255s", path) == 1)
+            break;
+    fclose(report);
+    return path[0] ? pid : -1;
+}
+
+static bool status(link_client_t *client, link_status_t *s) {
+    link_message_t reply;
+    if (!link_client_command(client, LINK_GET_STATUS, NULL, 0, &reply, REPLY_TIMEOUT_MS) ||
+        reply.type != LINK_STATUS)
+        return false;
+    link_status_unpack(reply.payload, s);
+    return true;
+}
+
+static uint8_t command(link_client_t *client, uint8_t type, const void *payload, uint8_t length) {
+    link_message_t reply;
+    if (!link_client_command(client, type, payload, length, &reply, REPLY_TIMEOUT_MS) || reply.type != LINK_ACK ||
+        reply.payload[0] != type)
+        return 0xff;
+    return reply.payload[1];
+}
+
+static void bench_commands(link_client_t *client) {
+    link_status_t s;
+
+    check(command(client, LINK_SET_DURATIONS, (uint8_t[]){ 30, 7 }, 2) == LINK_OK, "set durations");
+    check(status(client, &s) && s.work_minutes == 30 && s.break_minutes == 7 && s.minutes == 30 &&
+              !(s.flags & LINK_STATUS_ON),
+          "durations in status");
+    check(command(client, LINK_SET_DURATIONS, (uint8_t[]){ 61, 7 }, 2) == LINK_BAD_VALUE, "work out of range");
+    check(command(client, LINK_SET_DURATIONS, (uint8_t[]){ 30 }, 1) == LINK_BAD_LENGTH, "short payload");
+    check(command(client, LINK_PAUSE, NULL, 0) == LINK_REJECTED, "pause while stopped");
+
+    check(command(client, LINK_START, NULL, 0) == LINK_OK, "start");
+    check(status(client, &s) && (s.flags & LINK_STATUS_RUNNING), "running after start");
+    check(command(client, LINK_START, NULL, 0) == LINK_REJECTED, "start while running");
+    check(command(client, LINK_SET_DURATIONS, (uint8_t[]){ 20, 5 }, 2) == LINK_REJECTED, "set while on");
+
+    check(command(client, LINK_PAUSE, NULL, 0) == LINK_OK, "pause");
+    check(status(client, &s) && !(s.flags & LINK_STATUS_RUNNING) && (s.flags & LINK_STATUS_ON), "paused");
+
+    check(command(client, LINK_RESET, NULL, 0) == LINK_OK, "reset");
+    check(status(client, &s) && !(s.flags & LINK_STATUS_ON) && s.minutes == 30 && s.seconds == 0,
+          "stopped after reset");
+    check(command(client, 0x7f, NULL, 0) == LINK_UNKNOWN, "unknown command");
+    check(command(client, LINK_SET_DURATIONS, (uint8_t[]){ 25, 5 }, 2) == LINK_OK, "restore durations");
+}
+
+static void bench_ping(link_client_t *client) {
+    static uint64_t rtt[PINGS];
+    link_message_t reply;
+    int lost = 0;
+
+    for (int i = 0; i < PINGS; ++i) {
+        uint8_t payload[8];
+        memcpy(payload, &i, sizeof(i));
+        uint64_t start = now_ns();
+        if (!link_client_command(client, LINK_PING, payload, sizeof(payload), &reply, REPLY_TIMEOUT_MS) ||
+            reply.type != LINK_PONG || memcmp(reply.payload, payload, sizeof(payload))) {
+            lost++;
+            rtt[i] = UINT64_MAX;
+            continue;
+        }
+        rtt[i] = now_ns() - start;
+    }
+    check(lost == 0, "pings lost");
+    qsort(rtt, PINGS, sizeof(rtt[0]), compare_u64);
+    printf("ping rtt        median %.1f us, p99 %.1f us, max %.1f us over %d\n", rtt[PINGS / 2] / 1e3,
+           rtt[PINGS * 99 / 100] / 1e3, rtt[PINGS - 1 - lost] / 1e3, PINGS);
+}
+
+static void bench_throughput(link_client_t *client) {
+    uint8_t payload[LINK_PAYLOAD_MAX] = { 0 };
+    link_message_t reply;
+    unsigned in_flight = 0, replies = 0;
+    uint64_t start = now_ns(), end = start + THROUGHPUT_MS * 1000000ull;
+
+    while (now_ns() < end) {
+        while (in_flight < PIPELINE) {
+            link_client_send(client, LINK_PING, payload, sizeof(payload));
+            in_flight++;
+        }
+        if (!link_client_poll(client, &reply, REPLY_TIMEOUT_MS))
+            break;
+        if (reply.type == LINK_PONG) {
+            in_flight--;
+            replies++;
+        }
+    }
+    while (in_flight > 0 && link_client_poll(client, &reply, REPLY_TIMEOUT_MS))
+        in_flight -= reply.type == LINK_PONG;
+    double s = (now_ns() - start) / 1e9;
+    check(in_flight == 0, "pipelined pings lost");
+
+    // Each exchange carries the payload both ways, framed
+    link_message_t message;
+    uint8_t wire[LINK_WIRE_MAX];
+    link_message(&message, LINK_PING, 1, payload, sizeof(payload));
+    size_t size = link_encode(&message, wire);
+    printf("throughput      %.0f pings/s with %d in flight, %.1f kB/s each way (%zu-byte frames)\n", replies / s,
+           PIPELINE, replies * size / s / 1e3, size);
+}
+
+static void bench_stream(link_client_t *client) {
+    link_message_t reply;
+    uint16_t period_ms = STREAM_PERIOD_MS;
+
+    check(command(client, LINK_SET_RATE, (uint8_t[]){ (uint8_t)period_ms, (uint8_t)(period_ms >> 8) }, 2) == LINK_OK,
+          "set rate");
+    unsigned received = 0;
+    uint32_t first_ms = 0, last_ms = 0;
+    uint64_t end = now_ns() + STREAM_MS * 1000000ull;
+    while (now_ns() < end && link_client_poll(client, &reply, REPLY_TIMEOUT_MS)) {
+        if (reply.type != LINK_STATUS || reply.seq != 0)
+            continue;
+        link_status_t s;
+        link_status_unpack(reply.payload, &s);
+        if (received++ == 0)
+            first_ms = s.uptime_ms;
+        last_ms = s.uptime_ms;
+    }
+    check(command(client, LINK_SET_RATE, (uint8_t[]){ 0, 0 }, 2) == LINK_OK, "stop stream");
+
+    double expected = STREAM_MS / (double)period_ms;
+    double spacing_ms = received > 1 ? (last_ms - first_ms) / (double)(received - 1) : 0;
+    printf("status stream   %u in %d ms at %d ms (expected %.0f), %.2f ms apart on the board\n", received, STREAM_MS,
+           period_ms, expected, spacing_ms);
+    check(received > expected * 0.9 && received < expected * 1.1, "status rate");
+
+    // The acknowledgement is the last word: nothing streams after it
+    bool quiet = true;
+    while (link_client_poll(client, &reply, 50))
+        quiet &= reply.seq != 0;
+    check(quiet, "stream not stopped");
+}
+
+int main(void) {
+    char path[256];
+    link_client_t client;
+
+    bench_codec();
+
+    pid_t pid = start_sim(path);
+    if (pid < 0 || !link_client_open(&client, path)) {
+        printf("FAIL cannot start %s --pty\n", SIM_PATH);
+        return 1;
+    }
+    printf("loopback        %s --pty on %s\n", SIM_PATH, path);
+
+    bench_commands(&client);
+    bench_ping(&client);
+    bench_throughput(&client);
+    bench_stream(&client);
+
+    link_status_t s;
+    check(status(&client, &s) && s.rx_errors == 0, "frames dropped by the board");
+    printf("board           %u frames in, %u dropped, %u out; client dropped %u\n", s.rx_frames, s.rx_errors,
+           s.tx_frames, client.rx_errors);
+
+    link_client_close(&client);
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    return report_failures();
+}
@@ -0,0 +1,215 @@
+/**
+ * @file bench_mirror.c
+ * @brief Framebuffer mirroring: bytes per frame and encoder cost.
+ *
+ * The screens of a whole session (start, adjustments, a 25-minute work
+ * period with a pause, a 5-minute break and the statistics) are drawn by
+ * display_render() and streamed by mirror.c. link_send() is replaced by a
+ * loopback through the wire codec into the host-side mirror_client, whose
+ * frame must match the framebuffer after every flush. The bytes per frame
+ * are compared with the raw 1 KB and with key frames only (RLE of each
+ * frame alone), and the encoder timed. Random frames check the codec and
+ * its worst case, and a dropped chunk must be recovered with a key frame.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "../inc/ssd1306.h"
+#include "../src/display_status.h"
+#include "../src/widget.h"
+#include "../src/mirror.h"
+#include "mirror_client.h"
+
+#define FRAME_SIZE (WIDTH * HEIGHT / 8)
+#define MAX_FRAMES 4096
+#define RANDOM_FRAMES 2000
+
+ssd1306_t ssd;
+#if POMODORO_STATS_DISPLAY
+ssd1306_t ssd_aux; // display_status.c draws the statistics there
+#endif
+static mirror_t mirror;
+static mirror_client_t client;
+static link_t link;
+static bool drop_next_chunk;
+static uint64_t wire_bytes, chunks;
+static uint32_t encode_ns[MAX_FRAMES];
+static uint32_t seed = 0x2545F491;
+
+static uint32_t next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/**
+ * @brief Loopback in place of the USB link: through the wire codec into
+ * the host-side client.
+ */
+void link_send(link_t *link, const link_message_t *message) {
+    uint8_t wire[LINK_WIRE_MAX];
+    link_message_t received;
+    size_t size = link_encode(message, wire);
+
+    wire_bytes += size;
+    chunks++;
+    if (drop_next_chunk) {
+        drop_next_chunk = false;
+        return;
+    }
+    check(link_decode(wire + 1, size - 2, &received), "wire decode");
+    if (mirror_client_take(&client, &received) == MIRROR_CLIENT_FRAME)
+        check(memcmp(client.frame, ssd.ram_buffer + 1, FRAME_SIZE) == 0, "mirrored frame differs");
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static struct {
+    int frames;
+    uint64_t delta_bytes, key_bytes;
+    size_t delta_max, key_max;
+    uint8_t reference[FRAME_SIZE];
+} session;
+
+/**
+ * @brief Draws a state, flushes it and mirrors it, as the main loop does.
+ */
+static void show(const display_state_t *state) {
+    uint8_t blank[FRAME_SIZE] = { 0 }, encoded[FB_DELTA_MAX(WIDTH, HEIGHT / 8)];
+
+    display_render(state);
+    if (!ssd1306_is_dirty(&ssd))
+        return;
+    ssd1306_send_data(&ssd);
+
+    const uint8_t *frame = ssd.ram_buffer + 1;
+    uint64_t start = now_ns();
+    size_t delta = fb_delta_encode(session.reference, frame, WIDTH, HEIGHT / 8, encoded);
+    uint64_t elapsed = now_ns() - start;
+    size_t key = fb_delta_encode(blank, frame, WIDTH, HEIGHT / 8, encoded);
+
+    if (session.frames < MAX_FRAMES)
+        encode_ns[session.frames] = (uint32_t)elapsed;
+    session.frames++;
+    session.delta_bytes += delta;
+    session.key_bytes += key;
+    session.delta_max = delta > session.delta_max ? delta : session.delta_max;
+    session.key_max = key > session.key_max ? key : session.key_max;
+    mirror_update(&mirror, true);
+}
+
+static void countdown(int period_minutes, bool on_break, int pause_at) {
+    display_state_t state = { .screen = SCREEN_COUNTDOWN, .on_break = on_break, .tenths = DISPLAY_TENTHS_OFF };
+    int total = period_minutes * 60;
+
+    for (int left = total; left >= 0; --left) {
+        state.minutes = (uint8_t)(left / 60);
+        state.seconds = (uint8_t)(left % 60);
+        state.progress = (uint16_t)((total - left) * UINT16_MAX / total);
+        state.paused = false;
+        show(&state);
+        if (left == pause_at) {
+            state.paused = true;
+            show(&state);
+        }
+    }
+}
+
+static void run_session(void) {
+    show(&(display_state_t){ .screen = SCREEN_INITIAL });
+    for (int m = 26; m <= 30; ++m)
+        show(&(display_state_t){ .screen = SCREEN_ADJUST_WORK, .minutes = (uint8_t)m });
+    show(&(display_state_t){ .screen = SCREEN_INITIAL });
+    countdown(25, false, 600);
+    countdown(5, true, -1);
+    show(&(display_state_t){ .screen = SCREEN_STATS, .today_completed = 1, .today_minutes = 25,
+                             .week_completed = 9, .week_started = 11, .week_minutes = 231 });
+}
+
+/**
+ * @brief Random frames, dense and sparse, through the codec alone.
+ */
+static void run_random(void) {
+    static uint8_t reference[FRAME_SIZE], decoded[FRAME_SIZE], frame[FRAME_SIZE];
+    uint8_t encoded[FB_DELTA_MAX(WIDTH, HEIGHT / 8)];
+    size_t worst = 0;
+
+    for (int i = 0; i < RANDOM_FRAMES; ++i) {
+        // Every density from a few changed bytes to all of them, and runs
+        uint32_t density = next_random() % 256;
+        for (int j = 0; j < FRAME_SIZE; ++j) {
+            if (next_random() % 256 < density)
+                frame[j] = (uint8_t)(i % 3 == 0 ? next_random() : next_random() % 3);
+        }
+        size_t length = fb_delta_encode(reference, frame, WIDTH, HEIGHT / 8, encoded);
+        worst = length > worst ? length : worst;
+        check(length <= sizeof(encoded), "encoded past FB_DELTA_MAX");
+        check(fb_delta_decode(decoded, WIDTH, HEIGHT / 8, encoded, length), "random decode");
+        check(memcmp(decoded, frame, FRAME_SIZE) == 0 && memcmp(reference, frame, FRAME_SIZE) == 0,
+              "random roundtrip");
+    }
+    printf("random frames   %d roundtrips, longest %zu bytes (bound %zu)\n", RANDOM_FRAMES, worst,
+           (size_t)FB_DELTA_MAX(WIDTH, HEIGHT / 8));
+
+    encoded[0] = 0x7F;
+    check(!fb_delta_decode(decoded, WIDTH, HEIGHT / 8, encoded, 9), "overrun accepted");
+    encoded[0] = 0xC3;
+    check(!fb_delta_decode(decoded, WIDTH, HEIGHT / 8, encoded, 2), "truncated literal accepted");
+}
+
+/**
+ * @brief A chunk lost on the way: the client must notice, and a new key
+ * frame must bring it back in step.
+ */
+static void run_loss(void) {
+    uint32_t lost = client.lost;
+    drop_next_chunk = true;
+    show(&(display_state_t){ .screen = SCREEN_INITIAL });
+    show(&(display_state_t){ .screen = SCREEN_ADJUST_BREAK, .minutes = 7 });
+    check(client.lost > lost && !client.valid, "lost chunk not detected");
+
+    mirror_enable(&mirror, true);
+    mirror_update(&mirror, false);
+    check(client.valid && memcmp(client.frame, ssd.ram_buffer + 1, FRAME_SIZE) == 0, "no recovery after a loss");
+}
+
+int main(void) {
+    i2c_init(i2c1, 400 * 1000);
+    ssd1306_init(&ssd, false, 0x3C, i2c1);
+    ssd1306_send_data(&ssd);
+
+    mirror_init(&mirror, &link, ssd.ram_buffer + 1);
+    mirror_client_init(&client);
+    mirror_enable(&mirror, true);
+    mirror_update(&mirror, false);
+    run_session();
+    check(client.frames == mirror.frames && client.lost == 0, "frames lost in the session");
+
+    int frames = session.frames;
+    int timed = frames < MAX_FRAMES ? frames : MAX_FRAMES;
+    qsort(encode_ns, (size_t)timed, sizeof(encode_ns[0]), compare_u32);
+    printf("session         %d frames of %d bytes\n", frames, FRAME_SIZE);
+    printf("%-15s %10s %10s %10s\n", "encoding", "avg B", "max B", "of raw");
+    printf("%-15s %10d %10d %9.1f%%\n", "raw", FRAME_SIZE, FRAME_SIZE, 100.0);
+    printf("%-15s %10.1f %10zu %9.1f%%\n", "key frames", (double)session.key_bytes / frames, session.key_max,
+           100.0 * session.key_bytes / frames / FRAME_SIZE);
+    printf("%-15s %10.1f %10zu %9.1f%%\n", "xor delta", (double)session.delta_bytes / frames, session.delta_max,
+           100.0 * session.delta_bytes / frames / FRAME_SIZE);
+    printf("%-15s %10.1f %10s %9.1f%%\n", "on the wire", (double)wire_bytes / mirror.frames, "",
+           100.0 * wire_bytes / mirror.frames / FRAME_SIZE);
+    printf("chunks          %.2f per frame\n", (double)chunks / mirror.frames);
+    printf("encoder         median %lu ns, p99 %lu ns, max %lu ns per frame\n",
+           (unsigned long)encode_ns[timed / 2], (unsigned long)encode_ns[timed * 99 / 100],
+           (unsigned long)encode_ns[timed - 1]);
+    check(session.delta_bytes / frames < FRAME_SIZE / 10, "delta not a small fraction of the raw frame");
+
+    run_random();
+    run_loss();
+    printf("memory          %zu bytes on the board\n", sizeof(mirror_t));
+    return report_failures();
+}
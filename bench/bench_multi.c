@@ -0,0 +1,149 @@
+/**
+ * @file bench_multi.c
+ * @brief Two panels on the two I2C controllers: refresh time with the
+ * transfers one after the other and side by side.
+ *
+ * One panel shows a large countdown, the other statistics that change
+ * with it, like the POMODORO_STATS_DISPLAY build. A 25 minute countdown
+ * is drawn three times from blank panels: the countdown panel alone, both
+ * panels flushed one after the other, and both started at once, each on
+ * its own bus and DMA channel. Time is the virtual time until both
+ * transfers have left the bus.
+ *
+ * Side by side, every frame must take no longer than the slower of its two
+ * transfers. After every frame each panel model must equal its own
+ * framebuffer, each bus must carry exactly the bytes of its own driver,
+ * and no write may start on a bus still held by a DMA transfer.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "../inc/ssd1306.h"
+#include "../inc/font.h"
+#include "hardware/timer.h"
+#include "mock_i2c.h"
+
+#define FRAMES (25 * 60)
+
+typedef struct {
+    ssd1306_t ssd;
+    i2c_inst_t *i2c;
+    const char *name;
+    uint32_t bytes, transactions; ///< Driver counters at the start of a pass
+} panel_t;
+
+static panel_t countdown = { .name = "countdown" }, stats = { .name = "stats" };
+static uint32_t countdown_us[FRAMES], stats_us[FRAMES];
+
+static void check_at(bool ok, const char *what, int frame) {
+    if (!ok)
+        fail("%s at frame %d", what, frame);
+}
+
+static bool panel_matches_framebuffer(const panel_t *panel) {
+    return memcmp(mock_ssd1306_gddram(panel->i2c), panel->ssd.ram_buffer + 1, SSD1306_BUFSIZE - 1) == 0;
+}
+
+static void draw_countdown(int left) {
+    char text[8];
+    snprintf(text, sizeof(text), "%02d:%02d", left / 60, left % 60);
+    ssd1306_draw_text(&countdown.ssd, &font_7seg, text, (WIDTH - 5 * font_7seg.width) / 2, 24);
+    ssd1306_rect(&countdown.ssd, 48, 10, (uint8_t)((WIDTH - 20) * (FRAMES - left) / FRAMES), 8, true, true);
+}
+
+// Totals that move with the countdown, so both panels change every frame
+static void draw_stats(int left) {
+    char text[WIDTH / 8 + 1];
+    int done = FRAMES - left;
+    snprintf(text, sizeof(text), "Today %4dm %02ds", 100 + done / 60, done % 60);
+    ssd1306_draw_string(&stats.ssd, text, 0, 8);
+    snprintf(text, sizeof(text), "Week  %4dm %02ds", 1200 + done / 60, done % 60);
+    ssd1306_draw_string(&stats.ssd, text, 0, 24);
+}
+
+static uint32_t wait_idle(void) {
+    uint64_t start = time_us_64();
+    ssd1306_wait(&countdown.ssd);
+    ssd1306_wait(&stats.ssd);
+    return (uint32_t)(time_us_64() - start);
+}
+
+static void start_pass(panel_t *panel) {
+    ssd1306_fill(&panel->ssd, false);
+    ssd1306_invalidate(&panel->ssd);
+    ssd1306_send_data(&panel->ssd);
+    mock_i2c_reset_stats(panel->i2c);
+    panel->bytes = panel->ssd.bytes_sent;
+    panel->transactions = panel->ssd.transactions;
+}
+
+// The bus carried this driver's bytes and nothing else, with no overlap
+static void check_bus(const panel_t *panel) {
+    const mock_i2c_stats_t *bus = mock_i2c_stats(panel->i2c);
+    uint32_t transactions = panel->ssd.transactions - panel->transactions;
+    check(bus->transactions == transactions && bus->bytes == panel->ssd.bytes_sent - panel->bytes + transactions,
+          panel->name);
+    check(bus->overlaps == 0, "overlapping writes");
+}
+
+typedef enum { ALONE, SEQUENTIAL, PARALLEL } pass_mode_t;
+
+static uint64_t run_pass(pass_mode_t mode) {
+    uint64_t total_us = 0;
+
+    start_pass(&countdown);
+    start_pass(&stats);
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        int left = FRAMES - 1 - frame;
+        draw_countdown(left);
+        if (mode != ALONE)
+            draw_stats(left);
+
+        uint32_t us;
+        if (mode == PARALLEL) {
+            ssd1306_send_data_async(&stats.ssd);
+            ssd1306_send_data_async(&countdown.ssd);
+            us = wait_idle();
+            uint32_t slower = countdown_us[frame] > stats_us[frame] ? countdown_us[frame] : stats_us[frame];
+            check_at(us <= slower, "side by side slower than the slower panel", frame);
+        } else {
+            ssd1306_send_data_async(&countdown.ssd);
+            countdown_us[frame] = us = wait_idle();
+            if (mode == SEQUENTIAL) {
+                ssd1306_send_data_async(&stats.ssd);
+                stats_us[frame] = wait_idle();
+                us += stats_us[frame];
+            }
+        }
+        total_us += us;
+
+        check_at(panel_matches_framebuffer(&countdown), "countdown panel differs", frame);
+        if (mode != ALONE)
+            check_at(panel_matches_framebuffer(&stats), "stats panel differs", frame);
+    }
+    check_bus(&countdown);
+    if (mode != ALONE)
+        check_bus(&stats);
+    return total_us;
+}
+
+int main(void) {
+    countdown.i2c = i2c1;
+    stats.i2c = i2c0;
+    i2c_init(countdown.i2c, 400 * 1000);
+    i2c_init(stats.i2c, 400 * 1000);
+    ssd1306_init(&countdown.ssd, false, 0x3C, countdown.i2c);
+    ssd1306_init(&stats.ssd, false, 0x3C, stats.i2c);
+    ssd1306_config(&countdown.ssd);
+    ssd1306_config(&stats.ssd);
+
+    double alone = run_pass(ALONE) / 1e3 / FRAMES;
+    double sequential = run_pass(SEQUENTIAL) / 1e3 / FRAMES;
+    double parallel = run_pass(PARALLEL) / 1e3 / FRAMES;
+
+    printf("panels          countdown on i2c1, stats on i2c0, 400 kHz, %d frames\n", FRAMES);
+    printf("one panel       %.3f ms per frame\n", alone);
+    printf("one after other %.3f ms per frame (%.2fx one panel)\n", sequential, sequential / alone);
+    printf("side by side    %.3f ms per frame (%.2fx one panel)\n", parallel, parallel / alone);
+    return report_failures();
+}
@@ -0,0 +1,174 @@
+/**
+ * @file bench_pipeline.c
+ * @brief Stress test of the core0 -> core1 display pipeline with two threads.
+ *
+ * display_status.c is built with POMODORO_MULTICORE, as in the firmware.
+ * One thread plays core0 and publishes display states with display_show(),
+ * far faster than any button. The other runs display_core1_main(), which
+ * takes the latest state, draws it and sends it over the mock bus. __wfe()
+ * is core1_wfe() here: it yields, and ends the thread once core0 is done.
+ *
+ * Every state is first drawn and sent on one thread, as single-core input
+ * handling would, to time it and to keep a hash of the frame it makes.
+ * The paused flag depends on both digits, so a frame core1 sends from a
+ * mix of two writes matches none of them and counts as a bad frame. The
+ * cost of display_show() is what input handling pays for the display in
+ * the multicore build.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bench.h"
+#include "../inc/ssd1306.h"
+#include "../src/display_status.h"
+#include "../src/hardware_init.h"
+#include "../src/trace_record.h"
+#include "../src/widget.h"
+
+#define PUBLISHES 200000
+#define PUBLISH_PERIOD_NS 10000 ///< Far more often than buttons ever press
+#define STATES 7200             ///< Distinct states, two hours of countdown
+
+typedef struct {
+    uint32_t hash;
+    uint32_t number;
+} frame_t;
+
+ssd1306_t ssd;
+
+static frame_t frames[STATES];          ///< Hash of each state's frame, sorted
+static uint64_t published_at[PUBLISHES];
+static volatile uint32_t published;     ///< States handed to display_show() so far
+static volatile bool writer_done;
+
+static uint32_t publish_ns[PUBLISHES];
+static uint32_t staleness_ns[PUBLISHES];
+static uint32_t render_ns[STATES];
+static uint32_t renders;
+static uint32_t bad_frames;
+
+// State number v: a countdown whose paused flag is tied to both digits.
+static display_state_t state_for(uint32_t v) {
+    uint8_t minutes = (v / 60) % 60, seconds = v % 60;
+    return (display_state_t){
+        .screen = SCREEN_COUNTDOWN,
+        .minutes = minutes,
+        .seconds = seconds,
+        .tenths = DISPLAY_TENTHS_OFF,
+        .on_break = (v / 3600) & 1,
+        .paused = (minutes ^ seconds) & 1,
+    };
+}
+
+static int compare_frames(const void *a, const void *b) {
+    uint32_t x = ((const frame_t *)a)->hash, y = ((const frame_t *)b)->hash;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Flush callback, on core1 once each frame is on the panel: finds
+ * the state it shows and how long ago that state was published.
+ */
+static void check_frame(ssd1306_t *display, void *data) {
+    uint64_t end = now_ns();
+    frame_t key = {trace_hash(display->ram_buffer + 1, SSD1306_BUFSIZE - 1), 0};
+    const frame_t *frame = bsearch(&key, frames, STATES, sizeof(frames[0]), compare_frames);
+    if (!frame) {
+        bad_frames++;
+        return;
+    }
+
+    // The latest publish of that state; core1 lags far less than STATES behind
+    uint32_t last = published - 1;
+    uint32_t v = last - (last + STATES - frame->number) % STATES;
+    staleness_ns[renders++] = (uint32_t)(end - published_at[v]);
+}
+
+// Core1 sets the panel up in the firmware; here main() has, so it only
+// starts from a blank screen and checks every frame after that.
+void init_display(void) {
+    ssd1306_fill(&ssd, false);
+    ssd1306_send_data(&ssd);
+    widget_invalidate();
+    ssd1306_set_flush_callback(&ssd, check_frame, NULL);
+}
+
+// __wfe() of display_core1_main(), renamed by the build
+void core1_wfe(void) {
+    if (writer_done)
+        pthread_exit(NULL);
+    sched_yield();
+}
+
+static void *core0(void *arg) {
+    uint64_t due = now_ns();
+    for (uint32_t v = 0; v < PUBLISHES; ++v, due += PUBLISH_PERIOD_NS) {
+        display_state_t state = state_for(v % STATES);
+        struct timespec wake = {(time_t)(due / 1000000000u), (long)(due % 1000000000u)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+        uint64_t start = now_ns();
+        published_at[v] = start;
+        published = v + 1;
+        display_show(&state);
+        publish_ns[v] = (uint32_t)(now_ns() - start);
+    }
+    while (display_busy())
+        sched_yield();
+    writer_done = true;
+    return NULL;
+}
+
+static void *core1(void *arg) {
+    display_core1_main();
+    return NULL;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_stats(const char *name, uint32_t *samples, uint32_t count) {
+    qsort(samples, count, sizeof(samples[0]), compare_u32);
+    printf("%-26s %10lu %10lu\n", name, (unsigned long)samples[count / 2],
+           (unsigned long)samples[(uint64_t)count * 99 / 100]);
+}
+
+int main(void) {
+    i2c_init(i2c1, 400 * 1000);
+    ssd1306_init(&ssd, false, 0x3C, i2c1);
+    ssd1306_config(&ssd);
+    ssd1306_send_data(&ssd);
+
+    // What single-core input handling waits for, and the frame of each state
+    for (uint32_t v = 0; v < STATES; ++v) {
+        display_state_t state = state_for(v);
+        uint64_t start = now_ns();
+        display_render(&state);
+        ssd1306_send_data(&ssd);
+        render_ns[v] = (uint32_t)(now_ns() - start);
+        frames[v] = (frame_t){trace_hash(ssd.ram_buffer + 1, SSD1306_BUFSIZE - 1), v};
+    }
+    qsort(frames, STATES, sizeof(frames[0]), compare_frames);
+
+    pthread_t writer, reader;
+    uint64_t start = now_ns();
+    pthread_create(&reader, NULL, core1, NULL);
+    pthread_create(&writer, NULL, core0, NULL);
+    pthread_join(writer, NULL);
+    pthread_join(reader, NULL);
+    double seconds = (now_ns() - start) * 1e-9;
+
+    printf("%u states published, %lu drawn (%.0f%% coalesced) in %.2f s\n", PUBLISHES,
+           (unsigned long)renders, 100.0 * (1.0 - (double)renders / PUBLISHES), seconds);
+    printf("%-26s %10s %10s\n", "", "median ns", "p99 ns");
+    print_stats("core0 display_show", publish_ns, PUBLISHES);
+    print_stats("single-core draw + flush", render_ns, STATES);
+    print_stats("publish to panel", staleness_ns, renders);
+    printf("torn or mismatched frames: %lu\n", (unsigned long)bad_frames);
+
+    return bad_frames == 0 && renders > 0 ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+/**
+ * @file bench_replay.c
+ * @brief Input traces: a recorded session replayed on the simulator, as a
+ * regression check and as a benchmark.
+ *
+ * A scripted session with random alarm latency is recorded with
+ * Pomodoro-Timer-sim --record, then replayed with --replay: every record
+ * must come back, frame hashes included, and the replay is timed against
+ * the session it stands for. A copy with one frame hash altered must fail
+ * at that very record.
+ *
+ * Then the firmware is started with --pty and one client asks for the
+ * trace over the link and drives the timer, the way pomodoro-ctl trace
+ * would on a board. The records streamed must be the first ones the
+ * simulator wrote to its own file, and must replay as well.
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench.h"
+#include "link_client.h"
+#include "../src/trace_record.h"
+
+#define STREAM_HOURS "0.0015" ///< Length of the --pty session, 5.4 s
+#define REPLY_TIMEOUT_MS 1000
+
+static char dir[] = "/tmp/bench_replay_XXXXXX";
+
+static const char *temp_path(const char *name) {
+    static char paths[4][64];
+    static int next;
+    char *path = paths[next++ % 4];
+    snprintf(path, sizeof(paths[0]), "%s/%s", dir, name);
+    return path;
+}
+
+/**
+ * @brief Runs the simulator to completion.
+ *
+ * @param args Its arguments, NULL-terminated.
+ * @param report Receives its report, at least 2 KB.
+ * @param wall_s Receives the wall-clock time of the run.
+ * @return Its exit status, -1 if it did not run.
+ */
+static int run_sim(const char *const *args, char *report, double *wall_s) {
+    const char *argv[16] = { SIM_PATH };
+    for (int i = 0; args[i] && i < 14; ++i)
+        argv[i + 1] = args[i];
+
+    int out[2];
+    if (pipe(out))
+        return -1;
+    uint64_t start = now_ns();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(out[1], STDOUT_FILENO);
+        close(out[0]);
+        execv(SIM_PATH, (char *const *)argv);
+        _exit(127);
+    }
+    close(out[1]);
+
+    size_t length = 0;
+    ssize_t n;
+    while ((n = read(out[0], report + length, 2047 - length)) > 0)
+        length += (size_t)n;
+    report[length] = '\0';
+    close(out[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+    *wall_s = (now_ns() - start) * 1e-9;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static long file_size(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+static void bench_scripted(void) {
+    const char *recorded = temp_path("session.trace");
+    char report[2048];
+    double record_s, replay_s, simulated = 0;
+    unsigned long matched = 0, total = 0, frames = 0;
+
+    int rc = run_sim((const char *[]){ "--work", "5", "--break", "1", "--cycles", "3", "--latency", "3000",
+                                       "--record", recorded, NULL },
+                     report, &record_s);
+    check(rc == 0, "recording a scripted session");
+    const char *line = strstr(report, "simulated");
+    if (line)
+        sscanf(line, "simulated %lf", &simulated);
+
+    rc = run_sim((const char *[]){ "--replay", recorded, NULL }, report, &replay_s);
+    check(rc == 0, "replay of a recorded session");
+    line = strstr(report, "replay");
+    if (line)
+        sscanf(line, "replay %lu of %lu records matched, %lu frames", &matched, &total, &frames);
+    check(matched == total && total > 0, "records missing from the replay");
+    check(strstr(report, "times within 0 us") != NULL, "replayed times differ from the recorded ones");
+    long size = file_size(recorded);
+    printf("session         3 cycles of 5 + 1 min, 3 ms alarm latency: %lu records, %lu frames, %ld bytes "
+           "(%.0f B per minute)\n", total, frames, size, size / (simulated / 60));
+    printf("replay          %.1f s of session in %.3f s (%.0fx real time), recording %.3f s\n", simulated, replay_s,
+           simulated / replay_s, record_s);
+
+    // One frame hash altered, halfway: the replay must stop right there
+    FILE *f = fopen(recorded, "rb");
+    uint8_t *trace = malloc((size_t)size);
+    if (!f || fread(trace, 1, (size_t)size, f) != (size_t)size) {
+        check(false, "reading the trace back");
+        return;
+    }
+    fclose(f);
+    long altered = -1;
+    for (long i = size / TRACE_RECORD_SIZE / 2; i < size / TRACE_RECORD_SIZE && altered < 0; ++i) {
+        trace_record_t record;
+        trace_unpack(&trace[i * TRACE_RECORD_SIZE], &record);
+        if (record.type == TRACE_FRAME) {
+            record.value ^= 1;
+            trace_pack(&record, &trace[i * TRACE_RECORD_SIZE]);
+            altered = i;
+        }
+    }
+    const char *corrupt = temp_path("altered.trace");
+    f = fopen(corrupt, "wb");
+    fwrite(trace, 1, (size_t)size, f);
+    fclose(f);
+    free(trace);
+
+    rc = run_sim((const char *[]){ "--replay", corrupt, NULL }, report, &replay_s);
+    long at = -1;
+    line = strstr(report, "FAIL");
+    if (line)
+        sscanf(line, "FAIL record %ld", &at);
+    check(rc == 1 && at == altered, "altered frame not caught where it was altered");
+    printf("altered frame   record %ld, replay stopped at %ld\n", altered, at);
+}
+
+static pid_t start_sim(const char *record, char *path) {
+    int out[2];
+    if (pipe(out))
+        return -1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(out[1], STDOUT_FILENO);
+        close(out[0]);
+        execl(SIM_PATH, SIM_PATH, "--pty", "--hours", STREAM_HOURS, "--record", record, (char *)NULL);
+        _exit(127);
+    }
+    close(out[1]);
+
+    FILE *report = fdopen(out[0], "r");
+    char line[256];
+    path[0] = '\0';
+    while (fgets(line, sizeof(line), report))
+        if (sscanf(line, "pty %255s", path) == 1)
+            break;
+    fclose(report);
+    return path[0] ? pid : -1;
+}
+
+/**
+ * @brief Keeps the streamed records, in order, until the board has been
+ * quiet for timeout_ms.
+ */
+static void receive(link_client_t *client, FILE *out, uint32_t *records, int timeout_ms) {
+    link_message_t message;
+    while (link_client_poll(client, &message, timeout_ms)) {
+        if (message.type != LINK_TRACE)
+            continue;
+        uint32_t index = message.payload[0] | message.payload[1] << 8 | message.payload[2] << 16 |
+                         (uint32_t)message.payload[3] << 24;
+        uint32_t count = (message.length - LINK_TRACE_HEADER) / TRACE_RECORD_SIZE;
+        check(index == *records, "streamed records out of order");
+        check(!(message.payload[4] & LINK_TRACE_LOST), "streamed records lost");
+        fwrite(&message.payload[LINK_TRACE_HEADER], TRACE_RECORD_SIZE, count, out);
+        *records = index + count;
+    }
+}
+
+static void bench_stream(void) {
+    const char *recorded = temp_path("pty.trace"), *streamed = temp_path("streamed.trace");
+    char path[256];
+    link_client_t client;
+
+    pid_t pid = start_sim(recorded, path);
+    if (pid < 0 || !link_client_open(&client, path)) {
+        check(false, "starting the simulator with --pty");
+        return;
+    }
+
+    // Commands go out without waiting for their acknowledgement, which
+    // would drop the records streamed meanwhile
+    FILE *out = fopen(streamed, "wb");
+    uint32_t records = 0;
+    link_client_send(&client, LINK_SET_TRACE, (uint8_t[]){ 1 }, 1);
+    link_client_send(&client, LINK_SET_DURATIONS, (uint8_t[]){ 1, 1 }, 2);
+    link_client_send(&client, LINK_START, NULL, 0);
+    receive(&client, out, &records, 1500);
+    link_client_send(&client, LINK_PAUSE, NULL, 0);
+    receive(&client, out, &records, REPLY_TIMEOUT_MS);
+    fclose(out);
+    link_client_close(&client);
+    waitpid(pid, NULL, 0);
+
+    // What came over the link is what the simulator saw, up to where it
+    // stopped streaming
+    long size = file_size(streamed), full = file_size(recorded);
+    bool prefix = size > 0 && full >= size;
+    FILE *a = fopen(streamed, "rb"), *b = fopen(recorded, "rb");
+    for (long i = 0; prefix && i < size; ++i)
+        prefix = fgetc(a) == fgetc(b);
+    if (a)
+        fclose(a);
+    if (b)
+        fclose(b);
+    check(prefix, "streamed trace differs from the simulator's");
+
+    char report[2048];
+    double replay_s;
+    int rc = run_sim((const char *[]){ "--replay", streamed, NULL }, report, &replay_s);
+    check(rc == 0, "replay of the streamed trace");
+    const char *line = strstr(report, "replay");
+    printf("streamed        %lu records over the link, %ld recorded by the simulator\n", (unsigned long)records,
+           full / TRACE_RECORD_SIZE);
+    if (line)
+        printf("%.*s", (int)(strchr(line, '\n') - line + 1), line);
+    if ((line = strstr(report, "ahead")))
+        printf("%.*s", (int)(strchr(line, '\n') - line + 1), line);
+    if ((line = strstr(report, "FAIL")))
+        printf("%.*s", (int)(strchr(line, '\n') - line + 1), line);
+}
+
+int main(void) {
+    if (!mkdtemp(dir)) {
+        perror(dir);
+        return 1;
+    }
+    bench_scripted();
+    bench_stream();
+
+    const char *names[] = { "session.trace", "altered.trace", "pty.trace", "streamed.trace" };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+        remove(temp_path(names[i]));
+    rmdir(dir);
+    return report_failures();
+}
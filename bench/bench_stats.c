@@ -0,0 +1,128 @@
+/**
+ * @file bench_stats.c
+ * @brief Incremental statistics against a full rescan, over a simulated month.
+ *
+ * Periods of random length, with random pauses and early stops, follow
+ * each other for 30 days with idle gaps of up to a day. After every period
+ * the daily and weekly totals kept by stats.c must equal the ones
+ * recomputed from the whole history. The cost of a query is compared with
+ * a rescan of the record ring, and the memory of the subsystem printed.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "../src/stats.h"
+
+#define RUN_DAYS 30
+#define MAX_PERIODS 20000
+#define QUERIES 100000
+
+static stats_t stats;
+static stats_record_t history[MAX_PERIODS];
+static int periods;
+static uint32_t seed = 0x2545F491;
+
+static uint32_t next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/**
+ * @brief The totals of days first..last, from every record ever added.
+ */
+static stats_totals_t rescan(const stats_record_t *records, int count, uint32_t first, uint32_t last) {
+    stats_totals_t totals = { 0 };
+    for (int i = 0; i < count; ++i) {
+        const stats_record_t *r = &records[i];
+        uint32_t day = r->start_s / STATS_DAY_S;
+        if (day < first || day > last)
+            continue;
+        if (r->phase == STATS_WORK) {
+            totals.started++;
+            totals.completed += r->actual_s >= r->planned_s;
+            totals.work_s += r->actual_s;
+        } else {
+            totals.breaks++;
+            totals.break_s += r->actual_s;
+        }
+        totals.pauses += r->pauses;
+        totals.paused_s += r->paused_s;
+    }
+    return totals;
+}
+
+static void compare(const char *what, const stats_totals_t *kept, const stats_totals_t *expected, uint64_t now_us) {
+    if (memcmp(kept, expected, sizeof(*kept)) == 0)
+        return;
+    fail("%s at %.1f h: kept %u/%u work %lu s, expected %u/%u work %lu s", what, now_us / 3.6e9,
+         kept->completed, kept->started, (unsigned long)kept->work_s, expected->completed, expected->started,
+         (unsigned long)expected->work_s);
+}
+
+/**
+ * @brief Runs one period through the same calls as the firmware, with
+ * up to two pauses and one chance in five of being stopped early.
+ */
+static uint64_t run_period(uint64_t now_us, stats_phase_t phase) {
+    uint32_t planned_s = phase == STATS_WORK ? 60 * (1 + next_random() % 60) : 60 * (1 + next_random() % 30);
+    uint64_t left_us = planned_s * 1000000ull;
+
+    stats_begin(&stats, phase, planned_s, now_us);
+    for (uint32_t pauses = next_random() % 3; pauses > 0; --pauses) {
+        uint64_t run_us = next_random() % (left_us / 2 + 1);
+        now_us += run_us;
+        left_us -= run_us;
+        stats_pause(&stats, now_us);
+        now_us += (next_random() % 600) * 1000000ull;
+        stats_resume(&stats, now_us);
+    }
+    if (next_random() % 5 == 0) {
+        now_us += next_random() % left_us;
+        stats_end(&stats, false, now_us);
+    } else {
+        now_us += left_us;
+        stats_end(&stats, true, now_us);
+    }
+    history[periods++] = *stats_record(&stats, 0);
+    return now_us;
+}
+
+int main(void) {
+    uint64_t now_us = 0, end_us = RUN_DAYS * (uint64_t)STATS_DAY_S * 1000000;
+
+    stats_init(&stats);
+    while (now_us < end_us && periods < MAX_PERIODS - 1) {
+        now_us = run_period(now_us, STATS_WORK);
+        now_us = run_period(now_us, STATS_BREAK);
+        if (next_random() % 8 == 0)
+            now_us += (next_random() % STATS_DAY_S) * 1000000ull;
+
+        uint32_t day = (uint32_t)(now_us / 1000000 / STATS_DAY_S);
+        stats_totals_t today = rescan(history, periods, day, day);
+        stats_totals_t week = rescan(history, periods, day < STATS_DAYS ? 0 : day - STATS_DAYS + 1, day);
+        compare("today", stats_today(&stats, now_us), &today, now_us);
+        compare("week", stats_week(&stats, now_us), &week, now_us);
+    }
+
+    // Query cost: the kept totals against a rescan of the ring
+    uint64_t start = now_ns();
+    uint32_t sink = 0;
+    for (int i = 0; i < QUERIES; ++i)
+        sink += stats_week(&stats, now_us)->completed;
+    double query_ns = (double)(now_ns() - start) / QUERIES;
+
+    start = now_ns();
+    uint32_t day = (uint32_t)(now_us / 1000000 / STATS_DAY_S);
+    for (int i = 0; i < QUERIES; ++i)
+        sink += rescan(stats.records, STATS_RECORDS, day - STATS_DAYS + 1, day).completed;
+    double rescan_ns = (double)(now_ns() - start) / QUERIES;
+
+    printf("periods         %d over %d days\n", periods, RUN_DAYS);
+    printf("week query      %.1f ns kept, %.1f ns rescanning %d records (%u)\n", query_ns, rescan_ns,
+           STATS_RECORDS, sink & 1);
+    printf("memory          %zu bytes (%d records of %zu bytes, %d days of %zu bytes)\n", sizeof(stats_t),
+           STATS_RECORDS, sizeof(stats_record_t), STATS_DAYS, sizeof(stats_totals_t));
+    return report_failures();
+}
@@ -0,0 +1,197 @@
+/**
+ * @file bench_store.c
+ * @brief Recovery time, wear spread and power-cut safety of the flash store.
+ *
+ * Runs the store against the RAM flash image of the simulator:
+ * - recovery: boot with a full sector to replay; must take under 1 ms on
+ *   the host, a few ms on the RP2040.
+ * - wear: thousands of syncs; erases must be spread evenly over the ring
+ *   and never touch flash outside it.
+ * - stall: the longest a sync keeps the flash busy, against what
+ *   flash_store_sync_us() says beforehand; in the second half of the wear
+ *   run the erase is done ahead by flash_store_prepare(), so no sync may
+ *   take longer than FLASH_STORE_APPEND_MAX_US.
+ * - power cuts: a cut at every record boundary of an append and of a
+ *   compaction; after reboot each value must be the old or the new one,
+ *   and the store must keep working.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "mock_flash.h"
+#include "../src/flash_store.h"
+
+#define WEAR_SYNCS 20000
+#define RECOVERY_MAX_NS 1000000
+
+static flash_store_t store;
+
+static void set_settings(uint8_t work, uint8_t rest) {
+    store_settings_t settings = { work, rest };
+    flash_store_set(&store, STORE_SETTINGS, &settings, sizeof(settings));
+}
+
+static void set_sessions(uint32_t completed) {
+    store_sessions_t sessions = { completed, completed * 25 };
+    flash_store_set(&store, STORE_SESSIONS, &sessions, sizeof(sessions));
+}
+
+static bool settings_are(const flash_store_t *s, uint8_t work, uint8_t rest) {
+    store_settings_t settings;
+    return flash_store_get(s, STORE_SETTINGS, &settings, sizeof(settings)) &&
+           settings.work_minutes == work && settings.break_minutes == rest;
+}
+
+static bool sessions_are(const flash_store_t *s, uint32_t completed) {
+    store_sessions_t sessions;
+    return flash_store_get(s, STORE_SESSIONS, &sessions, sizeof(sessions)) &&
+           sessions.completed == completed && sessions.work_minutes == completed * 25;
+}
+
+static void check_roundtrip(void) {
+    mock_flash_reset();
+    flash_store_init(&store, FLASH_STORE_OFFSET);
+    check(!settings_are(&store, 25, 5), "blank flash has no settings");
+
+    set_settings(40, 10);
+    set_sessions(3);
+    check(flash_store_sync(&store), "first sync");
+    flash_store_t booted;
+    flash_store_init(&booted, FLASH_STORE_OFFSET);
+    check(settings_are(&booted, 40, 10) && sessions_are(&booted, 3), "values survive a reboot");
+
+    // Setting the same value again writes nothing
+    uint32_t programs = mock_flash_stats()->programs;
+    set_settings(40, 10);
+    check(!flash_store_pending(&store) && flash_store_sync(&store) &&
+          mock_flash_stats()->programs == programs, "unchanged value is not written");
+}
+
+static void check_recovery(void) {
+    mock_flash_reset();
+    flash_store_init(&store, FLASH_STORE_OFFSET);
+    uint32_t last = 0;
+    do {
+        set_sessions(++last);
+        flash_store_sync(&store);
+    } while (store.next_slot < FLASH_STORE_SLOTS);
+
+    uint64_t best = UINT64_MAX;
+    flash_store_t booted;
+    for (int run = 0; run < 20; ++run) {
+        uint64_t start = now_ns();
+        flash_store_init(&booted, FLASH_STORE_OFFSET);
+        uint64_t ns = now_ns() - start;
+        if (ns < best)
+            best = ns;
+    }
+    printf("recovery        %u records replayed in %.1f us\n", booted.next_slot - 1, best / 1e3);
+    check(booted.next_slot == FLASH_STORE_SLOTS && sessions_are(&booted, last),
+          "full sector replayed");
+    check(best < RECOVERY_MAX_NS, "recovery under 1 ms");
+}
+
+static void check_wear(void) {
+    mock_flash_reset();
+    flash_store_init(&store, FLASH_STORE_OFFSET);
+
+    uint64_t worst_us = 0, prepared_us = 0;
+    for (uint32_t i = 0; i < WEAR_SYNCS; ++i) {
+        bool prepared = i >= WEAR_SYNCS / 2;
+        if (i % 7 == 0)
+            set_settings((uint8_t)(1 + i % 60), (uint8_t)(1 + i % 30));
+        set_sessions(i);
+        uint64_t busy = mock_flash_stats()->busy_us, predicted = flash_store_sync_us(&store);
+        flash_store_sync(&store);
+        uint64_t us = mock_flash_stats()->busy_us - busy;
+        if (us > predicted)
+            fail("sync %u took %lu us, %lu predicted", i, (unsigned long)us, (unsigned long)predicted);
+        if (us > worst_us)
+            worst_us = us;
+        if (prepared && us > prepared_us)
+            prepared_us = us;
+        if (prepared)
+            check(flash_store_prepare(&store) && !flash_store_prepare_us(&store), "prepare");
+    }
+
+    const mock_flash_stats_t *stats = mock_flash_stats();
+    uint32_t first = FLASH_STORE_OFFSET / FLASH_SECTOR_SIZE, least = UINT32_MAX, most = 0, outside = stats->erases;
+    for (uint32_t s = first; s < first + FLASH_STORE_SECTORS; ++s) {
+        least = stats->sector_erases[s] < least ? stats->sector_erases[s] : least;
+        most = stats->sector_erases[s] > most ? stats->sector_erases[s] : most;
+        outside -= stats->sector_erases[s];
+    }
+    printf("wear            %u syncs: %lu programs, %lu erases, %lu-%lu per sector\n", WEAR_SYNCS,
+           (unsigned long)stats->programs, (unsigned long)stats->erases, (unsigned long)least,
+           (unsigned long)most);
+    printf("stall           worst sync %.1f ms (limit %.1f ms), %.1f ms erased ahead (limit %.1f ms)\n",
+           worst_us / 1e3, FLASH_STORE_SYNC_MAX_US / 1e3, prepared_us / 1e3, FLASH_STORE_APPEND_MAX_US / 1e3);
+    check(most - least <= 1, "erases spread evenly over the ring");
+    check(outside == 0, "nothing erased outside the ring");
+    check(worst_us <= FLASH_STORE_SYNC_MAX_US, "sync within FLASH_STORE_SYNC_MAX_US");
+    check(prepared_us <= FLASH_STORE_APPEND_MAX_US, "sync after prepare within FLASH_STORE_APPEND_MAX_US");
+
+    flash_store_t booted;
+    flash_store_init(&booted, FLASH_STORE_OFFSET);
+    check(sessions_are(&booted, WEAR_SYNCS - 1), "last value after the ring wrapped");
+}
+
+/**
+ * @brief Cuts the power at every record boundary of one sync and checks
+ * what a reboot finds.
+ *
+ * @param compact Fill the sector first, so the sync compacts.
+ */
+static void check_cuts(bool compact) {
+    const char *name = compact ? "cut during compaction" : "cut during append";
+    int cuts = 0;
+
+    for (uint32_t bytes = 0;; bytes += FLASH_STORE_RECORD_SIZE) {
+        mock_flash_reset();
+        flash_store_init(&store, FLASH_STORE_OFFSET);
+        set_settings(25, 5);
+        set_sessions(1);
+        flash_store_sync(&store);
+        uint32_t old_sessions = 1;
+        while (compact && store.next_slot < FLASH_STORE_SLOTS) {
+            set_sessions(++old_sessions);
+            flash_store_sync(&store);
+        }
+
+        set_settings(50, 15);
+        set_sessions(old_sessions + 1);
+        mock_flash_cut_after(bytes);
+        flash_store_sync(&store);
+        bool cut = mock_flash_cut();
+        mock_flash_power_on();
+
+        flash_store_t booted;
+        flash_store_init(&booted, FLASH_STORE_OFFSET);
+        if (!(settings_are(&booted, 25, 5) || settings_are(&booted, 50, 15)) ||
+            !(sessions_are(&booted, old_sessions) || sessions_are(&booted, old_sessions + 1))) {
+            fail("%s after %u bytes: values lost", name, bytes);
+        }
+
+        // The store carries on from whatever it found
+        store = booted;
+        set_settings(30, 7);
+        set_sessions(1000);
+        flash_store_sync(&store);
+        flash_store_init(&booted, FLASH_STORE_OFFSET);
+        if (!settings_are(&booted, 30, 7) || !sessions_are(&booted, 1000))
+            fail("%s after %u bytes: store broken afterwards", name, bytes);
+        if (!cut)
+            break;
+        cuts++;
+    }
+    printf("%-15s %d cut points\n", compact ? "compaction" : "append", cuts);
+}
+
+int main(void) {
+    check_roundtrip();
+    check_recovery();
+    check_wear();
+    check_cuts(false);
+    check_cuts(true);
+    return report_failures();
+}
@@ -0,0 +1,303 @@
+/**
+ * @file bench_suite.c
+ * @brief Timing of the ssd1306 primitives and of every screen composition.
+ *
+ * The same cases build for the host, against the mock bus and the virtual
+ * clock, and for the RP2040, where each iteration is timed with the
+ * SysTick cycle counter and the table is printed over stdio. Each case
+ * draws something different on every iteration; the changes are flushed
+ * outside the timed section so the I2C bytes they cost can be reported.
+ * A case's setup runs, and may flush, before the timed section.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "../inc/ssd1306.h"
+#include "../inc/font.h"
+#include "../src/hardware_init.h"
+#include "../src/display_status.h"
+#include "../src/widget.h"
+#include "../src/fb_delta.h"
+#include "../src/trace_record.h"
+#include "../src/tone_sequence.h"
+
+#if BENCH_ON_TARGET
+#include "pico/stdio_usb.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#else
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#define BENCH_ITERATIONS 1001
+
+typedef struct {
+    const char *name;
+    void (*setup)(int i); ///< Untimed preparation, may be NULL
+    void (*run)(int i);   ///< The timed section
+} bench_case_t;
+
+extern ssd1306_t ssd;
+void adjust_time(bool is_work_time);
+
+static uint32_t samples[BENCH_ITERATIONS];
+
+#if BENCH_ON_TARGET
+static void bench_clock_init(void) {
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // processor clock, no interrupt
+}
+
+// SysTick counts down from 2^24, which at 125 MHz is 134 ms: far longer
+// than any case, so one wrap at most has to be handled.
+static inline uint32_t bench_now(void) {
+    return systick_hw->cvr;
+}
+
+static inline uint32_t bench_elapsed_ns(uint32_t start, uint32_t end) {
+    uint32_t cycles = (start - end) & 0x00FFFFFF;
+    return (uint32_t)((uint64_t)cycles * 1000000000u / clock_get_hz(clk_sys));
+}
+
+// adjust_time() logs to stdio; keep it off the results.
+static void bench_quiet(bool quiet) {
+    stdio_set_driver_enabled(&stdio_usb, !quiet);
+}
+#else
+static void bench_clock_init(void) {
+}
+
+static inline uint32_t bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+
+static inline uint32_t bench_elapsed_ns(uint32_t start, uint32_t end) {
+    return end - start;
+}
+
+static void bench_quiet(bool quiet) {
+    static int saved = -1;
+    fflush(stdout);
+    if (quiet) {
+        int null = open("/dev/null", O_WRONLY);
+        saved = dup(STDOUT_FILENO);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    } else if (saved >= 0) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+        saved = -1;
+    }
+}
+#endif
+
+static void run_fill(int i) {
+    ssd1306_fill(&ssd, i & 1);
+}
+
+static void run_pixel(int i) {
+    ssd1306_pixel(&ssd, i % WIDTH, (i / WIDTH) % HEIGHT, !((i / (WIDTH * HEIGHT)) & 1));
+}
+
+static void run_hline(int i) {
+    ssd1306_hline(&ssd, 0, WIDTH - 1, i % HEIGHT, (i / HEIGHT) & 1);
+}
+
+static void run_vline(int i) {
+    ssd1306_vline(&ssd, i % WIDTH, 0, HEIGHT - 1, (i / WIDTH) & 1);
+}
+
+static void run_line(int i) {
+    ssd1306_line(&ssd, 0, i % HEIGHT, WIDTH - 1, HEIGHT - 1 - i % HEIGHT, (i / HEIGHT) & 1);
+}
+
+static void run_rect(int i) {
+    ssd1306_rect(&ssd, i % 32, i % 64, 64, 32, (i / 32) & 1, false);
+}
+
+static void run_rect_fill(int i) {
+    ssd1306_rect(&ssd, i % 32, i % 64, 64, 32, (i / 32) & 1, true);
+}
+
+static void run_char(int i) {
+    ssd1306_draw_char(&ssd, '0' + i % 10, 8 * (i % 16), 13);
+}
+
+static void run_string(int i) {
+    ssd1306_draw_string(&ssd, i & 1 ? "Pomodoro Timer" : "Break time set", 10, 10);
+}
+
+static void run_text_16(int i) {
+    char text[8];
+    snprintf(text, sizeof(text), "%02d:%02d", i / 60 % 60, i % 60);
+    ssd1306_draw_text(&ssd, &font_16x16, text, 24, 24);
+}
+
+// A 16x16 glyph as a bitmap, XORed 3 rows off a page boundary
+static void run_blit(int i) {
+    ssd1306_bitmap_t glyph = {16, 16, 2, font_glyph(&font_16x16, (char)('0' + i % 10))};
+    ssd1306_blit(&ssd, &glyph, (int16_t)(i % (WIDTH - 16)), 19, SSD1306_ROP_XOR);
+}
+
+static void run_initial_display(int i) {
+    initial_display();
+}
+
+// Comes back from the countdown screen, as after the inactivity timeout
+static void setup_initial_display(int i) {
+    update_timer(i / 60 % 60, i % 60, false);
+    ssd1306_send_data(&ssd);
+}
+
+static void run_update_timer(int i) {
+    int t = 1499 - i % 1500;
+    update_timer(t / 60, t % 60, false);
+}
+
+static void run_adjust_time(int i) {
+    adjust_time(i & 1);
+}
+
+static void setup_flush(int i) {
+    run_update_timer(i);
+}
+
+static void run_flush(int i) {
+    display_flush();
+    ssd1306_wait(&ssd);
+}
+
+// One frame of the countdown animation at 30 fps: the bar moves every
+// frame, the digits once a second
+static void run_animation_frame(int i) {
+    int total = 1500 * 30, left = total - i % total;
+    display_render(&(display_state_t){
+        .screen = SCREEN_COUNTDOWN,
+        .minutes = (uint8_t)(left / 30 / 60),
+        .seconds = (uint8_t)(left / 30 % 60),
+#if POMODORO_TENTHS
+        .tenths = (uint8_t)(left % 30 / 3),
+#else
+        .tenths = DISPLAY_TENTHS_OFF,
+#endif
+        .progress = (uint16_t)((total - left) * UINT16_MAX / total),
+    });
+}
+
+static uint8_t mirror_reference[WIDTH * HEIGHT / 8];
+static uint8_t mirror_encoded[FB_DELTA_MAX(WIDTH, HEIGHT / 8)];
+
+// The framebuffer mirror encoding a countdown screen from scratch
+static void setup_mirror_key(int i) {
+    run_update_timer(i);
+    memset(mirror_reference, 0, sizeof(mirror_reference));
+}
+
+static void run_mirror(int i) {
+    fb_delta_encode(mirror_reference, ssd.ram_buffer + 1, WIDTH, HEIGHT / 8, mirror_encoded);
+}
+
+// And one tick of it, against the previous frame
+static void setup_mirror_tick(int i) {
+    run_update_timer(i);
+}
+
+static volatile uint32_t frame_hash;
+
+// The hash the input trace keeps of each frame sent
+static void run_trace_hash(int i) {
+    frame_hash = trace_hash(ssd.ram_buffer + 1, WIDTH * HEIGHT / 8);
+}
+
+static tone_schedule_t tone_schedule;
+static uint32_t tone_registers[2];
+
+// Expanding an alert before DMA plays it
+static void run_tone_schedule(int i) {
+    tone_schedule_build(&tone_schedule, i & 1 ? &tone_work_done : &tone_break_done, 1, tone_registers);
+}
+
+static const bench_case_t cases[] = {
+    {"fill", NULL, run_fill},
+    {"pixel", NULL, run_pixel},
+    {"hline", NULL, run_hline},
+    {"vline", NULL, run_vline},
+    {"line", NULL, run_line},
+    {"rect", NULL, run_rect},
+    {"rect fill", NULL, run_rect_fill},
+    {"draw_char", NULL, run_char},
+    {"draw_string", NULL, run_string},
+    {"draw_text 16x16", NULL, run_text_16},
+    {"blit 16x16 xor", NULL, run_blit},
+    {"initial_display", setup_initial_display, run_initial_display},
+    {"update_timer", NULL, run_update_timer},
+    {"adjust_time", NULL, run_adjust_time},
+    {"flush update_timer", setup_flush, run_flush},
+    {"animation frame", NULL, run_animation_frame},
+    {"mirror key frame", setup_mirror_key, run_mirror},
+    {"mirror tick", setup_mirror_tick, run_mirror},
+    {"trace frame hash", setup_mirror_tick, run_trace_hash},
+    {"tone schedule", NULL, run_tone_schedule},
+};
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void run_case(const bench_case_t *c) {
+    ssd1306_fill(&ssd, false);
+    ssd1306_send_data(&ssd);
+    widget_invalidate();
+
+    uint64_t bytes = 0;
+    bench_quiet(true);
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        if (c->setup)
+            c->setup(i);
+        uint32_t sent = ssd.bytes_sent;
+        uint32_t start = bench_now();
+        c->run(i);
+        samples[i] = bench_elapsed_ns(start, bench_now());
+        ssd1306_send_data(&ssd);
+        bytes += ssd.bytes_sent - sent;
+    }
+    bench_quiet(false);
+
+    qsort(samples, BENCH_ITERATIONS, sizeof(samples[0]), compare_u32);
+    printf("%-20s %10lu %10lu %10.1f\n", c->name,
+           (unsigned long)samples[BENCH_ITERATIONS / 2],
+           (unsigned long)samples[BENCH_ITERATIONS * 99 / 100],
+           (double)bytes / BENCH_ITERATIONS);
+}
+
+static void run_suite(void) {
+    printf("%-20s %10s %10s %10s\n", "case", "median ns", "p99 ns", "i2c B/it");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+        run_case(&cases[i]);
+}
+
+int main(void) {
+    stdio_init_all();
+    init_display();
+    bench_clock_init();
+
+#if BENCH_ON_TARGET
+    // Repeat the table so a terminal attached late still sees it
+    while (true) {
+        while (!stdio_usb_connected())
+            sleep_ms(100);
+        run_suite();
+        sleep_ms(10000);
+    }
+#else
+    run_suite();
+    return 0;
+#endif
+}
@@ -0,0 +1,235 @@
+/**
+ * @file bench_tone.c
+ * @brief Buzzer alerts: the schedules DMA follows, what the buzzer plays
+ * from them, and the cost of building one.
+ *
+ * The period of every note is checked against equal temperament, and
+ * every tick of the built-in sequences against the step it must copy.
+ * Then each sequence plays on the mock PWM and DMA while the core sleeps
+ * in __wfe() until an alarm set after its end. The core must not wake
+ * before it, the buzzer must take each new step within one period of the
+ * note it replaces from the start of its tick, and it must end silent.
+ */
+#include <stdio.h>
+#include "bench.h"
+#include "sim_clock.h"
+#include "mock_pwm.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "../src/hardware_init.h"
+#include "../src/tone.h"
+
+#define PERIOD_ERROR_MAX 0.001 ///< 0.1%, under 2 cents
+#define SEMITONE 1.0594630943592953
+#define C2_HZ 65.40639132514966
+#define ROUNDS 100000
+#define MAX_CHANGES 64
+#define TICK_COUNT_NS (TONE_TICK_DIV * 1000000000ull / TONE_SYS_HZ) ///< One count of the pacing slice
+
+typedef struct {
+    uint64_t time_ns;
+    mock_pwm_slice_t state;
+} change_t;
+
+static uint buzzer_slice;
+static change_t changes[MAX_CHANGES];
+static int change_count;
+static const tone_sequence_t *playing;
+static uint64_t play_us, wake_us, woke_us;
+static int wakeups;
+static bool busy_after;
+
+static void check_periods(void) {
+    double expected = C2_HZ, worst = 0;
+    int worst_note = 0;
+
+    for (int note = TONE_NOTE_MIN; note <= TONE_NOTE_MAX; ++note, expected *= SEMITONE) {
+        double hz = (double)TONE_CLOCK_HZ / tone_period((uint8_t)note);
+        double error = hz > expected ? hz / expected - 1 : 1 - hz / expected;
+        if (error > worst) {
+            worst = error;
+            worst_note = note;
+        }
+    }
+    printf("periods         notes %d to %d, worst error %.3f%% at note %d\n", TONE_NOTE_MIN, TONE_NOTE_MAX,
+           worst * 100, worst_note);
+    if (worst > PERIOD_ERROR_MAX)
+        fail("note %d is %.3f%% off", worst_note, worst * 100);
+}
+
+/**
+ * @brief Builds the schedule of a sequence and checks the step of each
+ * tick, note by note.
+ */
+static void check_schedule(const char *name, const tone_sequence_t *sequence) {
+    static tone_schedule_t schedule;
+    static uint32_t cc_register[2];
+    uint32_t top = 0xFFFF;
+    uint16_t tick = 0;
+
+    if (!tone_schedule_build(&schedule, sequence, PWM_CHAN_B, cc_register)) {
+        fail("%s: not built", name);
+        return;
+    }
+    for (uint8_t i = 0; i < sequence->count; ++i) {
+        const tone_note_t *note = &sequence->notes[i];
+        uint32_t cc = 0;
+        if (note->note) {
+            top = tone_period(note->note) - 1u;
+            cc = ((top + 1) * sequence->volume >> 8) << 16;
+        }
+        for (uint8_t t = 0; t < note->ticks; ++t, ++tick) {
+            const tone_block_t *block = &schedule.blocks[tick];
+            if (block->write != cc_register || block->read->cc != cc || block->read->top != top) {
+                fail("%s: tick %u copies cc %08lx top %lu, expected cc %08lx top %lu", name, tick,
+                     (unsigned long)block->read->cc, (unsigned long)block->read->top, (unsigned long)cc,
+                     (unsigned long)top);
+                return;
+            }
+        }
+    }
+    const tone_block_t *last = &schedule.blocks[tick];
+    if (schedule.length != tick || last->write != cc_register || last->read->cc != 0 || last->read->top != top)
+        fail("%s: %u ticks, not ending in silence after %u", name, schedule.length, tick);
+    printf("schedule        %-12s %2u notes, %3u ticks\n", name, sequence->count, schedule.length);
+}
+
+static void check_rejected(void) {
+    static tone_schedule_t schedule;
+    static uint32_t cc_register[2];
+    static const tone_note_t low[] = {{TONE_NOTE_MIN - 1, 1}};
+    static const tone_note_t high[] = {{TONE_NOTE_MAX + 1, 1}};
+    static const tone_note_t longest[] = {{60, TONE_MAX_TICKS / 2}, {0, TONE_MAX_TICKS / 2}};
+    static const tone_note_t too_long[] = {{60, TONE_MAX_TICKS / 2}, {0, TONE_MAX_TICKS / 2}, {60, 1}};
+    static tone_note_t many[TONE_MAX_NOTES + 1];
+    const struct {
+        const char *name;
+        tone_sequence_t sequence;
+        bool fits;
+    } cases[] = {
+        {"note below the range", {low, 1, 128}, false},
+        {"note above the range", {high, 1, 128}, false},
+        {"longest sequence", {longest, 2, 128}, true},
+        {"one tick too long", {too_long, 3, 128}, false},
+        {"most notes", {many, TONE_MAX_NOTES, 128}, true},
+        {"one note too many", {many, TONE_MAX_NOTES + 1, 128}, false},
+    };
+
+    for (int i = 0; i <= TONE_MAX_NOTES; ++i)
+        many[i] = (tone_note_t){(uint8_t)(TONE_NOTE_MIN + i), 1};
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        if (tone_schedule_build(&schedule, &cases[i].sequence, PWM_CHAN_B, cc_register) != cases[i].fits)
+            fail("%s %s", cases[i].name, cases[i].fits ? "rejected" : "accepted");
+    }
+}
+
+static void watch(uint slice, uint64_t time_ns, const mock_pwm_slice_t *state) {
+    if (slice == buzzer_slice && change_count < MAX_CHANGES)
+        changes[change_count++] = (change_t){time_ns, *state};
+}
+
+static void nothing(void *context) {
+}
+
+// The firmware's part: start the alert and sleep until the alarm after it
+static void play(void) {
+    play_us = time_us_64();
+    tone_play(playing);
+    wake_us = play_us + (TONE_MAX_TICKS + 2) * TONE_TICK_US;
+    sim_schedule_at(wake_us, nothing, NULL);
+    __wfe();
+    wakeups++;
+    woke_us = time_us_64();
+    busy_after = tone_busy();
+}
+
+static uint64_t period_ns(uint32_t top) {
+    return (top + 1ull) * TONE_CLOCK_DIV * 1000000000ull / TONE_SYS_HZ;
+}
+
+/**
+ * @brief Plays a sequence on the mock and checks each change of the
+ * buzzer against the step of its tick. The control block of tick k is
+ * complete on the second wrap of the pacing slice for it, half a tick in.
+ */
+static void check_playback(const char *name, const tone_sequence_t *sequence) {
+    static tone_schedule_t expected;
+    static uint32_t cc_register[2];
+    tone_step_t effect = {mock_pwm_slice(buzzer_slice)->cc, mock_pwm_slice(buzzer_slice)->top};
+    uint64_t latest_ns = 0;
+    int c = 0;
+
+    tone_schedule_build(&expected, sequence, PWM_CHAN_B, cc_register);
+    playing = sequence;
+    change_count = 0;
+    wakeups = 0;
+    sim_run(play, UINT64_MAX);
+
+    if (wakeups != 1 || woke_us != wake_us)
+        fail("%s: the core woke at %llu us, the alarm was at %llu us", name,
+             (unsigned long long)woke_us, (unsigned long long)wake_us);
+    if (busy_after)
+        fail("%s: still playing at the alarm", name);
+
+    for (uint16_t tick = 0; tick <= expected.length; ++tick) {
+        const tone_step_t *step = expected.blocks[tick].read;
+        if (step->cc == effect.cc && step->top == effect.top)
+            continue;
+        uint64_t start_ns = play_us * 1000 + TICK_COUNT_NS + (2 * tick + 1) * TONE_TICK_US * 1000 / 2;
+        uint64_t limit_ns = start_ns + period_ns(effect.top);
+        if (c == change_count) {
+            fail("%s: the buzzer never took the step of tick %u", name, tick);
+            return;
+        }
+        const change_t *change = &changes[c++];
+        if (!change->state.enabled || change->state.cc != step->cc || change->state.top != step->top ||
+            change->time_ns < start_ns || change->time_ns > limit_ns) {
+            fail("%s: tick %u took cc %08lx top %lu at %+lld ns, expected cc %08lx top %lu within %llu ns",
+                 name, tick, (unsigned long)change->state.cc, (unsigned long)change->state.top,
+                 (long long)(change->time_ns - start_ns), (unsigned long)step->cc, (unsigned long)step->top,
+                 (unsigned long long)(limit_ns - start_ns));
+            return;
+        }
+        if (change->time_ns - start_ns > latest_ns)
+            latest_ns = change->time_ns - start_ns;
+        effect = *step;
+    }
+    if (c != change_count || mock_pwm_slice(buzzer_slice)->cc != 0)
+        fail("%s: %d changes of the buzzer, %d expected, level %08lx at the end", name, change_count, c,
+             (unsigned long)mock_pwm_slice(buzzer_slice)->cc);
+    printf("playback        %-12s %2d changes, at most %4.0f us into their tick, %d wakeup\n", name,
+           change_count, latest_ns / 1000.0, wakeups);
+}
+
+static volatile uint16_t sink;
+
+static void bench_build(void) {
+    static tone_schedule_t schedule;
+    static uint32_t cc_register[2];
+    const tone_sequence_t *sequence = &tone_work_done;
+
+    uint64_t start = now_ns();
+    for (int round = 0; round < ROUNDS; ++round) {
+        tone_schedule_build(&schedule, sequence, PWM_CHAN_B, cc_register);
+        sink = schedule.length;
+    }
+    double ns = (double)(now_ns() - start) / ROUNDS;
+    printf("build           %.0f ns per schedule, %.1f ns per tick\n", ns, ns / schedule.length);
+}
+
+int main(void) {
+    check_periods();
+    check_schedule("work done", &tone_work_done);
+    check_schedule("break done", &tone_break_done);
+    check_rejected();
+
+    buzzer_slice = pwm_gpio_to_slice_num(BUZZER);
+    tone_init();
+    mock_pwm_set_hook(watch);
+    check_playback("work done", &tone_work_done);
+    check_playback("break done", &tone_break_done);
+    check_playback("work done", &tone_work_done);
+
+    bench_build();
+    return report_failures();
+}
@@ -0,0 +1,90 @@
+/**
+ * @file bench_wheel.c
+ * @brief Drift and cost of the timer wheel over a simulated day.
+ *
+ * Dozens of named periodic timers, from one second to several hours,
+ * each re-arm themselves from their own deadline. The clock jumps to the
+ * next deadline plus a pseudo-random servicing latency of up to 5 ms, as
+ * the main loop would see it. Every expiry is compared with where it
+ * should be, k periods after the start: with absolute deadlines the error
+ * must never exceed one latency, however long the run.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "../src/timer_wheel.h"
+
+#define TIMERS 48
+#define RUN_US (24ull * 3600 * 1000000)
+#define LATENCY_MAX_US 5000
+
+typedef struct {
+    timer_wheel_timer_t timer;
+    char name[12];
+    uint64_t period_us;
+    uint64_t expiries;
+    int64_t worst_drift_us;
+} periodic_t;
+
+static timer_wheel_t wheel;
+static periodic_t periodics[TIMERS];
+static uint64_t now_us;
+static uint64_t expiries;
+static uint32_t seed = 0x9E3779B9;
+
+static uint32_t next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void periodic_expired(timer_wheel_timer_t *timer, void *data) {
+    periodic_t *p = data;
+    p->expiries++;
+    expiries++;
+
+    int64_t drift = (int64_t)(now_us - p->expiries * p->period_us);
+    if (drift > p->worst_drift_us)
+        p->worst_drift_us = drift;
+    timer_wheel_add(&wheel, timer, timer->deadline_us + p->period_us);
+}
+
+int main(void) {
+    static const char *const kinds[] = {"focus", "break", "long", "remind"};
+
+    timer_wheel_init(&wheel, 0);
+    for (int i = 0; i < TIMERS; ++i) {
+        periodic_t *p = &periodics[i];
+        snprintf(p->name, sizeof(p->name), "%s%d", kinds[i % 4], i / 4);
+        // 1 s to about 2 h in powers of two, with odd microseconds so the
+        // deadlines spread over the slots
+        p->period_us = (1000000ull << (i % 14)) + next_random() % 1000000;
+        timer_wheel_timer_init(&p->timer, p->name, periodic_expired, p);
+        timer_wheel_add(&wheel, &p->timer, p->period_us);
+    }
+
+    uint64_t next;
+    uint64_t services = 0;
+    uint64_t start = now_ns();
+    while (timer_wheel_next(&wheel, &next) && next < RUN_US) {
+        now_us = next + next_random() % (LATENCY_MAX_US + 1);
+        timer_wheel_advance(&wheel, now_us);
+        services++;
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    int64_t worst = 0;
+    for (int i = 0; i < TIMERS; ++i) {
+        if (periodics[i].worst_drift_us > worst)
+            worst = periodics[i].worst_drift_us;
+    }
+
+    printf("%d timers, %llu expiries in 24 h simulated, %llu wheel services\n", TIMERS,
+           (unsigned long long)expiries, (unsigned long long)services);
+    printf("worst drift      %lld us (latency up to %d us)\n", (long long)worst, LATENCY_MAX_US);
+    printf("cascades/expiry  %.2f\n", (double)wheel.cascades / expiries);
+    printf("ns/expiry        %.0f (next + advance + re-arm)\n", (double)elapsed / expiries);
+
+    return worst <= LATENCY_MAX_US ? 0 : 1;
+}
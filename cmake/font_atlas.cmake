@@ -0,0 +1,27 @@
+# Font atlas generated at build time from the text fonts in fonts/.
+#
+# pomodoro_font_atlas(<var>) adds the rule that runs tools/gen_font.py in
+# the current directory and appends the generated source to <var>.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(POMODORO_FONTS
+        font_8x8=${CMAKE_CURRENT_LIST_DIR}/../fonts/font8x8.txt
+        font_16x16=${CMAKE_CURRENT_LIST_DIR}/../fonts/font8x8.txt:2
+        font_24x24=${CMAKE_CURRENT_LIST_DIR}/../fonts/font8x8.txt:3@0123456789:-
+        font_7seg=${CMAKE_CURRENT_LIST_DIR}/../fonts/seg7.txt)
+set(POMODORO_FONT_GENERATOR ${CMAKE_CURRENT_LIST_DIR}/../tools/gen_font.py)
+set(POMODORO_FONT_SOURCES
+        ${CMAKE_CURRENT_LIST_DIR}/../fonts/font8x8.txt
+        ${CMAKE_CURRENT_LIST_DIR}/../fonts/seg7.txt)
+
+function(pomodoro_font_atlas sources_var)
+    set(atlas ${CMAKE_CURRENT_BINARY_DIR}/generated/font_atlas.c)
+    add_custom_command(OUTPUT ${atlas}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${CMAKE_CURRENT_BINARY_DIR}/generated
+            COMMAND ${Python3_EXECUTABLE} ${POMODORO_FONT_GENERATOR} ${atlas} ${POMODORO_FONTS}
+            DEPENDS ${POMODORO_FONT_GENERATOR} ${POMODORO_FONT_SOURCES}
+            COMMENT "Generating font atlas"
+            VERBATIM)
+    set(${sources_var} ${${sources_var}} ${atlas} PARENT_SCOPE)
+endfunction()
@@ -0,0 +1,121 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "link_client.h"
+
+bool link_client_open(link_client_t *client, const char *path) {
+    *client = (link_client_t){ .fd = open(path, O_RDWR | O_NOCTTY) };
+    if (client->fd < 0)
+        return false;
+
+    struct termios raw;
+    if (tcgetattr(client->fd, &raw) == 0) {
+        cfmakeraw(&raw);
+        tcsetattr(client->fd, TCSANOW, &raw);
+    }
+    return true;
+}
+
+void link_client_close(link_client_t *client) {
+    if (client->fd >= 0)
+        close(client->fd);
+    client->fd = -1;
+}
+
+uint8_t link_client_send(link_client_t *client, uint8_t type, const void *payload, uint8_t length) {
+    link_message_t message;
+    uint8_t wire[LINK_WIRE_MAX];
+
+    // Sequence numbers wrap from 255 to 1; 0 is for streamed messages
+    client->seq = client->seq == 255 ? 1 : client->seq + 1;
+    link_message(&message, type, client->seq, payload, length);
+    size_t size = link_encode(&message, wire);
+    for (size_t sent = 0; sent < size;) {
+        ssize_t n = write(client->fd, wire + sent, size - sent);
+        if (n < 0 && errno != EINTR)
+            return 0;
+        if (n > 0)
+            sent += (size_t)n;
+    }
+    return client->seq;
+}
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Same framing as link_rx() on the board.
+ *
+ * @return true once a valid frame has been decoded into message.
+ */
+static bool link_client_rx(link_client_t *client, uint8_t byte, link_message_t *message) {
+    if (byte != 0x00) {
+        if (!client->in_frame)
+            return false;
+        if (client->rx_length < sizeof(client->rx))
+            client->rx[client->rx_length++] = byte;
+        else
+            client->overflow = true;
+        return false;
+    }
+    if (!client->in_frame || client->rx_length == 0) {
+        client->in_frame = true;
+        client->rx_length = 0;
+        client->overflow = false;
+        return false;
+    }
+    client->in_frame = false;
+    if (client->overflow || !link_decode(client->rx, client->rx_length, message)) {
+        client->rx_errors++;
+        return false;
+    }
+    return true;
+}
+
+bool link_client_poll(link_client_t *client, link_message_t *message, int timeout_ms) {
+    int64_t deadline = timeout_ms < 0 ? -1 : now_ms() + timeout_ms;
+
+    for (;;) {
+        while (client->in_next < client->in_count)
+            if (link_client_rx(client, client->in[client->in_next++], message))
+                return true;
+
+        int wait_ms = deadline < 0 ? -1 : (int)(deadline - now_ms());
+        if (deadline >= 0 && wait_ms < 0)
+            wait_ms = 0;
+        struct pollfd pfd = { .fd = client->fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, wait_ms);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready <= 0)
+            return false;
+
+        ssize_t n = read(client->fd, client->in, sizeof(client->in));
+        if (n <= 0)
+            return false;
+        client->in_next = 0;
+        client->in_count = (uint16_t)n;
+    }
+}
+
+bool link_client_command(link_client_t *client, uint8_t type, const void *payload, uint8_t length,
+                         link_message_t *reply, int timeout_ms) {
+    int64_t deadline = now_ms() + timeout_ms;
+    uint8_t seq = link_client_send(client, type, payload, length);
+    if (seq == 0)
+        return false;
+
+    for (int64_t left = timeout_ms; left >= 0; left = deadline - now_ms()) {
+        if (!link_client_poll(client, reply, (int)left))
+            return false;
+        if (reply->seq == seq)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file link_client.h
+ * @brief Host side of the binary USB protocol (see src/link_protocol.h).
+ *
+ * Opens the board's serial port, or the pseudo-terminal of the simulator,
+ * in raw mode and exchanges framed messages over it. Console text the
+ * board prints between frames is skipped.
+ */
+
+#ifndef LINK_CLIENT_H
+#define LINK_CLIENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../src/link_protocol.h"
+
+/**
+ * @brief An open port and the frame being received.
+ */
+typedef struct {
+    int fd;
+    uint8_t seq;       ///< Last sequence number used
+    bool in_frame;
+    bool overflow;
+    uint8_t rx_length;
+    uint8_t rx[LINK_ENCODED_MAX];
+    uint8_t in[256];    ///< Read from the port, not yet framed
+    uint16_t in_next;
+    uint16_t in_count;
+    uint32_t rx_errors; ///< Frames dropped
+} link_client_t;
+
+/**
+ * @brief Opens a serial device in raw mode.
+ *
+ * @return false with errno set if it cannot be opened.
+ */
+bool link_client_open(link_client_t *client, const char *path);
+
+void link_client_close(link_client_t *client);
+
+/**
+ * @brief Sends a command with the next sequence number.
+ *
+ * @return The sequence number used, 0 on a write error.
+ */
+uint8_t link_client_send(link_client_t *client, uint8_t type, const void *payload, uint8_t length);
+
+/**
+ * @brief Waits for the next message from the board.
+ *
+ * @param timeout_ms Longest wait, -1 for none.
+ * @return false on timeout or a read error.
+ */
+bool link_client_poll(link_client_t *client, link_message_t *message, int timeout_ms);
+
+/**
+ * @brief Sends a command and waits for the reply with its sequence
+ * number. Streamed status messages received meanwhile are dropped.
+ *
+ * @return false if no reply came within timeout_ms.
+ */
+bool link_client_command(link_client_t *client, uint8_t type, const void *payload, uint8_t length,
+                         link_message_t *reply, int timeout_ms);
+
+#endif // LINK_CLIENT_H
@@ -0,0 +1,54 @@
+#include <string.h>
+#include "mirror_client.h"
+
+void mirror_client_init(mirror_client_t *mirror) {
+    memset(mirror, 0, sizeof(*mirror));
+}
+
+static mirror_client_result_t mirror_client_lose(mirror_client_t *mirror) {
+    mirror->valid = false;
+    mirror->receiving = false;
+    mirror->lost++;
+    return MIRROR_CLIENT_LOST;
+}
+
+mirror_client_result_t mirror_client_take(mirror_client_t *mirror, const link_message_t *message) {
+    if (message->length < LINK_FRAME_HEADER)
+        return mirror_client_lose(mirror);
+    uint8_t number = message->payload[0], index = message->payload[1], flags = message->payload[2];
+    size_t chunk = message->length - LINK_FRAME_HEADER;
+
+    if (index == 0) {
+        // A delta only applies on top of the frame just before it
+        if (!(flags & LINK_FRAME_KEY) && (!mirror->valid || number != (uint8_t)(mirror->number + 1)))
+            return mirror_client_lose(mirror);
+        mirror->receiving = true;
+        mirror->number = number;
+        mirror->flags = flags;
+        mirror->next_chunk = 0;
+        mirror->length = 0;
+    } else if (!mirror->receiving || number != mirror->number || index != mirror->next_chunk) {
+        return mirror_client_lose(mirror);
+    }
+    if (mirror->length + chunk > sizeof(mirror->encoded))
+        return mirror_client_lose(mirror);
+
+    memcpy(&mirror->encoded[mirror->length], &message->payload[LINK_FRAME_HEADER], chunk);
+    mirror->length += (uint16_t)chunk;
+    mirror->next_chunk++;
+    if (!(flags & LINK_FRAME_LAST))
+        return MIRROR_CLIENT_PENDING;
+
+    mirror->receiving = false;
+    if (mirror->flags & LINK_FRAME_KEY)
+        memset(mirror->frame, 0, sizeof(mirror->frame));
+    if (!fb_delta_decode(mirror->frame, MIRROR_CLIENT_WIDTH, MIRROR_CLIENT_PAGES, mirror->encoded, mirror->length))
+        return mirror_client_lose(mirror);
+    mirror->valid = true;
+    mirror->frames++;
+    return MIRROR_CLIENT_FRAME;
+}
+
+bool mirror_client_pixel(const mirror_client_t *mirror, unsigned x, unsigned y) {
+    return mirror->frame[x * MIRROR_CLIENT_PAGES + y / 8] >> (y % 8) & 1;
+}
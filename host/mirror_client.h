@@ -0,0 +1,53 @@
+/**
+ * @file mirror_client.h
+ * @brief Host side of the framebuffer mirror: reassembles LINK_FRAME
+ * chunks and decodes them into a copy of the board's framebuffer.
+ */
+
+#ifndef MIRROR_CLIENT_H
+#define MIRROR_CLIENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../src/fb_delta.h"
+#include "../src/link_protocol.h"
+
+#define MIRROR_CLIENT_WIDTH 128
+#define MIRROR_CLIENT_PAGES 8
+
+typedef enum {
+    MIRROR_CLIENT_PENDING, ///< More chunks to come
+    MIRROR_CLIENT_FRAME,   ///< A frame was completed and applied
+    MIRROR_CLIENT_LOST,    ///< A chunk or frame went missing: ask for a key frame
+} mirror_client_result_t;
+
+/**
+ * @brief The frame as the panel shows it, in the driver's layout, and the
+ * frame being received.
+ */
+typedef struct {
+    uint8_t frame[MIRROR_CLIENT_WIDTH * MIRROR_CLIENT_PAGES];
+    bool valid;          ///< frame holds the last frame sent
+    bool receiving;
+    uint8_t number;      ///< Of the frame in frame, or being received
+    uint8_t flags;
+    uint8_t next_chunk;
+    uint16_t length;
+    uint8_t encoded[FB_DELTA_MAX(MIRROR_CLIENT_WIDTH, MIRROR_CLIENT_PAGES)];
+    uint32_t frames;     ///< Frames applied
+    uint32_t lost;       ///< Frames dropped
+} mirror_client_t;
+
+void mirror_client_init(mirror_client_t *mirror);
+
+/**
+ * @brief Takes a LINK_FRAME message.
+ */
+mirror_client_result_t mirror_client_take(mirror_client_t *mirror, const link_message_t *message);
+
+/**
+ * @brief A pixel of the mirrored frame.
+ */
+bool mirror_client_pixel(const mirror_client_t *mirror, unsigned x, unsigned y);
+
+#endif // MIRROR_CLIENT_H
@@ -0,0 +1,167 @@
+/**
+ * @file pomodoro_ctl.c
+ * @brief Command-line control of the timer over the binary protocol.
+ *
+ * Usage: pomodoro-ctl DEVICE start|pause|reset|status|ping
+ *        pomodoro-ctl DEVICE set WORK BREAK
+ *        pomodoro-ctl DEVICE watch MS
+ *        pomodoro-ctl DEVICE trace FILE
+ *
+ * DEVICE is the board's USB serial port, or the pseudo-terminal printed
+ * by Pomodoro-Timer-sim --pty. "watch" streams status messages every MS
+ * milliseconds until interrupted. "trace" writes the board's input trace
+ * to FILE as it comes, until interrupted, for Pomodoro-Timer-sim --replay;
+ * it stops early if records were lost.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "link_client.h"
+#include "../src/trace_record.h"
+
+#define REPLY_TIMEOUT_MS 1000
+
+static const char *const results[] = { "ok", "rejected", "bad length", "bad value", "unknown command" };
+
+static void print_status(const link_status_t *s) {
+    printf("%s %02u:%02u  %s, %u/%u min  today %u, week %u  up %.1f s  awake %.1f%%  frames %u in (%u bad), %u out\n",
+           s->flags & LINK_STATUS_BREAK ? "break" : "work ", s->minutes, s->seconds,
+           s->flags & LINK_STATUS_RUNNING ? "running" : s->flags & LINK_STATUS_ON ? "paused" : "stopped",
+           s->work_minutes, s->break_minutes, s->today_completed, s->week_completed, s->uptime_ms / 1e3,
+           s->active_permille / 10.0, s->rx_frames, s->rx_errors, s->tx_frames);
+}
+
+static int usage(void) {
+    fprintf(stderr, "usage: pomodoro-ctl DEVICE start|pause|reset|status|ping\n"
+                    "       pomodoro-ctl DEVICE set WORK BREAK\n"
+                    "       pomodoro-ctl DEVICE watch MS\n"
+                    "       pomodoro-ctl DEVICE trace FILE\n");
+    return 2;
+}
+
+/**
+ * @brief Writes the streamed records to a file, flushed after each message
+ * so an interrupted session keeps everything received.
+ *
+ * @return 0 once the board stops talking, 1 if records were lost.
+ */
+static int save_trace(link_client_t *client, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+
+    link_message_t message;
+    uint32_t expected = 0;
+    while (link_client_poll(client, &message, -1)) {
+        if (message.type != LINK_TRACE || message.length < LINK_TRACE_HEADER)
+            continue;
+        uint32_t index = message.payload[0] | message.payload[1] << 8 | message.payload[2] << 16 |
+                         (uint32_t)message.payload[3] << 24;
+        uint32_t records = (message.length - LINK_TRACE_HEADER) / TRACE_RECORD_SIZE;
+        if (expected == 0 && index != 0)
+            fprintf(stderr, "%s: the trace starts at record %lu, not at boot; it cannot be replayed\n", path,
+                    (unsigned long)index);
+        else if (index != expected) {
+            fprintf(stderr, "%s: records missing after %lu\n", path, (unsigned long)expected);
+            fclose(f);
+            return 1;
+        }
+        fwrite(&message.payload[LINK_TRACE_HEADER], TRACE_RECORD_SIZE, records, f);
+        fflush(f);
+        expected = index + records;
+        if (message.payload[4] & LINK_TRACE_LOST) {
+            fprintf(stderr, "%s: the board ran out of room after %lu records\n", path, (unsigned long)expected);
+            fclose(f);
+            return 1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static const struct {
+        const char *name;
+        uint8_t type;
+    } commands[] = {
+        { "start", LINK_START }, { "pause", LINK_PAUSE },       { "reset", LINK_RESET },
+        { "set", LINK_SET_DURATIONS }, { "watch", LINK_SET_RATE }, { "status", LINK_GET_STATUS },
+        { "ping", LINK_PING }, { "trace", LINK_SET_TRACE },
+    };
+    link_client_t client;
+    link_message_t reply;
+    uint8_t payload[2];
+    uint8_t length = 0;
+    int type = -1;
+
+    if (argc < 3)
+        return usage();
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i)
+        if (!strcmp(argv[2], commands[i].name))
+            type = commands[i].type;
+    if (type == LINK_SET_DURATIONS) {
+        if (argc != 5)
+            return usage();
+        payload[0] = (uint8_t)atoi(argv[3]);
+        payload[1] = (uint8_t)atoi(argv[4]);
+        length = 2;
+    } else if (type == LINK_SET_RATE) {
+        if (argc != 4)
+            return usage();
+        unsigned period_ms = (unsigned)atoi(argv[3]);
+        payload[0] = (uint8_t)period_ms;
+        payload[1] = (uint8_t)(period_ms >> 8);
+        length = 2;
+    } else if (type == LINK_SET_TRACE) {
+        if (argc != 4)
+            return usage();
+        payload[0] = 1;
+        length = 1;
+    } else if (type < 0 || argc != 3) {
+        return usage();
+    }
+
+    if (!link_client_open(&client, argv[1])) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (!link_client_command(&client, (uint8_t)type, payload, length, &reply, REPLY_TIMEOUT_MS)) {
+        fprintf(stderr, "%s: no reply\n", argv[1]);
+        return 1;
+    }
+
+    link_status_t status;
+    switch (reply.type) {
+    case LINK_STATUS:
+        link_status_unpack(reply.payload, &status);
+        print_status(&status);
+        return 0;
+    case LINK_PONG:
+        printf("pong\n");
+        return 0;
+    case LINK_ACK:
+        if (reply.payload[1] == LINK_OK && type == LINK_SET_TRACE)
+            return save_trace(&client, argv[3]);
+        if (reply.payload[1] != LINK_OK || type != LINK_SET_RATE) {
+            printf("%s\n", reply.payload[1] < 5 ? results[reply.payload[1]] : "?");
+            return reply.payload[1] == LINK_OK ? 0 : 1;
+        }
+        break;
+    default:
+        fprintf(stderr, "unexpected reply type 0x%02x\n", reply.type);
+        return 1;
+    }
+
+    // watch: print the stream until interrupted or the board goes quiet
+    while (link_client_poll(&client, &reply, REPLY_TIMEOUT_MS + (payload[0] | payload[1] << 8))) {
+        if (reply.type != LINK_STATUS || reply.seq != 0)
+            continue;
+        link_status_unpack(reply.payload, &status);
+        print_status(&status);
+        fflush(stdout);
+    }
+    link_client_close(&client);
+    return 0;
+}
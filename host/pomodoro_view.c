@@ -0,0 +1,119 @@
+/**
+ * @file pomodoro_view.c
+ * @brief Shows the board's display in a terminal, from the mirrored
+ * framebuffer.
+ *
+ * Usage: pomodoro-view DEVICE [--pbm FILE] [--once]
+ *
+ * Each frame is drawn with half-block characters, two pixel rows per
+ * line, followed by the bytes it took. --pbm also writes every frame to
+ * FILE; --once exits after the first one. The mirror is stopped on exit.
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include "link_client.h"
+#include "mirror_client.h"
+
+#define REPLY_TIMEOUT_MS 1000
+#define WIDTH MIRROR_CLIENT_WIDTH
+#define HEIGHT (MIRROR_CLIENT_PAGES * 8)
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int signal) {
+    stop = 1;
+}
+
+static void draw(const mirror_client_t *mirror, uint64_t bytes) {
+    static const char *const blocks[] = { " ", "▀", "▄", "█" };
+
+    printf("\033[H");
+    for (unsigned y = 0; y < HEIGHT; y += 2) {
+        for (unsigned x = 0; x < WIDTH; ++x)
+            fputs(blocks[mirror_client_pixel(mirror, x, y) | mirror_client_pixel(mirror, x, y + 1) << 1], stdout);
+        putchar('\n');
+    }
+    printf("frame %u: %u bytes, %.1f on average (raw %d), %u lost\033[K\n", mirror->number, mirror->length,
+           (double)bytes / mirror->frames, WIDTH * HEIGHT / 8, mirror->lost);
+    fflush(stdout);
+}
+
+static bool write_pbm(const mirror_client_t *mirror, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+    fprintf(f, "P4\n%d %d\n", WIDTH, HEIGHT);
+    for (unsigned y = 0; y < HEIGHT; ++y)
+        for (unsigned x = 0; x < WIDTH; x += 8) {
+            uint8_t bits = 0;
+            for (unsigned i = 0; i < 8; ++i)
+                bits |= mirror_client_pixel(mirror, x + i, y) << (7 - i);
+            fputc(bits, f);
+        }
+    return fclose(f) == 0;
+}
+
+int main(int argc, char **argv) {
+    static mirror_client_t mirror;
+    link_client_t client;
+    link_message_t message;
+    const char *pbm = NULL;
+    bool once = false;
+    uint64_t bytes = 0;
+
+    for (int i = 2; i < argc; ++i) {
+        if (!strcmp(argv[i], "--pbm") && i + 1 < argc)
+            pbm = argv[++i];
+        else if (!strcmp(argv[i], "--once"))
+            once = true;
+        else
+            argc = 0;
+    }
+    if (argc < 2) {
+        fprintf(stderr, "usage: pomodoro-view DEVICE [--pbm FILE] [--once]\n");
+        return 2;
+    }
+    if (!link_client_open(&client, argv[1])) {
+        perror(argv[1]);
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    mirror_client_init(&mirror);
+    if (!link_client_command(&client, LINK_SET_MIRROR, (uint8_t[]){ 1 }, 1, &message, REPLY_TIMEOUT_MS) ||
+        message.type != LINK_ACK || message.payload[1] != LINK_OK) {
+        fprintf(stderr, "%s: mirroring not available\n", argv[1]);
+        return 1;
+    }
+    if (!once)
+        printf("\033[2J");
+
+    while (!stop) {
+        if (!link_client_poll(&client, &message, 100) || message.type != LINK_FRAME)
+            continue;
+        switch (mirror_client_take(&mirror, &message)) {
+        case MIRROR_CLIENT_PENDING:
+            break;
+        case MIRROR_CLIENT_LOST:
+            link_client_send(&client, LINK_SET_MIRROR, (uint8_t[]){ 1 }, 1);
+            break;
+        case MIRROR_CLIENT_FRAME:
+            bytes += mirror.length;
+            if (pbm && !write_pbm(&mirror, pbm)) {
+                perror(pbm);
+                stop = 1;
+            }
+            if (once)
+                stop = 1;
+            else
+                draw(&mirror, bytes);
+            break;
+        }
+    }
+
+    link_client_command(&client, LINK_SET_MIRROR, (uint8_t[]){ 0 }, 1, &message, REPLY_TIMEOUT_MS);
+    link_client_close(&client);
+    return 0;
+}
@@ -1,77 +1,307 @@
+#include <string.h>
 #include "ssd1306.h"
 #include "font.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 
-#define FONT_LOWERCASE_OFFSET 37 
+// Bus bytes spent on opening one more window (header plus two address
+// bytes). Used to decide when two dirty pages are cheaper to send as one
+// window.
+#define SSD1306_WINDOW_OVERHEAD (SSD1306_WINDOW_HEADER + 2)
 
-void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
-  ssd->width = width;
-  ssd->height = height;
-  ssd->pages = height / 8U;
+_Static_assert(SSD1306_HEIGHT % 8 == 0, "whole pages only");
+_Static_assert(SSD1306_WIDTH + SSD1306_COLUMN_OFFSET <= 128 && SSD1306_HEIGHT <= 64, "larger than GDDRAM");
+_Static_assert(sizeof(((ssd1306_t *)0)->ram_buffer) == SSD1306_WIDTH * SSD1306_HEIGHT / 8 + 1,
+               "framebuffer is one control byte and one bit per pixel");
+_Static_assert(SSD1306_FRONT_SIZE <= UINT16_MAX, "uint16_t indices");
+
+// Instances with a DMA channel, looked up by the shared DMA IRQ handler.
+static ssd1306_t *ssd1306_instances[SSD1306_MAX_INSTANCES];
+
+static inline uint16_t ssd1306_index(uint8_t x, uint8_t page) {
+  return page + x * SSD1306_PAGES + 1;
+}
+
+static void ssd1306_clear_dirty(ssd1306_t *ssd) {
+  for (uint8_t page = 0; page < SSD1306_PAGES; ++page) {
+    ssd->dirty_x0[page] = 0xFF;
+    ssd->dirty_x1[page] = 0;
+  }
+}
+
+static void ssd1306_dma_irq_handler(void) {
+  for (uint8_t i = 0; i < SSD1306_MAX_INSTANCES; ++i) {
+    ssd1306_t *ssd = ssd1306_instances[i];
+    if (!ssd || !dma_channel_get_irq0_status(ssd->dma_channel))
+      continue;
+    dma_channel_acknowledge_irq0(ssd->dma_channel);
+    if (ssd->flush_callback)
+      ssd->flush_callback(ssd, ssd->flush_callback_data);
+  }
+}
+
+static void ssd1306_dma_init(ssd1306_t *ssd) {
+  bool first = true;
+  uint8_t slot = SSD1306_MAX_INSTANCES;
+  for (uint8_t i = 0; i < SSD1306_MAX_INSTANCES; ++i) {
+    if (ssd1306_instances[i])
+      first = false;
+    else if (slot == SSD1306_MAX_INSTANCES)
+      slot = i;
+  }
+  hard_assert(slot < SSD1306_MAX_INSTANCES);
+  ssd1306_instances[slot] = ssd;
+
+  ssd->dma_channel = dma_claim_unused_channel(true);
+  dma_channel_set_irq0_enabled(ssd->dma_channel, true);
+  if (first) {
+    irq_add_shared_handler(DMA_IRQ_0, ssd1306_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+  }
+}
+
+void ssd1306_init(ssd1306_t *ssd, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
   ssd->address = address;
   ssd->i2c_port = i2c;
-  ssd->bufsize = ssd->pages * ssd->width + 1;
-  ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
+  ssd->external_vcc = external_vcc;
+  memset(ssd->ram_buffer, 0, sizeof(ssd->ram_buffer));
+  memset(ssd->shadow_buffer, 0, sizeof(ssd->shadow_buffer));
   ssd->ram_buffer[0] = 0x40;
-  ssd->port_buffer[0] = 0x80;
+  ssd->bytes_sent = 0;
+  ssd->transactions = 0;
+  ssd1306_clear_dirty(ssd);
+  ssd1306_invalidate(ssd);
+  ssd1306_dma_init(ssd);
 }
 
+// Whole power-up sequence in one transaction.
 void ssd1306_config(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_DISP | 0x00);
-  ssd1306_command(ssd, SET_MEM_ADDR);
-  ssd1306_command(ssd, 0x01);
-  ssd1306_command(ssd, SET_DISP_START_LINE | 0x00);
-  ssd1306_command(ssd, SET_SEG_REMAP | 0x01);
-  ssd1306_command(ssd, SET_MUX_RATIO);
-  ssd1306_command(ssd, HEIGHT - 1);
-  ssd1306_command(ssd, SET_COM_OUT_DIR | 0x08);
-  ssd1306_command(ssd, SET_DISP_OFFSET);
-  ssd1306_command(ssd, 0x00);
-  ssd1306_command(ssd, SET_COM_PIN_CFG);
-  ssd1306_command(ssd, 0x12);
-  ssd1306_command(ssd, SET_DISP_CLK_DIV);
-  ssd1306_command(ssd, 0x80);
-  ssd1306_command(ssd, SET_PRECHARGE);
-  ssd1306_command(ssd, 0xF1);
-  ssd1306_command(ssd, SET_VCOM_DESEL);
-  ssd1306_command(ssd, 0x30);
-  ssd1306_command(ssd, SET_CONTRAST);
-  ssd1306_command(ssd, 0xFF);
-  ssd1306_command(ssd, SET_ENTIRE_ON);
-  ssd1306_command(ssd, SET_NORM_INV);
-  ssd1306_command(ssd, SET_CHARGE_PUMP);
-  ssd1306_command(ssd, 0x14);
-  ssd1306_command(ssd, SET_DISP | 0x01);
+  const uint8_t commands[] = {
+    SET_DISP | 0x00,
+    SET_MEM_ADDR, 0x01,
+    SET_DISP_START_LINE | 0x00,
+    SET_SEG_REMAP | 0x01,
+    SET_MUX_RATIO, SSD1306_HEIGHT - 1,
+    SET_COM_OUT_DIR | 0x08,
+    SET_DISP_OFFSET, 0x00,
+    SET_COM_PIN_CFG, SSD1306_COM_PINS,
+    SET_DISP_CLK_DIV, 0x80,
+    SET_PRECHARGE, 0xF1,
+    SET_VCOM_DESEL, 0x30,
+    SET_CONTRAST, 0xFF,
+    SET_ENTIRE_ON,
+    SET_NORM_INV,
+    SET_CHARGE_PUMP, 0x14,
+    SET_DISP | 0x01
+  };
+  ssd1306_command_stream(ssd, commands, sizeof(commands));
 }
 
 void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
-  ssd->port_buffer[1] = command;
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->port_buffer,
-    2,
-    false
-  );
+  ssd1306_command_stream(ssd, &command, 1);
 }
 
+// Sends commands and their arguments as one transaction: a 0x00 control
+// byte (Co = 0, D/C# = 0) makes every following byte a command until STOP.
+void ssd1306_command_stream(ssd1306_t *ssd, const uint8_t *commands, size_t count) {
+  uint8_t buffer[SSD1306_MAX_COMMANDS + 1];
+
+  hard_assert(count <= SSD1306_MAX_COMMANDS);
+  buffer[0] = 0x00;
+  memcpy(&buffer[1], commands, count);
+
+  ssd1306_wait(ssd);
+  i2c_write_blocking(ssd->i2c_port, ssd->address, buffer, count + 1, false);
+  ssd->bytes_sent += count + 1;
+  ssd->transactions++;
+}
+
+// Appends columns c0..c1 of pages p0..p1 to the front buffer as
+// IC_DATA_CMD words: a command transaction setting the window, then the
+// data transaction. The panel runs in vertical addressing mode, so the
+// window is streamed column by column.
+static size_t ssd1306_stage_window(ssd1306_t *ssd, size_t len, uint8_t c0, uint8_t c1, uint8_t p0, uint8_t p1) {
+  const uint8_t header[SSD1306_WINDOW_HEADER] = {
+    0x00, SET_COL_ADDR, c0 + SSD1306_COLUMN_OFFSET, c1 + SSD1306_COLUMN_OFFSET, SET_PAGE_ADDR, p0, p1,
+    0x40
+  };
+  for (uint8_t i = 0; i < SSD1306_WINDOW_HEADER; ++i)
+    ssd->front_buffer[len++] = header[i];
+  ssd->front_buffer[len - 2] |= I2C_IC_DATA_CMD_STOP_BITS;
+  ssd->transactions += 2;
+
+  for (uint8_t x = c0; x <= c1; ++x) {
+    for (uint8_t page = p0; page <= p1; ++page) {
+      uint16_t index = ssd1306_index(x, page);
+      ssd->front_buffer[len++] = ssd->ram_buffer[index];
+      ssd->shadow_buffer[index] = ssd->ram_buffer[index];
+    }
+  }
+
+  ssd->front_buffer[len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+  return len;
+}
+
+// Shrinks the dirty range of a page to the columns that really differ from
+// what the panel already shows. Returns false when nothing is left to send.
+static bool ssd1306_trim_page(ssd1306_t *ssd, uint8_t page) {
+  uint8_t x0 = ssd->dirty_x0[page];
+  uint8_t x1 = ssd->dirty_x1[page];
+
+  while (x0 <= x1 && ssd->ram_buffer[ssd1306_index(x0, page)] == ssd->shadow_buffer[ssd1306_index(x0, page)])
+    ++x0;
+  if (x0 > x1) {
+    ssd->dirty_x0[page] = 0xFF;
+    ssd->dirty_x1[page] = 0;
+    return false;
+  }
+  while (ssd->ram_buffer[ssd1306_index(x1, page)] == ssd->shadow_buffer[ssd1306_index(x1, page)])
+    --x1;
+
+  ssd->dirty_x0[page] = x0;
+  ssd->dirty_x1[page] = x1;
+  return true;
+}
+
+// Copies what changed since the last flush from the back buffer
+// (ram_buffer) into the front buffer and returns its length in words.
+// Dirty ranges are first trimmed against the shadow copy of the panel, so
+// redrawing identical content costs nothing on the bus. Consecutive dirty
+// pages are merged into one window whenever the extra (clean) bytes cost
+// less than the overhead of a separate window.
+static size_t ssd1306_stage(ssd1306_t *ssd) {
+  size_t len = 0;
+  bool open = false;
+  uint8_t c0 = 0, c1 = 0, p0 = 0, p1 = 0;
+
+  for (uint8_t page = 0; page < SSD1306_PAGES; ++page) {
+    if (ssd->dirty_x1[page] < ssd->dirty_x0[page])
+      continue;
+    if (!ssd->resend && !ssd1306_trim_page(ssd, page))
+      continue;
+
+    uint8_t x0 = ssd->dirty_x0[page];
+    uint8_t x1 = ssd->dirty_x1[page];
+
+    if (!open) {
+      open = true;
+      c0 = x0; c1 = x1; p0 = page; p1 = page;
+      continue;
+    }
+
+    uint8_t m0 = x0 < c0 ? x0 : c0;
+    uint8_t m1 = x1 > c1 ? x1 : c1;
+    size_t merged = (size_t)(page - p0 + 1) * (m1 - m0 + 1);
+    size_t split = (size_t)(p1 - p0 + 1) * (c1 - c0 + 1) + (x1 - x0 + 1) + SSD1306_WINDOW_OVERHEAD;
+    if (merged <= split) {
+      c0 = m0; c1 = m1; p1 = page;
+    } else {
+      len = ssd1306_stage_window(ssd, len, c0, c1, p0, p1);
+      c0 = x0; c1 = x1; p0 = page; p1 = page;
+    }
+  }
+
+  if (open)
+    len = ssd1306_stage_window(ssd, len, c0, c1, p0, p1);
+
+  ssd1306_clear_dirty(ssd);
+  ssd->resend = false;
+  return len;
+}
+
+// Starts streaming the changes to the panel and returns without waiting.
+// The back buffer can be drawn on right away. Returns false, leaving the
+// changes pending, while the previous transfer is still being fed.
+bool ssd1306_send_data_async(ssd1306_t *ssd) {
+  if (dma_channel_is_busy(ssd->dma_channel))
+    return false;
+
+  size_t len = ssd1306_stage(ssd);
+  if (len == 0)
+    return true;
+
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  if (hw->tar != ssd->address) {
+    ssd1306_wait(ssd);
+    hw->enable = 0;
+    hw->tar = ssd->address;
+    hw->enable = 1;
+  }
+  hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS;
+
+  dma_channel_config config = dma_channel_get_default_config(ssd->dma_channel);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+  channel_config_set_read_increment(&config, true);
+  channel_config_set_write_increment(&config, false);
+  channel_config_set_dreq(&config, i2c_get_dreq(ssd->i2c_port, true));
+  dma_channel_configure(ssd->dma_channel, &config, &hw->data_cmd, ssd->front_buffer, len, true);
+  ssd->bytes_sent += len;
+  return true;
+}
+
+// True until the last byte of the current transfer has left the bus.
+bool ssd1306_busy(ssd1306_t *ssd) {
+  if (dma_channel_is_busy(ssd->dma_channel))
+    return true;
+  uint32_t status = i2c_get_hw(ssd->i2c_port)->status;
+  return !(status & I2C_IC_STATUS_TFE_BITS) || (status & I2C_IC_STATUS_MST_ACTIVITY_BITS);
+}
+
+void ssd1306_wait(ssd1306_t *ssd) {
+  while (ssd1306_busy(ssd))
+    tight_loop_contents();
+}
+
+// Registers a function called from the DMA IRQ once a transfer has been
+// fed to the controller. Pass NULL to remove it.
+void ssd1306_set_flush_callback(ssd1306_t *ssd, ssd1306_flush_callback_t callback, void *data) {
+  ssd->flush_callback = callback;
+  ssd->flush_callback_data = data;
+}
+
+// Blocking flush, for boot-time code that has nothing else to do.
 void ssd1306_send_data(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_COL_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
-  ssd1306_command(ssd, SET_PAGE_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->ram_buffer,
-    ssd->bufsize,
-    false
-  );
+  ssd1306_wait(ssd);
+  ssd1306_send_data_async(ssd);
+  ssd1306_wait(ssd);
 }
 
-void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
-  uint16_t index = (y >> 3) + (x << 3) + 1;
+// Marks the pixel box (x0, y0)-(x1, y1), inclusive, as changed.
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+  if (x0 >= SSD1306_WIDTH || y0 >= SSD1306_HEIGHT)
+    return;
+  if (x1 >= SSD1306_WIDTH)
+    x1 = SSD1306_WIDTH - 1;
+  if (y1 >= SSD1306_HEIGHT)
+    y1 = SSD1306_HEIGHT - 1;
+
+  for (uint8_t page = y0 >> 3; page <= (y1 >> 3); ++page) {
+    if (x0 < ssd->dirty_x0[page])
+      ssd->dirty_x0[page] = x0;
+    if (x1 > ssd->dirty_x1[page])
+      ssd->dirty_x1[page] = x1;
+  }
+}
+
+// Forces the next ssd1306_send_data to resend the whole frame, whatever the
+// panel is believed to show (used at power-up, when GDDRAM is random).
+void ssd1306_invalidate(ssd1306_t *ssd) {
+  ssd->resend = true;
+  ssd1306_mark_dirty(ssd, 0, 0, SSD1306_WIDTH - 1, SSD1306_HEIGHT - 1);
+}
+
+bool ssd1306_is_dirty(const ssd1306_t *ssd) {
+  for (uint8_t page = 0; page < SSD1306_PAGES; ++page)
+    if (ssd->dirty_x1[page] >= ssd->dirty_x0[page])
+      return true;
+  return false;
+}
+
+// Writes a pixel without touching the dirty state; callers mark the box.
+static inline void ssd1306_put(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
+  if (x >= SSD1306_WIDTH || y >= SSD1306_HEIGHT)
+    return;
+  uint16_t index = ssd1306_index(x, y >> 3);
   uint8_t pixel = (y & 0b111);
   if (value)
     ssd->ram_buffer[index] |= (1 << pixel);
@@ -79,44 +309,101 @@ void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
     ssd->ram_buffer[index] &= ~(1 << pixel);
 }
 
-/*
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-  uint8_t byte = value ? 0xFF : 0x00;
-  for (uint8_t i = 1; i < ssd->bufsize; ++i)
-    ssd->ram_buffer[i] = byte;
-}*/
-
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
-    }
+void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
+  ssd1306_mark_dirty(ssd, x, y, x, y);
+  ssd1306_put(ssd, x, y, value);
 }
 
+// Byte distance between the same page of two neighbouring columns.
+#define SSD1306_COLUMN_STRIDE (ssd1306_index(1, 0) - ssd1306_index(0, 0))
 
+static inline void ssd1306_apply(uint8_t *byte, uint8_t mask, bool value) {
+  if (value)
+    *byte |= mask;
+  else
+    *byte &= ~mask;
+}
 
-void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
-  for (uint8_t x = left; x < left + width; ++x) {
-    ssd1306_pixel(ssd, x, top, value);
-    ssd1306_pixel(ssd, x, top + height - 1, value);
+// Sets rows y0..y1 of column x. A column is stored as consecutive page
+// bytes, so a vertical span is at most a masked byte, a run of whole bytes
+// and another masked byte.
+static void ssd1306_column_span(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
+  uint8_t *column = &ssd->ram_buffer[ssd1306_index(x, 0)];
+  uint8_t p0 = y0 >> 3;
+  uint8_t p1 = y1 >> 3;
+  uint8_t first = (uint8_t)(0xFF << (y0 & 7));
+  uint8_t last = (uint8_t)(0xFF >> (7 - (y1 & 7)));
+
+  if (p0 == p1) {
+    ssd1306_apply(&column[p0], first & last, value);
+    return;
   }
-  for (uint8_t y = top; y < top + height; ++y) {
-    ssd1306_pixel(ssd, left, y, value);
-    ssd1306_pixel(ssd, left + width - 1, y, value);
+  ssd1306_apply(&column[p0], first, value);
+  if (p1 > p0 + 1)
+    memset(&column[p0 + 1], value ? 0xFF : 0x00, p1 - p0 - 1);
+  ssd1306_apply(&column[p1], last, value);
+}
+
+// Fills the inclusive box (x0, y0)-(x1, y1), already clipped. Boxes that
+// span every page are one contiguous run of the buffer.
+static void ssd1306_fill_box(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
+  if (y0 == 0 && y1 == SSD1306_HEIGHT - 1) {
+    memset(&ssd->ram_buffer[ssd1306_index(x0, 0)], value ? 0xFF : 0x00,
+           (size_t)(x1 - x0 + 1) * SSD1306_COLUMN_STRIDE);
+    return;
   }
+  for (uint8_t x = x0; x <= x1; ++x)
+    ssd1306_column_span(ssd, x, y0, y1, value);
+}
+
+// Clips the inclusive box to the panel. Returns false if nothing is left.
+static bool ssd1306_clip(const ssd1306_t *ssd, uint8_t *x0, uint8_t *y0, uint8_t *x1, uint8_t *y1) {
+  if (*x0 > *x1) { uint8_t t = *x0; *x0 = *x1; *x1 = t; }
+  if (*y0 > *y1) { uint8_t t = *y0; *y0 = *y1; *y1 = t; }
+  if (*x0 >= SSD1306_WIDTH || *y0 >= SSD1306_HEIGHT)
+    return false;
+  if (*x1 >= SSD1306_WIDTH)
+    *x1 = SSD1306_WIDTH - 1;
+  if (*y1 >= SSD1306_HEIGHT)
+    *y1 = SSD1306_HEIGHT - 1;
+  return true;
+}
+
+void ssd1306_fill(ssd1306_t *ssd, bool value) {
+  ssd1306_mark_dirty(ssd, 0, 0, SSD1306_WIDTH - 1, SSD1306_HEIGHT - 1);
+  memset(ssd->ram_buffer + 1, value ? 0xFF : 0x00, SSD1306_BUFSIZE - 1);
+}
+
+void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
+  if (width == 0 || height == 0)
+    return;
+  uint8_t right = left + width - 1;
+  uint8_t bottom = top + height - 1;
 
   if (fill) {
-    for (uint8_t x = left + 1; x < left + width - 1; ++x) {
-      for (uint8_t y = top + 1; y < top + height - 1; ++y) {
-        ssd1306_pixel(ssd, x, y, value);
-      }
-    }
+    if (!ssd1306_clip(ssd, &left, &top, &right, &bottom))
+      return;
+    ssd1306_mark_dirty(ssd, left, top, right, bottom);
+    ssd1306_fill_box(ssd, left, top, right, bottom, value);
+    return;
   }
+
+  ssd1306_hline(ssd, left, right, top, value);
+  ssd1306_hline(ssd, left, right, bottom, value);
+  ssd1306_vline(ssd, left, top, bottom, value);
+  ssd1306_vline(ssd, right, top, bottom, value);
 }
 
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
+    if (y0 == y1) {
+        ssd1306_hline(ssd, x0, x1, y0, value);
+        return;
+    }
+    if (x0 == x1) {
+        ssd1306_vline(ssd, x0, y0, y1, value);
+        return;
+    }
+
     int dx = abs(x1 - x0);
     int dy = abs(y1 - y0);
 
@@ -125,8 +412,11 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
 
     int err = dx - dy;
 
+    ssd1306_mark_dirty(ssd, x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1,
+                       x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0);
+
     while (true) {
-        ssd1306_pixel(ssd, x0, y0, value); // Desenha o pixel atual
+        ssd1306_put(ssd, x0, y0, value); // The current pixel
 
         if (x0 == x1 && y0 == y1) break; // Termina quando alcança o ponto final
 
@@ -144,58 +434,186 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
     }
 }
 
-
+// A horizontal span sits in one page: the same bit of consecutive columns.
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
-  for (uint8_t x = x0; x <= x1; ++x)
-    ssd1306_pixel(ssd, x, y, value);
+  uint8_t y1 = y;
+  if (!ssd1306_clip(ssd, &x0, &y, &x1, &y1))
+    return;
+  ssd1306_mark_dirty(ssd, x0, y, x1, y);
+
+  uint8_t *byte = &ssd->ram_buffer[ssd1306_index(x0, y >> 3)];
+  uint8_t mask = 1u << (y & 7);
+  for (uint8_t x = x0; x <= x1; ++x, byte += SSD1306_COLUMN_STRIDE)
+    ssd1306_apply(byte, mask, value);
 }
 
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
-  for (uint8_t y = y0; y <= y1; ++y)
-    ssd1306_pixel(ssd, x, y, value);
+  uint8_t x1 = x;
+  if (!ssd1306_clip(ssd, &x, &y0, &x1, &y1))
+    return;
+  ssd1306_mark_dirty(ssd, x, y0, x, y1);
+  ssd1306_column_span(ssd, x, y0, y1, value);
 }
 
-// Função para desenhar um caractere
-void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
+// Bitmap blit in 32-bit words: a panel column is read as words of 32 rows
+// (4 pages), and for each one the bitmap bits that fall in it are shifted
+// into place, masked by the clip and combined at once by the raster op.
+
+// Little-endian word of the first count (1..4) bytes.
+static inline uint32_t ssd1306_load_word(const uint8_t *bytes, uint8_t count) {
+  if (count == 4)
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+  uint32_t word = 0;
+  for (uint8_t i = 0; i < count; ++i)
+    word |= (uint32_t)bytes[i] << (8 * i);
+  return word;
+}
+
+static inline void ssd1306_store_word(uint8_t *bytes, uint8_t count, uint32_t word) {
+  for (uint8_t i = 0; i < count; ++i, word >>= 8)
+    bytes[i] = (uint8_t)word;
+}
+
+// Rows offset..offset + 31 of a bitmap column; bytes outside the column
+// read as 0. offset may be negative.
+static inline uint32_t ssd1306_bitmap_rows(const uint8_t *column, uint8_t pages, int16_t offset) {
+  uint8_t shift = offset & 7;
+  int16_t first = (int16_t)(offset - shift) / 8;
+  uint32_t low, high;
+
+  if (first >= 0 && first + 5 <= pages) {
+    low = ssd1306_load_word(column + first, 4);
+    high = column[first + 4];
+  } else {
+    uint8_t bytes[5];
+    for (int16_t i = 0; i < 5; ++i)
+      bytes[i] = first + i >= 0 && first + i < pages ? column[first + i] : 0;
+    low = ssd1306_load_word(bytes, 4);
+    high = bytes[4];
+  }
+  return shift ? low >> shift | high << (32 - shift) : low;
+}
+
+// One loop per operation, so the inner loop has no switch. d is the panel
+// word, s the bitmap rows, m the rows the bitmap covers.
+#define SSD1306_ROP_COLUMNS(op) \
+  for (int16_t i = i0; i < i1; ++i, dst += SSD1306_COLUMN_STRIDE, src += bitmap->pages) { \
+    uint32_t d = ssd1306_load_word(dst, count); \
+    uint32_t s = ssd1306_bitmap_rows(src, bitmap->pages, offset) ^ invert; \
+    ssd1306_store_word(dst, count, (op)); \
+  }
+
+void ssd1306_blit(ssd1306_t *ssd, const ssd1306_bitmap_t *bitmap, int16_t x, int16_t y, ssd1306_rop_t rop) {
+  // Clipping: bitmap columns i0..i1 - 1 and panel rows y0..y1 - 1
+  int16_t i0 = x < 0 ? -x : 0;
+  int16_t i1 = SSD1306_WIDTH - x < bitmap->width ? SSD1306_WIDTH - x : bitmap->width;
+  int16_t y0 = y < 0 ? 0 : y;
+  int16_t y1 = y + bitmap->height < SSD1306_HEIGHT ? y + bitmap->height : SSD1306_HEIGHT;
+  if (i0 >= i1 || y0 >= y1)
+    return;
+  ssd1306_mark_dirty(ssd, x + i0, y0, x + i1 - 1, y1 - 1);
+
+  uint32_t invert = rop & SSD1306_ROP_INVERTED ? 0xFFFFFFFF : 0;
+  for (int16_t row = y0 & ~31; row < y1; row += 32) {
+    // Rows of this word the bitmap covers
+    int16_t top = y0 > row ? y0 - row : 0;
+    int16_t bottom = y1 < row + 32 ? y1 - row : 32;
+    uint32_t m = (bottom == 32 ? 0xFFFFFFFF : (1u << bottom) - 1) & (0xFFFFFFFF << top);
+    uint8_t count = SSD1306_PAGES - row / 8 < 4 ? SSD1306_PAGES - row / 8 : 4;
+    int16_t offset = row - y;
+    uint8_t *dst = &ssd->ram_buffer[ssd1306_index(x + i0, row / 8)];
+    const uint8_t *src = bitmap->data + i0 * bitmap->pages;
+
+    switch (rop & ~SSD1306_ROP_INVERTED) {
+    case SSD1306_ROP_COPY: SSD1306_ROP_COLUMNS((d & ~m) | (s & m)); break;
+    case SSD1306_ROP_OR: SSD1306_ROP_COLUMNS(d | (s & m)); break;
+    case SSD1306_ROP_AND: SSD1306_ROP_COLUMNS(d & (s | ~m)); break;
+    case SSD1306_ROP_XOR: SSD1306_ROP_COLUMNS(d ^ (s & m)); break;
+    }
+  }
+}
+
+// Copies whole-byte columns into the framebuffer. With the size constant
+// in each case, the memcpy becomes a single load/store per column.
+#define SSD1306_BLIT_COLUMNS(n) \
+  for (uint8_t i = 0; i < columns; ++i, dst += SSD1306_COLUMN_STRIDE, src += stride) \
+    memcpy(dst, src, n)
+
+static void ssd1306_copy_columns(uint8_t *dst, const uint8_t *src, uint8_t columns, uint8_t stride, uint8_t count)
 {
-  uint16_t index = 0;
-  char ver=c;
-  if (c >= 'A' && c <= 'Z')
+  switch (count)
   {
-    index = (c - 'A' + 11) * 8; // Para letras maiúsculas
-  }else  if (c >= '0' && c <= '9')
-  {
-    index = (c - '0' + 1) * 8; // Adiciona o deslocamento necessário
-  } else if (c >= 'a' && c <= 'z')
+  case 1: SSD1306_BLIT_COLUMNS(1); break;
+  case 2: SSD1306_BLIT_COLUMNS(2); break;
+  case 3: SSD1306_BLIT_COLUMNS(3); break;
+  case 4: SSD1306_BLIT_COLUMNS(4); break;
+  default: SSD1306_BLIT_COLUMNS(count); break;
+  }
+}
+
+// Each glyph column is already in the display's page layout and is
+// copied, shifted, into the pages the cell covers.
+void ssd1306_draw_glyph(ssd1306_t *ssd, const ssd1306_font_t *font, char c, uint8_t x, uint8_t y)
+{
+  if (x >= SSD1306_WIDTH || y >= SSD1306_HEIGHT)
+    return;
+  ssd1306_mark_dirty(ssd, x, y, x + font->width - 1, y + font->pages * 8 - 1);
+
+  const uint8_t *glyph = font_glyph(font, c);
+  uint8_t page = y >> 3;
+  uint8_t shift = y & 7;
+  uint8_t low_mask = (uint8_t)(0xFF << shift);
+  uint8_t columns = SSD1306_WIDTH - x < font->width ? SSD1306_WIDTH - x : font->width;
+
+  // Page-aligned: each glyph column is whole bytes, copied as they are
+  if (shift == 0)
   {
-    index = ((c - 'a') + FONT_LOWERCASE_OFFSET) * 8; // Para letras minúsculas
+    uint8_t count = SSD1306_PAGES - page < font->pages ? SSD1306_PAGES - page : font->pages;
+    ssd1306_copy_columns(&ssd->ram_buffer[ssd1306_index(x, page)], glyph, columns, font->pages, count);
+    return;
   }
-  
-  for (uint8_t i = 0; i < 8; ++i)
+
+  // Shift is 1 to 7 from here on, so each glyph byte always spills into
+  // the next page, unless that page is off the panel
+  for (uint8_t i = 0; i < columns; ++i, glyph += font->pages)
   {
-    uint8_t line = font[index + i];
-    for (uint8_t j = 0; j < 8; ++j)
+    uint8_t *column = &ssd->ram_buffer[ssd1306_index(x + i, 0)];
+    for (uint8_t g = 0; g < font->pages && page + g < SSD1306_PAGES; ++g)
     {
-      ssd1306_pixel(ssd, x + i, y + j, line & (1 << j));
+      uint8_t p = page + g;
+      column[p] = (column[p] & ~low_mask) | (uint8_t)(glyph[g] << shift);
+      if (p + 1 < SSD1306_PAGES)
+        column[p + 1] = (column[p + 1] & low_mask) | (glyph[g] >> (8 - shift));
     }
   }
 }
 
-// Função para desenhar uma string
-void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y)
+void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
+{
+  ssd1306_draw_glyph(ssd, &font_8x8, c, x, y);
+}
+
+// Draws a string left to right, wrapping to the next line of glyphs at the
+// right edge and stopping at the bottom one.
+void ssd1306_draw_text(ssd1306_t *ssd, const ssd1306_font_t *font, const char *str, uint8_t x, uint8_t y)
 {
   while (*str)
   {
-    ssd1306_draw_char(ssd, *str++, x, y);
-    x += 8;
-    if (x + 8 >= ssd->width)
+    ssd1306_draw_glyph(ssd, font, *str++, x, y);
+    x += font->width;
+    if (x + font->width >= SSD1306_WIDTH)
     {
       x = 0;
-      y += 8;
+      y += font->height;
     }
-    if (y + 8 >= ssd->height)
+    if (y + font->height >= SSD1306_HEIGHT)
     {
       break;
     }
   }
-}
\ No newline at end of file
+}
+
+void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y)
+{
+  ssd1306_draw_text(ssd, &font_8x8, str, x, y);
+}
@@ -1,9 +1,51 @@
+#ifndef SSD1306_H
+#define SSD1306_H
+
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "font.h"
+
+// Panel geometry, fixed at compile time: every framebuffer index is a
+// constant and the buffers live inside ssd1306_t, no heap. Supported:
+// 128x64, 128x32 and 64x48 (-DSSD1306_WIDTH, -DSSD1306_HEIGHT).
+#ifndef SSD1306_WIDTH
+#define SSD1306_WIDTH 128
+#endif
+#ifndef SSD1306_HEIGHT
+#define SSD1306_HEIGHT 64
+#endif
+
+#if SSD1306_WIDTH == 128 && SSD1306_HEIGHT == 64
+#define SSD1306_COM_PINS 0x12         // alternative COM pins, no left/right remap
+#define SSD1306_COLUMN_OFFSET 0
+#elif SSD1306_WIDTH == 128 && SSD1306_HEIGHT == 32
+#define SSD1306_COM_PINS 0x02         // sequential COM pins
+#define SSD1306_COLUMN_OFFSET 0
+#elif SSD1306_WIDTH == 64 && SSD1306_HEIGHT == 48
+#define SSD1306_COM_PINS 0x12
+#define SSD1306_COLUMN_OFFSET 32      // the glass sits on columns 32..95 of GDDRAM
+#else
+#error "unsupported SSD1306 geometry"
+#endif
+
+#define WIDTH SSD1306_WIDTH
+#define HEIGHT SSD1306_HEIGHT
+#define SSD1306_PAGES (SSD1306_HEIGHT / 8)
+#define SSD1306_BUFSIZE (SSD1306_WIDTH * SSD1306_PAGES + 1)   // control byte + GDDRAM
+
+// Every window goes out as two I2C transactions: the six addressing
+// commands behind a single 0x00 control byte, then 0x40 and the GDDRAM
+// data. Eight bytes of header instead of thirteen with a 0x80 control byte
+// before each command.
+#define SSD1306_WINDOW_HEADER 8
+// Worst case of a flush: one window per page around the whole frame.
+#define SSD1306_FRONT_SIZE (SSD1306_BUFSIZE - 1 + SSD1306_PAGES * SSD1306_WINDOW_HEADER)
 
-#define WIDTH 128
-#define HEIGHT 64
+#ifndef SSD1306_MAX_INSTANCES
+#define SSD1306_MAX_INSTANCES 2   // panels with a DMA channel
+#endif
+#define SSD1306_MAX_COMMANDS 32   // bytes per ssd1306_command_stream
 
 typedef enum {
   SET_CONTRAST = 0x81,
@@ -25,19 +67,60 @@ typedef enum {
   SET_CHARGE_PUMP = 0x8D
 } ssd1306_command_t;
 
+// A 1 bpp bitmap in the framebuffer layout: columns of `pages` bytes, row
+// 0 in bit 0, like the font glyphs. Any size; rows past height are ignored.
 typedef struct {
-  uint8_t width, height, pages, address;
+  uint8_t width, height;
+  uint8_t pages;          // bytes per column, (height + 7) / 8
+  const uint8_t *data;
+} ssd1306_bitmap_t;
+
+// What ssd1306_blit does to the pixels under the bitmap. The _INVERTED
+// modes invert the bitmap first: AND_INVERTED clears where it is set.
+typedef enum {
+  SSD1306_ROP_COPY,
+  SSD1306_ROP_OR,
+  SSD1306_ROP_AND,
+  SSD1306_ROP_XOR,
+  SSD1306_ROP_INVERTED = 4,
+  SSD1306_ROP_COPY_INVERTED = SSD1306_ROP_COPY | SSD1306_ROP_INVERTED,
+  SSD1306_ROP_OR_INVERTED = SSD1306_ROP_OR | SSD1306_ROP_INVERTED,
+  SSD1306_ROP_AND_INVERTED = SSD1306_ROP_AND | SSD1306_ROP_INVERTED,
+  SSD1306_ROP_XOR_INVERTED = SSD1306_ROP_XOR | SSD1306_ROP_INVERTED,
+} ssd1306_rop_t;
+
+typedef struct ssd1306 ssd1306_t;
+typedef void (*ssd1306_flush_callback_t)(ssd1306_t *ssd, void *data);
+
+struct ssd1306 {
+  uint8_t address;
   i2c_inst_t *i2c_port;
   bool external_vcc;
-  uint8_t *ram_buffer;
-  size_t bufsize;
-  uint8_t port_buffer[2];
-} ssd1306_t;
+  uint8_t ram_buffer[SSD1306_BUFSIZE];    // 0x40 control byte, then page + x * SSD1306_PAGES
+  uint8_t shadow_buffer[SSD1306_BUFSIZE]; // what the panel shows, same layout as ram_buffer
+  uint16_t front_buffer[SSD1306_FRONT_SIZE]; // IC_DATA_CMD words streamed by DMA
+  bool resend;                            // ignore the shadow on the next flush
+  uint8_t dirty_x0[SSD1306_PAGES];        // first dirty column per page
+  uint8_t dirty_x1[SSD1306_PAGES];        // last dirty column per page, x1 < x0 when clean
+  uint32_t bytes_sent;                    // bytes handed to the I2C controller, address bytes excluded
+  uint32_t transactions;                  // START..STOP sequences, one address byte each
+  int dma_channel;
+  ssd1306_flush_callback_t flush_callback;
+  void *flush_callback_data;
+};
 
-void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
+void ssd1306_init(ssd1306_t *ssd, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
 void ssd1306_config(ssd1306_t *ssd);
 void ssd1306_command(ssd1306_t *ssd, uint8_t command);
+void ssd1306_command_stream(ssd1306_t *ssd, const uint8_t *commands, size_t count);
 void ssd1306_send_data(ssd1306_t *ssd);
+bool ssd1306_send_data_async(ssd1306_t *ssd);
+bool ssd1306_busy(ssd1306_t *ssd);
+void ssd1306_wait(ssd1306_t *ssd);
+void ssd1306_set_flush_callback(ssd1306_t *ssd, ssd1306_flush_callback_t callback, void *data);
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+void ssd1306_invalidate(ssd1306_t *ssd);
+bool ssd1306_is_dirty(const ssd1306_t *ssd);
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value);
 void ssd1306_fill(ssd1306_t *ssd, bool value);
@@ -45,5 +128,10 @@ void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value);
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value);
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value);
+void ssd1306_blit(ssd1306_t *ssd, const ssd1306_bitmap_t *bitmap, int16_t x, int16_t y, ssd1306_rop_t rop);
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y);
-void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
\ No newline at end of file
+void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
+void ssd1306_draw_glyph(ssd1306_t *ssd, const ssd1306_font_t *font, char c, uint8_t x, uint8_t y);
+void ssd1306_draw_text(ssd1306_t *ssd, const ssd1306_font_t *font, const char *str, uint8_t x, uint8_t y);
+
+#endif // SSD1306_H
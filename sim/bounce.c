@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bounce.h"
+#include "sim_clock.h"
+#include "hardware/gpio.h"
+
+#define SIM_MAX_PLAYERS 8 ///< Waveforms playing at once
+
+#define COUNT(edges) (int)(sizeof(edges) / sizeof(edges[0]))
+
+static const sim_edge_t press_clean[] = {{0, 0}};
+static const sim_edge_t press_short[] = {
+    {0, 0}, {40, 1}, {90, 0}, {180, 1}, {210, 0}, {450, 1}, {470, 0},
+};
+static const sim_edge_t press_long[] = {
+    {0, 0}, {150, 1}, {300, 0}, {700, 1}, {800, 0}, {1500, 1},
+    {1550, 0}, {2600, 1}, {2650, 0}, {3100, 1}, {3120, 0},
+};
+static const sim_edge_t release_clean[] = {{0, 1}};
+static const sim_edge_t release_short[] = {
+    {0, 1}, {30, 0}, {60, 1}, {400, 0}, {420, 1},
+};
+static const sim_edge_t release_long[] = {
+    {0, 1}, {25, 0}, {60, 1}, {400, 0}, {420, 1}, {1200, 0}, {1210, 1},
+    {2300, 0}, {2330, 1},
+};
+static const sim_edge_t glitch[] = {{0, 0}, {20, 1}};
+
+const sim_bounce_t sim_press_bounces[] = {
+    {"clean", press_clean, COUNT(press_clean)},
+    {"short bounce", press_short, COUNT(press_short)},
+    {"long bounce", press_long, COUNT(press_long)},
+};
+const int sim_press_bounce_count = COUNT(sim_press_bounces);
+
+const sim_bounce_t sim_release_bounces[] = {
+    {"clean", release_clean, COUNT(release_clean)},
+    {"short bounce", release_short, COUNT(release_short)},
+    {"long bounce", release_long, COUNT(release_long)},
+};
+const int sim_release_bounce_count = COUNT(sim_release_bounces);
+
+const sim_bounce_t sim_glitch = {"glitch", glitch, COUNT(glitch)};
+
+typedef struct {
+    const sim_bounce_t *bounce; // NULL when the slot is free
+    uint gpio;
+    uint64_t start_us;
+    int next;
+} player_t;
+
+static player_t players[SIM_MAX_PLAYERS];
+
+// Each edge schedules the next one, so a waveform holds one event at a time.
+static void play_edge(void *context) {
+    player_t *player = context;
+    const sim_edge_t *edge = &player->bounce->edges[player->next++];
+
+    sim_gpio_set_input(player->gpio, edge->level);
+    if (player->next < player->bounce->count)
+        sim_schedule_at(player->start_us + player->bounce->edges[player->next].at_us, play_edge, player);
+    else
+        player->bounce = NULL;
+}
+
+void sim_play_bounce(uint gpio, const sim_bounce_t *bounce, uint64_t start_us) {
+    for (int i = 0; i < SIM_MAX_PLAYERS; ++i) {
+        player_t *player = &players[i];
+        if (player->bounce)
+            continue;
+        *player = (player_t){ .bounce = bounce, .gpio = gpio, .start_us = start_us };
+        sim_schedule_at(start_us + bounce->edges[0].at_us, play_edge, player);
+        return;
+    }
+    fprintf(stderr, "too many bounce waveforms playing\n");
+    exit(2);
+}
@@ -0,0 +1,45 @@
+/**
+ * @file bounce.h
+ * @brief Contact bounce waveforms for the simulated buttons.
+ *
+ * Each waveform is the list of level changes a button pin goes through
+ * when the button is pressed or released, as a logic analyser capture
+ * reduces to: the first edge, the chatter while the contacts settle and
+ * the final level. sim_play_bounce() replays one on a pin of the virtual
+ * board.
+ */
+
+#ifndef SIM_BOUNCE_H
+#define SIM_BOUNCE_H
+
+#include "pico/types.h"
+
+/**
+ * @brief One level change, relative to the first.
+ */
+typedef struct {
+    uint32_t at_us;
+    bool level;
+} sim_edge_t;
+
+/**
+ * @brief A whole waveform; the last edge gives the final level.
+ */
+typedef struct {
+    const char *name;
+    const sim_edge_t *edges;
+    int count;
+} sim_bounce_t;
+
+extern const sim_bounce_t sim_press_bounces[];   ///< Pin pulled low
+extern const int sim_press_bounce_count;
+extern const sim_bounce_t sim_release_bounces[]; ///< Pin back high
+extern const int sim_release_bounce_count;
+extern const sim_bounce_t sim_glitch;            ///< 20 us spike on an idle pin
+
+/**
+ * @brief Replays a waveform on an input pin, starting at start_us.
+ */
+void sim_play_bounce(uint gpio, const sim_bounce_t *bounce, uint64_t start_us);
+
+#endif // SIM_BOUNCE_H
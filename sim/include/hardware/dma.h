@@ -0,0 +1,74 @@
+/**
+ * @file dma.h
+ * @brief Host stand-in for the Pico SDK's hardware/dma.h.
+ *
+ * Transfers into an I2C data_cmd register are handed to the mock bus and
+ * complete on the virtual clock once the bytes would have left the wire;
+ * anything else is copied as memory and completes at once. Completion
+ * raises DMA_IRQ_0 if the channel asks for it.
+ *
+ * A channel paced by DREQ_PWM_WRAPn moves one unit at each wrap of that
+ * slice, in the background (see mock_pwm.h). Units written into a
+ * trigger register of dma_hw start the channel it belongs to, so control
+ * blocks work as on the board; being addresses, they are pointer-sized on
+ * the host.
+ */
+
+#ifndef SIM_HARDWARE_DMA_H
+#define SIM_HARDWARE_DMA_H
+
+#include "pico/types.h"
+
+#define NUM_DMA_CHANNELS 12
+
+#define DREQ_PWM_WRAP0 24
+#define DREQ_FORCE 0x3F
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+typedef struct {
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    uint dreq;
+    uint chain_to;
+    bool ring_write;
+    uint ring_size_bits; ///< 0 for no ring
+} dma_channel_config;
+
+/**
+ * @brief The registers of a channel that DMA itself writes. The pairs a
+ * ring writes are aligned like the ring, as on the board.
+ */
+typedef struct {
+    _Alignas(2 * sizeof(void *)) const volatile void *al2_read_addr;
+    volatile void *al2_write_addr_trig;
+} dma_channel_hw_t;
+
+typedef struct {
+    dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+} dma_hw_t;
+
+extern dma_hw_t *const dma_hw;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_abort(uint channel);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq0_status(uint channel);
+void dma_channel_acknowledge_irq0(uint channel);
+
+#endif // SIM_HARDWARE_DMA_H
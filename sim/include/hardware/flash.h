@@ -0,0 +1,30 @@
+/**
+ * @file flash.h
+ * @brief Host stand-in for the Pico SDK's hardware/flash.h.
+ *
+ * The flash is a RAM image (see mock_flash.h) that starts erased. Erases
+ * and programs behave like NOR flash: an erase sets every byte of the
+ * sector to 0xFF and a program can only clear bits. Both stall the virtual
+ * clock for as long as the real chip takes.
+ */
+
+#ifndef SIM_HARDWARE_FLASH_H
+#define SIM_HARDWARE_FLASH_H
+
+#include "pico/types.h"
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+
+/**
+ * @brief The image, as the firmware would see it through the XIP window.
+ */
+const uint8_t *sim_flash_xip(void);
+
+#define XIP_BASE ((uintptr_t)sim_flash_xip())
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#endif // SIM_HARDWARE_FLASH_H
@@ -0,0 +1,57 @@
+/**
+ * @file gpio.h
+ * @brief Host stand-in for the Pico SDK's hardware/gpio.h.
+ *
+ * Input levels are driven by the simulation through sim_gpio_set_input();
+ * edges matching the enabled IRQ events call the registered callback.
+ */
+
+#ifndef SIM_HARDWARE_GPIO_H
+#define SIM_HARDWARE_GPIO_H
+
+#include "pico/types.h"
+
+#define NUM_BANK0_GPIOS 30
+
+#define GPIO_IN false
+#define GPIO_OUT true
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_NULL = 0x1f,
+} gpio_function_t;
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_pull_up(uint gpio);
+void gpio_set_function(uint gpio, gpio_function_t fn);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback);
+
+/**
+ * @brief Drives an input pin from the simulation, raising GPIO IRQs.
+ */
+void sim_gpio_set_input(uint gpio, bool level);
+
+/**
+ * @brief Called after every gpio_put(), so the simulation can watch outputs.
+ */
+typedef void (*sim_gpio_output_hook_t)(uint gpio, bool value);
+void sim_gpio_set_output_hook(sim_gpio_output_hook_t hook);
+
+#endif // SIM_HARDWARE_GPIO_H
@@ -0,0 +1,52 @@
+/**
+ * @file i2c.h
+ * @brief Host stand-in for the Pico SDK's hardware/i2c.h.
+ *
+ * Writes are routed to the mock bus in mock_i2c.c, which counts traffic
+ * and feeds an SSD1306 panel model.
+ */
+
+#ifndef SIM_HARDWARE_I2C_H
+#define SIM_HARDWARE_I2C_H
+
+#include "pico/types.h"
+
+#define I2C_IC_DATA_CMD_STOP_BITS 0x00000200u
+#define I2C_IC_STATUS_TFE_BITS 0x00000004u
+#define I2C_IC_STATUS_MST_ACTIVITY_BITS 0x00000020u
+#define I2C_IC_DMA_CR_TDMAE_BITS 0x00000002u
+
+/**
+ * @brief Register block of one controller, reduced to what the project
+ * touches. Field names match the SDK's i2c_hw_t.
+ */
+typedef struct {
+    io_rw_32 tar;
+    io_rw_32 data_cmd;
+    io_rw_32 enable;
+    io_rw_32 status;
+    io_rw_32 dma_cr;
+    io_rw_32 dma_tdlr;
+} i2c_hw_t;
+
+typedef struct i2c_inst i2c_inst_t;
+
+extern i2c_inst_t sim_i2c0_inst;
+extern i2c_inst_t sim_i2c1_inst;
+
+#define i2c0 (&sim_i2c0_inst)
+#define i2c1 (&sim_i2c1_inst)
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c);
+uint i2c_get_index(i2c_inst_t *i2c);
+
+#define DREQ_I2C0_TX 32
+#define DREQ_I2C1_TX 34
+
+static inline uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx) {
+    return (i2c_get_index(i2c) ? DREQ_I2C1_TX : DREQ_I2C0_TX) + (is_tx ? 0 : 1);
+}
+
+#endif // SIM_HARDWARE_I2C_H
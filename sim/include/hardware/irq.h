@@ -0,0 +1,31 @@
+/**
+ * @file irq.h
+ * @brief Host stand-in for the Pico SDK's hardware/irq.h.
+ *
+ * Handlers are plain function pointers. sim_irq_raise() runs them the way
+ * the NVIC would, one IRQ at a time.
+ */
+
+#ifndef SIM_HARDWARE_IRQ_H
+#define SIM_HARDWARE_IRQ_H
+
+#include "pico/types.h"
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define SIM_NUM_IRQS 32
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_set_enabled(uint num, bool enabled);
+
+/**
+ * @brief Runs the handlers of an IRQ if it is enabled.
+ */
+void sim_irq_raise(uint num);
+
+#endif // SIM_HARDWARE_IRQ_H
@@ -0,0 +1,60 @@
+/**
+ * @file pwm.h
+ * @brief Host stand-in for the Pico SDK's hardware/pwm.h.
+ *
+ * The slice registers live in pwm_hw like on the board, so DMA can write
+ * them. Like the hardware, a slice takes new CC and TOP values at its
+ * next wrap; the mock works out when that is on the virtual clock (see
+ * mock_pwm.h).
+ */
+
+#ifndef SIM_HARDWARE_PWM_H
+#define SIM_HARDWARE_PWM_H
+
+#include "pico/types.h"
+
+#define NUM_PWM_SLICES 8
+
+#define PWM_CHAN_A 0
+#define PWM_CHAN_B 1
+
+#define PWM_CH0_CSR_EN_BITS 0x00000001u
+#define PWM_CH0_DIV_INT_LSB 4
+
+typedef struct {
+    io_rw_32 csr;
+    io_rw_32 div;
+    io_rw_32 ctr;
+    io_rw_32 cc;
+    io_rw_32 top;
+} pwm_slice_hw_t;
+
+typedef struct {
+    pwm_slice_hw_t slice[NUM_PWM_SLICES];
+} pwm_hw_t;
+
+extern pwm_hw_t *const pwm_hw;
+
+typedef struct {
+    uint32_t csr;
+    uint32_t div;
+    uint32_t top;
+} pwm_config;
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1u) & 7u;
+}
+
+static inline uint pwm_gpio_to_channel(uint gpio) {
+    return gpio & 1u;
+}
+
+pwm_config pwm_get_default_config(void);
+void pwm_config_set_clkdiv_int(pwm_config *c, uint div);
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap);
+void pwm_init(uint slice_num, pwm_config *c, bool start);
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level);
+void pwm_set_counter(uint slice_num, uint16_t c);
+void pwm_set_enabled(uint slice_num, bool enabled);
+
+#endif // SIM_HARDWARE_PWM_H
@@ -0,0 +1,31 @@
+/**
+ * @file sync.h
+ * @brief Host stand-in for the Pico SDK's hardware/sync.h.
+ */
+
+#ifndef SIM_HARDWARE_SYNC_H
+#define SIM_HARDWARE_SYNC_H
+
+#include "pico/types.h"
+
+static inline void __dmb(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __sev(void) {}
+
+// Events run one at a time on the host, so there is nothing to mask.
+static inline uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+/**
+ * @brief Sleep until the next event. Returns immediately on the host.
+ */
+void __wfe(void);
+
+#endif // SIM_HARDWARE_SYNC_H
@@ -0,0 +1,20 @@
+/**
+ * @file timer.h
+ * @brief Host stand-in for the Pico SDK's hardware/timer.h.
+ *
+ * Time comes from the virtual clock in sim_clock.c; it only moves when
+ * the simulation advances it.
+ */
+
+#ifndef SIM_HARDWARE_TIMER_H
+#define SIM_HARDWARE_TIMER_H
+
+#include "pico/types.h"
+
+uint64_t time_us_64(void);
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+#endif // SIM_HARDWARE_TIMER_H
@@ -0,0 +1,27 @@
+/**
+ * @file flash.h
+ * @brief Host stand-in for the Pico SDK's pico/flash.h.
+ */
+
+#ifndef SIM_PICO_FLASH_H
+#define SIM_PICO_FLASH_H
+
+#include "pico/types.h"
+
+#define PICO_OK 0
+
+/**
+ * @brief Runs func(param) at once: there is no other core to park and
+ * nothing runs from the image.
+ */
+static inline int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms) {
+    (void)enter_exit_timeout_ms;
+    func(param);
+    return PICO_OK;
+}
+
+static inline bool flash_safe_execute_core_init(void) {
+    return true;
+}
+
+#endif // SIM_PICO_FLASH_H
@@ -0,0 +1,55 @@
+/**
+ * @file stdio.h
+ * @brief Host stand-in for the Pico SDK's pico/stdio.h.
+ *
+ * Output goes to the host's stdout. Input is whatever the simulation feeds
+ * through sim_stdio_feed(), which also fires the chars-available callback
+ * like the USB CDC driver does.
+ */
+
+#ifndef SIM_PICO_STDIO_H
+#define SIM_PICO_STDIO_H
+
+#include "pico/types.h"
+
+#define PICO_ERROR_TIMEOUT (-1)
+
+static inline bool stdio_init_all(void) {
+    return true;
+}
+
+void stdio_set_chars_available_callback(void (*fn)(void *), void *param);
+
+/**
+ * @brief Next input character, or PICO_ERROR_TIMEOUT if none is queued.
+ * The simulation never waits for input, whatever the timeout.
+ */
+int getchar_timeout_us(uint32_t timeout_us);
+
+/**
+ * @brief Writes a byte as is, without CR/LF translation.
+ */
+int putchar_raw(int c);
+
+/**
+ * @brief Pushes buffered output out.
+ */
+void stdio_flush(void);
+
+/**
+ * @brief Queues text as console input and notifies the firmware.
+ */
+void sim_stdio_feed(const char *text);
+
+/**
+ * @brief Queues bytes as console input, zeros included, and notifies the
+ * firmware. Bytes that do not fit in the input buffer are dropped.
+ */
+void sim_stdio_feed_bytes(const uint8_t *data, size_t length);
+
+/**
+ * @brief Free space in the input buffer.
+ */
+size_t sim_stdio_room(void);
+
+#endif // SIM_PICO_STDIO_H
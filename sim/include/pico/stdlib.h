@@ -0,0 +1,18 @@
+/**
+ * @file stdlib.h
+ * @brief Host stand-in for the Pico SDK's pico/stdlib.h.
+ *
+ * Only the subset of the SDK used by this project is provided. The
+ * implementations live in sim/ and run against a virtual board whose
+ * clock only moves when the simulation advances it.
+ */
+
+#ifndef SIM_PICO_STDLIB_H
+#define SIM_PICO_STDLIB_H
+
+#include "pico/types.h"
+#include "pico/time.h"
+#include "pico/stdio.h"
+#include "hardware/gpio.h"
+
+#endif // SIM_PICO_STDLIB_H
@@ -0,0 +1,66 @@
+/**
+ * @file time.h
+ * @brief Host stand-in for the Pico SDK's pico/time.h.
+ *
+ * Alarms and repeating timers are scheduled on the virtual clock and fire
+ * as if from the timer IRQ when the simulation reaches them.
+ */
+
+#ifndef SIM_PICO_TIME_H
+#define SIM_PICO_TIME_H
+
+#include "pico/types.h"
+#include "hardware/timer.h"
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+
+struct repeating_timer {
+    int64_t delay_us;
+    alarm_id_t alarm_id;
+    repeating_timer_callback_t callback;
+    void *user_data;
+};
+
+static inline absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+static inline absolute_time_t from_us_since_boot(uint64_t us) {
+    return us;
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {
+    return t + us;
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return time_us_64() + (uint64_t)ms * 1000;
+}
+
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void *user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out);
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out);
+bool cancel_repeating_timer(repeating_timer_t *timer);
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+#endif // SIM_PICO_TIME_H
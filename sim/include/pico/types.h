@@ -0,0 +1,28 @@
+/**
+ * @file types.h
+ * @brief Host stand-in for the Pico SDK's pico/types.h.
+ */
+
+#ifndef SIM_PICO_TYPES_H
+#define SIM_PICO_TYPES_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+typedef volatile uint32_t io_rw_32;
+typedef volatile const uint32_t io_ro_32;
+
+typedef uint64_t absolute_time_t;
+
+#define hard_assert(x) assert(x)
+
+/**
+ * @brief Body of busy-wait loops. On the host it runs the next scheduled
+ * event, so code spinning on hardware state makes progress.
+ */
+void tight_loop_contents(void);
+
+#endif // SIM_PICO_TYPES_H
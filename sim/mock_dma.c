@@ -0,0 +1,249 @@
+#include <string.h>
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/timer.h"
+#include "mock_i2c.h"
+#include "mock_pwm.h"
+#include "sim_clock.h"
+
+#define SIM_MAX_SHARED_HANDLERS 4
+
+typedef struct {
+    bool claimed;
+    bool busy;
+    bool irq0_enabled;
+    bool irq0_status;
+    dma_channel_config config;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint transfer_count; ///< Loaded into remaining at each trigger
+    uint remaining;
+    int event;           ///< Pending completion
+} mock_dma_channel_t;
+
+static mock_dma_channel_t channels[NUM_DMA_CHANNELS];
+static dma_hw_t registers;
+dma_hw_t *const dma_hw = &registers;
+
+static struct {
+    bool enabled;
+    irq_handler_t handlers[SIM_MAX_SHARED_HANDLERS];
+} irqs[SIM_NUM_IRQS];
+
+int dma_claim_unused_channel(bool required) {
+    for (uint i = 0; i < NUM_DMA_CHANNELS; ++i) {
+        if (!channels[i].claimed) {
+            channels[i].claimed = true;
+            return (int)i;
+        }
+    }
+    hard_assert(!required);
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    memset(&channels[channel], 0, sizeof(channels[channel]));
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config c = {
+        .size = DMA_SIZE_32,
+        .read_increment = true,
+        .write_increment = false,
+        .dreq = DREQ_FORCE,
+        .chain_to = channel,
+    };
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    c->size = size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    c->read_increment = incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    c->write_increment = incr;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->dreq = dreq;
+}
+
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    c->ring_write = write;
+    c->ring_size_bits = size_bits;
+}
+
+static void start(uint channel);
+
+static void dma_complete(void *context) {
+    mock_dma_channel_t *ch = context;
+    ch->event = 0;
+    ch->busy = false;
+    if (ch->irq0_enabled) {
+        ch->irq0_status = true;
+        sim_irq_raise(DMA_IRQ_0);
+    }
+}
+
+// Transfers with nothing on a wire and no interrupt to raise end at once
+static void finish(mock_dma_channel_t *ch, uint64_t duration_ns) {
+    if (!duration_ns && !ch->irq0_enabled) {
+        ch->busy = false;
+        return;
+    }
+    ch->event = sim_schedule_at(time_us_64() + (duration_ns + 999) / 1000, dma_complete, ch);
+}
+
+static bool in_registers(volatile void *address) {
+    return (uintptr_t)address - (uintptr_t)&registers < sizeof(registers);
+}
+
+/**
+ * @brief Steps an address by one unit, wrapping inside its ring if it has
+ * one. The ring holds the same number of units as on the board.
+ */
+static uintptr_t advance(uintptr_t address, size_t unit, const dma_channel_config *config, bool write) {
+    uintptr_t next = address + unit;
+    if (config->ring_size_bits && config->ring_write == write) {
+        uintptr_t ring = (((uintptr_t)1 << config->ring_size_bits) >> config->size) * unit;
+        next = (address & ~(ring - 1)) | (next & (ring - 1));
+    }
+    return next;
+}
+
+/**
+ * @brief A write into dma_hw. Writing a trigger register starts the
+ * channel, unless the value is 0: a null trigger starts nothing.
+ */
+static void register_written(volatile void *address) {
+    for (uint n = 0; n < NUM_DMA_CHANNELS; ++n) {
+        dma_channel_hw_t *hw = &registers.ch[n];
+        if (address == (volatile void *)&hw->al2_read_addr) {
+            channels[n].read_addr = hw->al2_read_addr;
+        } else if (address == (volatile void *)&hw->al2_write_addr_trig) {
+            channels[n].write_addr = hw->al2_write_addr_trig;
+            if (hw->al2_write_addr_trig)
+                start(n);
+        }
+    }
+}
+
+static void move(mock_dma_channel_t *ch) {
+    volatile void *dst = ch->write_addr;
+    bool to_registers = in_registers(dst);
+    size_t unit = to_registers ? sizeof(void *) : 1u << ch->config.size;
+
+    memcpy((void *)dst, (const void *)ch->read_addr, unit);
+    if (ch->config.read_increment)
+        ch->read_addr = (const volatile void *)advance((uintptr_t)ch->read_addr, unit, &ch->config, false);
+    if (ch->config.write_increment)
+        ch->write_addr = (volatile void *)advance((uintptr_t)dst, unit, &ch->config, true);
+
+    if (to_registers)
+        register_written(dst);
+    else
+        mock_pwm_written(dst);
+}
+
+static bool paced_by_pwm(const mock_dma_channel_t *ch) {
+    return ch->config.dreq >= DREQ_PWM_WRAP0 && ch->config.dreq < DREQ_PWM_WRAP0 + NUM_PWM_SLICES;
+}
+
+// One unit per wrap of the pacing slice
+static void paced(void *context) {
+    mock_dma_channel_t *ch = context;
+    ch->remaining--;
+    move(ch);
+    if (ch->remaining)
+        mock_pwm_wait_wrap(ch->config.dreq - DREQ_PWM_WRAP0, paced, ch);
+    else
+        finish(ch, 0);
+}
+
+static void start(uint channel) {
+    mock_dma_channel_t *ch = &channels[channel];
+    uint64_t duration_ns = 0;
+
+    ch->busy = true;
+    ch->remaining = ch->transfer_count;
+    if (paced_by_pwm(ch)) {
+        mock_pwm_wait_wrap(ch->config.dreq - DREQ_PWM_WRAP0, paced, ch);
+        return;
+    }
+    if (mock_i2c_dma_write(ch->write_addr, (const uint16_t *)ch->read_addr, ch->remaining, &duration_ns))
+        ch->remaining = 0;
+    while (ch->remaining) {
+        ch->remaining--;
+        move(ch);
+    }
+    finish(ch, duration_ns);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+    mock_dma_channel_t *ch = &channels[channel];
+    ch->config = *config;
+    ch->write_addr = write_addr;
+    ch->read_addr = read_addr;
+    ch->transfer_count = transfer_count;
+    if (trigger)
+        start(channel);
+}
+
+void dma_channel_abort(uint channel) {
+    mock_dma_channel_t *ch = &channels[channel];
+    if (ch->busy && paced_by_pwm(ch))
+        mock_pwm_cancel_wait(ch->config.dreq - DREQ_PWM_WRAP0);
+    if (ch->event)
+        sim_cancel(ch->event);
+    ch->event = 0;
+    ch->remaining = 0;
+    ch->busy = false;
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return channels[channel].busy;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    channels[channel].irq0_enabled = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel) {
+    return channels[channel].irq0_status;
+}
+
+void dma_channel_acknowledge_irq0(uint channel) {
+    channels[channel].irq0_status = false;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    memset(irqs[num].handlers, 0, sizeof(irqs[num].handlers));
+    irqs[num].handlers[0] = handler;
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    (void)order_priority;
+    for (int i = 0; i < SIM_MAX_SHARED_HANDLERS; ++i) {
+        if (!irqs[num].handlers[i]) {
+            irqs[num].handlers[i] = handler;
+            return;
+        }
+    }
+    hard_assert(false);
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    irqs[num].enabled = enabled;
+}
+
+void sim_irq_raise(uint num) {
+    if (!irqs[num].enabled)
+        return;
+    for (int i = 0; i < SIM_MAX_SHARED_HANDLERS && irqs[num].handlers[i]; ++i)
+        irqs[num].handlers[i]();
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <string.h>
+#include "mock_flash.h"
+#include "sim_clock.h"
+
+static uint8_t image[PICO_FLASH_SIZE_BYTES];
+static bool image_ready;
+static mock_flash_stats_t stats;
+static bool cut_pending;
+static uint32_t cut_bytes_left;
+static bool powered_off;
+
+static void ensure_image(void) {
+    if (!image_ready) {
+        memset(image, 0xFF, sizeof(image));
+        image_ready = true;
+    }
+}
+
+const uint8_t *sim_flash_xip(void) {
+    ensure_image();
+    return image;
+}
+
+void mock_flash_reset(void) {
+    memset(image, 0xFF, sizeof(image));
+    image_ready = true;
+    memset(&stats, 0, sizeof(stats));
+    cut_pending = false;
+    powered_off = false;
+}
+
+bool mock_flash_load(const char *path) {
+    ensure_image();
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return true;
+    size_t n = fread(image, 1, sizeof(image), f);
+    fclose(f);
+    return n == sizeof(image);
+}
+
+bool mock_flash_save(const char *path) {
+    ensure_image();
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+    size_t n = fwrite(image, 1, sizeof(image), f);
+    return fclose(f) == 0 && n == sizeof(image);
+}
+
+void mock_flash_cut_after(uint32_t bytes) {
+    cut_pending = true;
+    cut_bytes_left = bytes;
+}
+
+void mock_flash_power_on(void) {
+    cut_pending = false;
+    powered_off = false;
+}
+
+bool mock_flash_cut(void) {
+    return powered_off;
+}
+
+const mock_flash_stats_t *mock_flash_stats(void) {
+    return &stats;
+}
+
+// How many of count bytes get written before the power goes
+static size_t powered_bytes(size_t count) {
+    if (powered_off)
+        return 0;
+    if (!cut_pending || cut_bytes_left >= count) {
+        if (cut_pending)
+            cut_bytes_left -= (uint32_t)count;
+        return count;
+    }
+    size_t done = cut_bytes_left;
+    powered_off = true;
+    cut_pending = false;
+    return done;
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    hard_assert(flash_offs % FLASH_SECTOR_SIZE == 0 && count % FLASH_SECTOR_SIZE == 0);
+    hard_assert(flash_offs + count <= sizeof(image));
+    ensure_image();
+    for (size_t done = 0; done < count; done += FLASH_SECTOR_SIZE) {
+        // A sector cut short is left partly erased
+        size_t n = powered_bytes(FLASH_SECTOR_SIZE);
+        if (n == 0)
+            return;
+        memset(&image[flash_offs + done], 0xFF, n);
+        stats.erases++;
+        stats.sector_erases[(flash_offs + done) / FLASH_SECTOR_SIZE]++;
+        stats.busy_us += MOCK_FLASH_ERASE_US;
+        sim_stall_us(MOCK_FLASH_ERASE_US);
+    }
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    hard_assert(flash_offs % FLASH_PAGE_SIZE == 0 && count % FLASH_PAGE_SIZE == 0);
+    hard_assert(flash_offs + count <= sizeof(image));
+    ensure_image();
+    for (size_t done = 0; done < count; done += FLASH_PAGE_SIZE) {
+        // Bytes go out in order, so a cut leaves the start of the page
+        size_t n = powered_bytes(FLASH_PAGE_SIZE);
+        if (n == 0)
+            return;
+        for (size_t i = 0; i < n; ++i)
+            image[flash_offs + done + i] &= data[done + i];
+        stats.programs++;
+        stats.busy_us += MOCK_FLASH_PROGRAM_US;
+        sim_stall_us(MOCK_FLASH_PROGRAM_US);
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * @file mock_flash.h
+ * @brief Host-side flash image behind hardware/flash.h.
+ *
+ * The image can be loaded from and saved to a file, so settings survive
+ * from one simulator run to the next, and a power cut can be scheduled in
+ * the middle of an erase or program to test recovery.
+ */
+
+#ifndef MOCK_FLASH_H
+#define MOCK_FLASH_H
+
+#include "hardware/flash.h"
+
+#define MOCK_FLASH_ERASE_US 45000 ///< Sector erase, typical for the W25Q16
+#define MOCK_FLASH_PROGRAM_US 800 ///< Page program, typical
+
+/**
+ * @brief Operation counters.
+ */
+typedef struct {
+    uint32_t erases;
+    uint32_t programs;
+    uint64_t busy_us;                  ///< Virtual time spent stalled in flash operations
+    uint32_t sector_erases[PICO_FLASH_SIZE_BYTES / FLASH_SECTOR_SIZE];
+} mock_flash_stats_t;
+
+/**
+ * @brief Erases the whole image and clears the counters and any cut.
+ */
+void mock_flash_reset(void);
+
+/**
+ * @brief Loads the image from a file. A missing file leaves it erased.
+ *
+ * @return false if the file exists but could not be read whole.
+ */
+bool mock_flash_load(const char *path);
+
+/**
+ * @brief Saves the image to a file.
+ */
+bool mock_flash_save(const char *path);
+
+/**
+ * @brief Cuts the power after the given number of bytes have been erased
+ * or programmed. From then on erases and programs do nothing, as if the
+ * board were off, until mock_flash_power_on().
+ */
+void mock_flash_cut_after(uint32_t bytes);
+
+/**
+ * @brief Ends a power cut; the image keeps whatever was written before it.
+ */
+void mock_flash_power_on(void);
+
+/**
+ * @brief Whether a scheduled cut has happened.
+ */
+bool mock_flash_cut(void);
+
+const mock_flash_stats_t *mock_flash_stats(void);
+
+#endif // MOCK_FLASH_H
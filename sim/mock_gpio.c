@@ -0,0 +1,69 @@
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+typedef struct {
+    bool out;
+    bool level;
+    uint32_t irq_mask;
+    gpio_function_t function;
+} mock_gpio_t;
+
+static mock_gpio_t pins[NUM_BANK0_GPIOS];
+static gpio_irq_callback_t irq_callback;
+static sim_gpio_output_hook_t output_hook;
+
+void gpio_init(uint gpio) {
+    pins[gpio] = (mock_gpio_t){ .function = GPIO_FUNC_SIO };
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    pins[gpio].out = out;
+}
+
+// Nothing drives the inputs until the simulation does, so a pull-up
+// leaves them high, like an unpressed button.
+void gpio_pull_up(uint gpio) {
+    if (!pins[gpio].out)
+        pins[gpio].level = true;
+}
+
+void gpio_set_function(uint gpio, gpio_function_t fn) {
+    pins[gpio].function = fn;
+}
+
+void gpio_put(uint gpio, bool value) {
+    pins[gpio].level = value;
+    if (output_hook)
+        output_hook(gpio, value);
+}
+
+bool gpio_get(uint gpio) {
+    return pins[gpio].level;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+    if (enabled)
+        pins[gpio].irq_mask |= event_mask;
+    else
+        pins[gpio].irq_mask &= ~event_mask;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+    irq_callback = callback;
+}
+
+void sim_gpio_set_input(uint gpio, bool level) {
+    bool was = pins[gpio].level;
+    pins[gpio].level = level;
+    if (was == level)
+        return;
+
+    uint32_t event = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if ((pins[gpio].irq_mask & event) && irq_callback)
+        irq_callback(gpio, event);
+}
+
+void sim_gpio_set_output_hook(sim_gpio_output_hook_t hook) {
+    output_hook = hook;
+}
@@ -0,0 +1,203 @@
+#include <string.h>
+#include "mock_i2c.h"
+#include "hardware/timer.h"
+
+// SSD1306 commands that move the GDDRAM address pointer.
+#define CMD_SET_MEM_ADDR 0x20
+#define CMD_SET_COL_ADDR 0x21
+#define CMD_SET_PAGE_ADDR 0x22
+
+struct i2c_inst {
+    uint index;
+    uint baudrate;
+    i2c_hw_t hw;
+    mock_i2c_stats_t stats;
+
+    // Transaction being clocked out
+    bool in_transaction;
+    uint32_t bits;
+    bool expect_control;
+    uint8_t control;
+    uint64_t dma_until_us; ///< End of the DMA transfer on the wire
+
+    // SSD1306 model
+    uint8_t gddram[MOCK_SSD1306_COLUMNS * MOCK_SSD1306_PAGES];
+    uint8_t mem_mode;
+    uint8_t col_start, col_end, page_start, page_end;
+    uint8_t col, page;
+    uint8_t pending_cmd;
+    uint8_t pending_args;
+    uint8_t args[2];
+};
+
+#define MOCK_I2C_INIT(n) { \
+    .index = n, .baudrate = 100000, .hw = { .status = I2C_IC_STATUS_TFE_BITS }, \
+    .mem_mode = 2, .col_end = 127, .page_end = 7 }
+
+i2c_inst_t sim_i2c0_inst = MOCK_I2C_INIT(0);
+i2c_inst_t sim_i2c1_inst = MOCK_I2C_INIT(1);
+
+static uint8_t command_args(uint8_t cmd) {
+    switch (cmd) {
+    case CMD_SET_COL_ADDR:
+    case CMD_SET_PAGE_ADDR:
+        return 2;
+    case CMD_SET_MEM_ADDR:
+    case 0x81: // contrast
+    case 0x8D: // charge pump
+    case 0xA8: // mux ratio
+    case 0xD3: // display offset
+    case 0xD5: // clock divide
+    case 0xD9: // precharge
+    case 0xDA: // COM pins
+    case 0xDB: // VCOM deselect
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static void panel_command(i2c_inst_t *i2c, uint8_t byte) {
+    if (i2c->pending_args == 0) {
+        i2c->pending_cmd = byte;
+        i2c->pending_args = command_args(byte);
+        return;
+    }
+
+    uint8_t n = command_args(i2c->pending_cmd) - i2c->pending_args;
+    i2c->args[n] = byte;
+    if (--i2c->pending_args)
+        return;
+
+    switch (i2c->pending_cmd) {
+    case CMD_SET_MEM_ADDR:
+        i2c->mem_mode = i2c->args[0] & 0x03;
+        break;
+    case CMD_SET_COL_ADDR:
+        i2c->col_start = i2c->col = i2c->args[0] & 0x7F;
+        i2c->col_end = i2c->args[1] & 0x7F;
+        break;
+    case CMD_SET_PAGE_ADDR:
+        i2c->page_start = i2c->page = i2c->args[0] & 0x07;
+        i2c->page_end = i2c->args[1] & 0x07;
+        break;
+    }
+}
+
+static void panel_data(i2c_inst_t *i2c, uint8_t byte) {
+    i2c->gddram[i2c->page + i2c->col * MOCK_SSD1306_PAGES] = byte;
+    i2c->stats.data_bytes++;
+
+    if (i2c->mem_mode == 1) { // vertical
+        if (i2c->page++ == i2c->page_end) {
+            i2c->page = i2c->page_start;
+            i2c->col = (i2c->col == i2c->col_end) ? i2c->col_start : i2c->col + 1;
+        }
+    } else if (i2c->mem_mode == 0) { // horizontal
+        if (i2c->col++ == i2c->col_end) {
+            i2c->col = i2c->col_start;
+            i2c->page = (i2c->page == i2c->page_end) ? i2c->page_start : i2c->page + 1;
+        }
+    } else { // page
+        if (i2c->col++ == 127)
+            i2c->col = 127;
+    }
+}
+
+// START and address byte: 9 clocks per byte (ACK included) plus START.
+static void bus_start(i2c_inst_t *i2c) {
+    i2c->in_transaction = true;
+    i2c->expect_control = true;
+    i2c->stats.transactions++;
+    i2c->stats.bytes++;
+    i2c->bits = 1 + 9;
+}
+
+// Control byte: Co (bit 7) set means one byte follows before the next
+// control byte, D/C# (bit 6) selects data or command.
+static void bus_byte(i2c_inst_t *i2c, uint8_t byte) {
+    i2c->stats.bytes++;
+    i2c->bits += 9;
+
+    if (i2c->expect_control) {
+        i2c->control = byte;
+        i2c->expect_control = false;
+        return;
+    }
+    if (i2c->control & 0x40)
+        panel_data(i2c, byte);
+    else
+        panel_command(i2c, byte);
+    if (i2c->control & 0x80)
+        i2c->expect_control = true;
+}
+
+static void bus_stop(i2c_inst_t *i2c) {
+    i2c->bits += 1;
+    i2c->stats.bus_time_ns += (uint64_t)i2c->bits * 1000000000ull / i2c->baudrate;
+    i2c->in_transaction = false;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    if (time_us_64() < i2c->dma_until_us)
+        i2c->stats.overlaps++;
+    i2c->hw.tar = addr;
+    if (!i2c->in_transaction)
+        bus_start(i2c);
+    for (size_t i = 0; i < len; ++i)
+        bus_byte(i2c, src[i]);
+    if (!nostop)
+        bus_stop(i2c);
+    return (int)len;
+}
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) {
+    return &i2c->hw;
+}
+
+uint i2c_get_index(i2c_inst_t *i2c) {
+    return i2c->index;
+}
+
+bool mock_i2c_dma_write(volatile void *write_addr, const uint16_t *words, size_t count, uint64_t *bus_time_ns) {
+    i2c_inst_t *i2c;
+    if (write_addr == &sim_i2c0_inst.hw.data_cmd)
+        i2c = &sim_i2c0_inst;
+    else if (write_addr == &sim_i2c1_inst.hw.data_cmd)
+        i2c = &sim_i2c1_inst;
+    else
+        return false;
+
+    uint64_t now = time_us_64();
+    if (now < i2c->dma_until_us)
+        i2c->stats.overlaps++;
+    uint64_t start_ns = i2c->stats.bus_time_ns;
+    for (size_t i = 0; i < count; ++i) {
+        if (!i2c->in_transaction)
+            bus_start(i2c);
+        bus_byte(i2c, words[i] & 0xFF);
+        if (words[i] & I2C_IC_DATA_CMD_STOP_BITS)
+            bus_stop(i2c);
+    }
+    *bus_time_ns = i2c->stats.bus_time_ns - start_ns;
+    // Same rounding as the DMA completion
+    i2c->dma_until_us = now + (*bus_time_ns + 999) / 1000;
+    return true;
+}
+
+void mock_i2c_reset_stats(i2c_inst_t *i2c) {
+    memset(&i2c->stats, 0, sizeof(i2c->stats));
+}
+
+const mock_i2c_stats_t *mock_i2c_stats(i2c_inst_t *i2c) {
+    return &i2c->stats;
+}
+
+const uint8_t *mock_ssd1306_gddram(i2c_inst_t *i2c) {
+    return i2c->gddram;
+}
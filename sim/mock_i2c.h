@@ -0,0 +1,58 @@
+/**
+ * @file mock_i2c.h
+ * @brief Host-side mock of the RP2040 I2C controllers.
+ *
+ * Every write is counted and decoded as SSD1306 traffic, so the mock keeps
+ * a copy of the panel's GDDRAM. Benchmarks use it to measure bus usage and
+ * to check that what reached the panel matches the driver's framebuffer.
+ * Each bus is modelled on its own, so transfers on i2c0 and i2c1 overlap
+ * in time; a write on a bus whose DMA transfer is still on the wire is
+ * counted as an overlap, which the real controller would garble.
+ */
+
+#ifndef MOCK_I2C_H
+#define MOCK_I2C_H
+
+#include "hardware/i2c.h"
+
+#define MOCK_SSD1306_COLUMNS 128 ///< GDDRAM columns of the panel model
+#define MOCK_SSD1306_PAGES 8     ///< GDDRAM pages of the panel model
+
+/**
+ * @brief Traffic counters for one bus.
+ */
+typedef struct {
+    uint32_t transactions;  ///< START..STOP sequences
+    uint64_t bytes;         ///< Bytes on the wire, address byte included
+    uint64_t data_bytes;    ///< GDDRAM bytes written to the panel
+    uint64_t bus_time_ns;   ///< Time the bus was busy at the configured speed
+    uint32_t overlaps;      ///< Writes started while a DMA transfer still held the bus
+} mock_i2c_stats_t;
+
+/**
+ * @brief Clears the traffic counters of a bus. The panel state is kept.
+ */
+void mock_i2c_reset_stats(i2c_inst_t *i2c);
+
+/**
+ * @brief Returns the traffic counters of a bus.
+ */
+const mock_i2c_stats_t *mock_i2c_stats(i2c_inst_t *i2c);
+
+/**
+ * @brief Returns the GDDRAM of the panel on a bus, column-major like the
+ * driver's framebuffer: byte (page + column * MOCK_SSD1306_PAGES).
+ */
+const uint8_t *mock_ssd1306_gddram(i2c_inst_t *i2c);
+
+/**
+ * @brief Feeds IC_DATA_CMD words written by DMA to the bus they belong to.
+ *
+ * The panel model is updated at once; bus_time_ns receives how long the
+ * words take on the wire, which is when the DMA transfer completes.
+ *
+ * @return false if write_addr is not the data_cmd register of a bus.
+ */
+bool mock_i2c_dma_write(volatile void *write_addr, const uint16_t *words, size_t count, uint64_t *bus_time_ns);
+
+#endif // MOCK_I2C_H
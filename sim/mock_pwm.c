@@ -0,0 +1,196 @@
+#include <stdint.h>
+#include "hardware/timer.h"
+#include "mock_pwm.h"
+
+#define SYS_CLOCK_NS 8 ///< 125 MHz
+
+typedef struct {
+    mock_pwm_slice_t state; ///< In effect, the registers being what was written last
+    int64_t origin_ns;      ///< When the counter last wrapped
+    uint64_t latch_ns;      ///< Next wrap, when latch_event takes the registers
+    int latch_event;
+    int wait_event;
+    sim_event_fn_t waiter;
+    void *waiter_context;
+} slice_model_t;
+
+static pwm_hw_t registers;
+pwm_hw_t *const pwm_hw = &registers;
+
+static slice_model_t slices[NUM_PWM_SLICES];
+static mock_pwm_hook_t pwm_hook;
+
+static uint64_t now_ns(void) {
+    return time_us_64() * 1000;
+}
+
+static void *slice_context(uint slice) {
+    return (void *)(uintptr_t)slice;
+}
+
+// The divider is 8.4 fixed point
+static uint64_t counts_ns(uint32_t div, uint64_t counts) {
+    return counts * div * SYS_CLOCK_NS / 16;
+}
+
+static uint64_t next_wrap_ns(const slice_model_t *s, uint64_t after_ns) {
+    uint64_t period = counts_ns(s->state.div, s->state.top + 1ull);
+    uint64_t elapsed = (uint64_t)((int64_t)after_ns - s->origin_ns);
+    return (uint64_t)(s->origin_ns + (int64_t)((elapsed / period + 1) * period));
+}
+
+static uint64_t event_us(uint64_t time_ns) {
+    return (time_ns + 999) / 1000;
+}
+
+static void wrapped(void *context) {
+    slice_model_t *s = &slices[(uintptr_t)context];
+    sim_event_fn_t fn = s->waiter;
+    s->wait_event = 0;
+    s->waiter = NULL;
+    fn(s->waiter_context);
+}
+
+// The next wrap moves whenever the period or the phase changes
+static void schedule_waiter(uint slice) {
+    slice_model_t *s = &slices[slice];
+    if (s->wait_event)
+        sim_cancel(s->wait_event);
+    s->wait_event = 0;
+    if (s->waiter && s->state.enabled)
+        s->wait_event = sim_schedule_background_at(event_us(next_wrap_ns(s, now_ns())), wrapped,
+                                                   slice_context(slice));
+}
+
+static bool take_registers(uint slice) {
+    slice_model_t *s = &slices[slice];
+    const pwm_slice_hw_t *r = &pwm_hw->slice[slice];
+    bool changed = s->state.div != r->div || s->state.top != r->top || s->state.cc != r->cc;
+    s->state.div = r->div;
+    s->state.top = r->top;
+    s->state.cc = r->cc;
+    return changed;
+}
+
+static void latch(void *context) {
+    uint slice = (uint)(uintptr_t)context;
+    slice_model_t *s = &slices[slice];
+
+    s->latch_event = 0;
+    s->origin_ns = (int64_t)s->latch_ns;
+    if (take_registers(slice) && pwm_hook)
+        pwm_hook(slice, s->latch_ns, &s->state);
+    schedule_waiter(slice);
+}
+
+static void cancel_latch(slice_model_t *s) {
+    if (s->latch_event)
+        sim_cancel(s->latch_event);
+    s->latch_event = 0;
+}
+
+/**
+ * @brief Follows a write to the registers of a slice. CC and TOP are
+ * double-buffered while it runs; a stopped slice takes them at once.
+ */
+static void update(uint slice) {
+    slice_model_t *s = &slices[slice];
+    const pwm_slice_hw_t *r = &pwm_hw->slice[slice];
+    bool enabled = (r->csr & PWM_CH0_CSR_EN_BITS) != 0;
+    bool was_enabled = s->state.enabled;
+
+    if (enabled && was_enabled) {
+        if (!s->latch_event) {
+            s->latch_ns = next_wrap_ns(s, now_ns());
+            s->latch_event = sim_schedule_background_at(event_us(s->latch_ns), latch, slice_context(slice));
+        }
+        return;
+    }
+
+    cancel_latch(s);
+    bool changed = take_registers(slice) || enabled != was_enabled;
+    s->state.enabled = enabled;
+    if (enabled && !was_enabled)
+        s->origin_ns = (int64_t)now_ns() - (int64_t)counts_ns(r->div, r->ctr);
+    if (changed && (enabled || was_enabled) && pwm_hook)
+        pwm_hook(slice, now_ns(), &s->state);
+    schedule_waiter(slice);
+}
+
+pwm_config pwm_get_default_config(void) {
+    pwm_config c = {.csr = 0, .div = 1u << PWM_CH0_DIV_INT_LSB, .top = 0xFFFF};
+    return c;
+}
+
+void pwm_config_set_clkdiv_int(pwm_config *c, uint div) {
+    c->div = div << PWM_CH0_DIV_INT_LSB;
+}
+
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap) {
+    c->top = wrap;
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start) {
+    pwm_slice_hw_t *r = &pwm_hw->slice[slice_num];
+    r->csr = 0;
+    update(slice_num);
+    r->ctr = 0;
+    r->cc = 0;
+    r->top = c->top;
+    r->div = c->div;
+    r->csr = c->csr | (start ? PWM_CH0_CSR_EN_BITS : 0);
+    update(slice_num);
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level) {
+    pwm_slice_hw_t *r = &pwm_hw->slice[slice_num];
+    uint shift = chan ? 16 : 0;
+    r->cc = (r->cc & ~(0xFFFFu << shift)) | (uint32_t)level << shift;
+    update(slice_num);
+}
+
+void pwm_set_counter(uint slice_num, uint16_t c) {
+    slice_model_t *s = &slices[slice_num];
+    pwm_hw->slice[slice_num].ctr = c;
+    if (!s->state.enabled)
+        return;
+    s->origin_ns = (int64_t)now_ns() - (int64_t)counts_ns(s->state.div, c);
+    if (s->latch_event) {
+        cancel_latch(s);
+        update(slice_num);
+    }
+    schedule_waiter(slice_num);
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled) {
+    pwm_slice_hw_t *r = &pwm_hw->slice[slice_num];
+    r->csr = enabled ? r->csr | PWM_CH0_CSR_EN_BITS : r->csr & ~PWM_CH0_CSR_EN_BITS;
+    update(slice_num);
+}
+
+void mock_pwm_set_hook(mock_pwm_hook_t hook) {
+    pwm_hook = hook;
+}
+
+const mock_pwm_slice_t *mock_pwm_slice(uint slice) {
+    return &slices[slice].state;
+}
+
+bool mock_pwm_written(volatile void *address) {
+    uintptr_t offset = (uintptr_t)address - (uintptr_t)&registers;
+    if (offset >= sizeof(registers))
+        return false;
+    update((uint)(offset / sizeof(pwm_slice_hw_t)));
+    return true;
+}
+
+void mock_pwm_wait_wrap(uint slice, sim_event_fn_t fn, void *context) {
+    slices[slice].waiter = fn;
+    slices[slice].waiter_context = context;
+    schedule_waiter(slice);
+}
+
+void mock_pwm_cancel_wait(uint slice) {
+    slices[slice].waiter = NULL;
+    schedule_waiter(slice);
+}
@@ -0,0 +1,60 @@
+/**
+ * @file mock_pwm.h
+ * @brief Host-side model of the RP2040 PWM slices behind hardware/pwm.h.
+ *
+ * Each slice keeps the values in effect apart from its registers. A write
+ * to CC or TOP takes effect at the slice's next wrap, worked out on the
+ * virtual clock from when the slice started counting; enabling or
+ * disabling it takes effect at once. A hook sees every change of what a
+ * slice outputs, so the simulation can follow the buzzer. Wraps are also
+ * what paces DMA on DREQ_PWM_WRAPn; they are only put on the clock while
+ * a channel waits for one.
+ */
+
+#ifndef MOCK_PWM_H
+#define MOCK_PWM_H
+
+#include "hardware/pwm.h"
+#include "sim_clock.h"
+
+/**
+ * @brief What a slice outputs.
+ */
+typedef struct {
+    bool enabled;
+    uint32_t div; ///< Clock divider, 8.4 fixed point like the DIV register
+    uint32_t top;
+    uint32_t cc;  ///< Level of channel A in the low half, B in the high half
+} mock_pwm_slice_t;
+
+/**
+ * @brief Called whenever what a slice outputs changes, with the time of
+ * the change in nanoseconds.
+ */
+typedef void (*mock_pwm_hook_t)(uint slice, uint64_t time_ns, const mock_pwm_slice_t *state);
+void mock_pwm_set_hook(mock_pwm_hook_t hook);
+
+/**
+ * @brief What a slice outputs now.
+ */
+const mock_pwm_slice_t *mock_pwm_slice(uint slice);
+
+/**
+ * @brief Tells the model that DMA wrote into pwm_hw.
+ *
+ * @return false if address is not a PWM register.
+ */
+bool mock_pwm_written(volatile void *address);
+
+/**
+ * @brief Runs fn(context) in the background at the slice's next wrap, or
+ * at the first one after it is enabled. One waiter per slice.
+ */
+void mock_pwm_wait_wrap(uint slice, sim_event_fn_t fn, void *context);
+
+/**
+ * @brief Drops the waiter of a slice.
+ */
+void mock_pwm_cancel_wait(uint slice);
+
+#endif // MOCK_PWM_H
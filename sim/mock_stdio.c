@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdio.h"
+
+#define SIM_STDIN_SIZE 256
+
+static char input[SIM_STDIN_SIZE];
+static uint32_t input_head, input_tail;
+static void (*chars_available)(void *);
+static void *chars_available_param;
+
+void stdio_set_chars_available_callback(void (*fn)(void *), void *param) {
+    chars_available = fn;
+    chars_available_param = param;
+    // Input that came before the console was ready is not lost either
+    if (fn && input_head != input_tail)
+        fn(param);
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    if (input_tail == input_head)
+        return PICO_ERROR_TIMEOUT;
+    return (unsigned char)input[input_tail++ % SIM_STDIN_SIZE];
+}
+
+int putchar_raw(int c) {
+    return putchar(c);
+}
+
+void stdio_flush(void) {
+    fflush(stdout);
+}
+
+void sim_stdio_feed(const char *text) {
+    sim_stdio_feed_bytes((const uint8_t *)text, strlen(text));
+}
+
+void sim_stdio_feed_bytes(const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length && input_head - input_tail < SIM_STDIN_SIZE; ++i)
+        input[input_head++ % SIM_STDIN_SIZE] = (char)data[i];
+    if (chars_available)
+        chars_available(chars_available_param);
+}
+
+size_t sim_stdio_room(void) {
+    return SIM_STDIN_SIZE - (input_head - input_tail);
+}
@@ -0,0 +1,325 @@
+#include <setjmp.h>
+#include <time.h>
+#include "sim_clock.h"
+#include "pico/time.h"
+#include "hardware/sync.h"
+
+#define SIM_MAX_ALARMS 16
+
+typedef struct {
+    bool used;
+    uint64_t time_us;
+    uint64_t seq;       // keeps events at the same time in FIFO order
+    sim_event_fn_t fn;
+    void *context;
+    int handle;
+    bool background;    // hardware running on its own, see sim_schedule_background_at()
+} sim_event_t;
+
+typedef struct {
+    alarm_id_t id;      // 0 when the slot is free
+    alarm_callback_t callback;
+    void *user_data;
+    uint64_t target_us;
+    int event;
+} sim_alarm_t;
+
+static uint64_t now_us;
+static uint64_t limit_us = UINT64_MAX;
+static uint64_t next_seq;
+static uint64_t events_run;
+static int next_handle = 1;
+static sim_event_t events[SIM_MAX_EVENTS];
+static bool ran_background; ///< The last sim_step() ran a background event
+
+static jmp_buf *stop_target;
+
+static sim_alarm_t alarms[SIM_MAX_ALARMS];
+static alarm_id_t next_alarm_id = 1;
+static uint32_t alarm_latency_max_us;
+static uint32_t alarm_latency_seed = 0x2545F491;
+static sim_latency_fn_t alarm_latency_fn;
+static sim_wait_fn_t realtime_wait;
+static int64_t realtime_offset_us; ///< Virtual time minus wall-clock time
+
+static uint64_t wall_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// In real time the clock follows the wall clock, but never goes back
+uint64_t time_us_64(void) {
+    if (realtime_wait) {
+        uint64_t wall = wall_us() + realtime_offset_us;
+        if (wall > now_us)
+            now_us = wall;
+    }
+    return now_us;
+}
+
+void sim_set_realtime(sim_wait_fn_t wait) {
+    realtime_wait = wait;
+    realtime_offset_us = (int64_t)(now_us - wall_us());
+}
+
+static int schedule(uint64_t time_us, sim_event_fn_t fn, void *context, bool background) {
+    for (int i = 0; i < SIM_MAX_EVENTS; ++i) {
+        if (!events[i].used) {
+            events[i] = (sim_event_t){
+                .used = true,
+                .time_us = time_us < now_us ? now_us : time_us,
+                .seq = next_seq++,
+                .fn = fn,
+                .context = context,
+                .handle = next_handle++,
+                .background = background,
+            };
+            if (next_handle <= 0)
+                next_handle = 1;
+            return events[i].handle;
+        }
+    }
+    hard_assert(false);
+    return 0;
+}
+
+int sim_schedule_at(uint64_t time_us, sim_event_fn_t fn, void *context) {
+    return schedule(time_us, fn, context, false);
+}
+
+int sim_schedule_background_at(uint64_t time_us, sim_event_fn_t fn, void *context) {
+    return schedule(time_us, fn, context, true);
+}
+
+bool sim_cancel(int handle) {
+    for (int i = 0; i < SIM_MAX_EVENTS; ++i) {
+        if (events[i].used && events[i].handle == handle) {
+            events[i].used = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+static sim_event_t *earliest(void) {
+    sim_event_t *best = NULL;
+    for (int i = 0; i < SIM_MAX_EVENTS; ++i) {
+        sim_event_t *e = &events[i];
+        if (e->used && (!best || e->time_us < best->time_us ||
+                        (e->time_us == best->time_us && e->seq < best->seq)))
+            best = e;
+    }
+    return best;
+}
+
+/**
+ * @brief Real time: waits until the earliest event is due, or returns
+ * true early if input arrived.
+ */
+static bool wait_for_event(void) {
+    for (;;) {
+        sim_event_t *e = earliest();
+        uint64_t now = time_us_64();
+        if ((e && e->time_us <= now) || now >= limit_us)
+            return false;
+        uint64_t until = e && e->time_us < limit_us ? e->time_us : limit_us;
+        if (realtime_wait(until == UINT64_MAX ? UINT64_MAX : until - now))
+            return true;
+    }
+}
+
+void sim_step(void) {
+    ran_background = false;
+    if (realtime_wait && wait_for_event()) {
+        time_us_64();
+        return;
+    }
+
+    sim_event_t *e = earliest();
+    if (!e) {
+        sim_stop();
+        return;
+    }
+    if (e->time_us > limit_us) {
+        now_us = limit_us;
+        sim_stop();
+        return;
+    }
+
+    if (e->time_us > now_us)
+        now_us = e->time_us;
+    e->used = false;
+    events_run++;
+    ran_background = e->background;
+    e->fn(e->context);
+}
+
+void sim_stop(void) {
+    if (stop_target)
+        longjmp(*stop_target, 1);
+}
+
+void sim_run(void (*entry)(void), uint64_t limit) {
+    jmp_buf target;
+    jmp_buf *outer = stop_target;
+
+    limit_us = limit;
+    stop_target = &target;
+    if (setjmp(target) == 0)
+        entry();
+    stop_target = outer;
+}
+
+uint64_t sim_events_run(void) {
+    return events_run;
+}
+
+// Sleeping and busy-waiting both just let the next event happen. Events
+// of hardware running on its own do not wake a sleeping core.
+void __wfe(void) {
+    do
+        sim_step();
+    while (ran_background);
+}
+
+void tight_loop_contents(void) {
+    sim_step();
+}
+
+void sleep_us(uint64_t us) {
+    uint64_t target = now_us + us;
+    for (;;) {
+        sim_event_t *e = earliest();
+        if (!e || e->time_us > target)
+            break;
+        sim_step();
+    }
+    now_us = target;
+}
+
+void sim_stall_us(uint64_t us) {
+    now_us += us;
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+// Alarms
+
+void sim_set_alarm_latency(uint32_t max_us) {
+    alarm_latency_max_us = max_us;
+}
+
+void sim_set_alarm_latency_fn(sim_latency_fn_t fn) {
+    alarm_latency_fn = fn;
+}
+
+// Pseudo-random delay in [0, max], the same sequence on every run.
+static uint64_t alarm_latency(uint64_t target_us) {
+    if (alarm_latency_fn)
+        return alarm_latency_fn(target_us);
+    if (!alarm_latency_max_us)
+        return 0;
+    alarm_latency_seed ^= alarm_latency_seed << 13;
+    alarm_latency_seed ^= alarm_latency_seed >> 17;
+    alarm_latency_seed ^= alarm_latency_seed << 5;
+    return alarm_latency_seed % (alarm_latency_max_us + 1);
+}
+
+static void alarm_fire(void *context) {
+    sim_alarm_t *alarm = context;
+    alarm_id_t id = alarm->id;
+    alarm->event = 0;
+
+    int64_t next = alarm->callback(id, alarm->user_data);
+    if (alarm->id != id)
+        return; // cancelled from its own callback
+
+    if (next == 0) {
+        alarm->id = 0;
+        return;
+    }
+    alarm->target_us = next < 0 ? alarm->target_us - next : now_us + next;
+    alarm->event = sim_schedule_at(alarm->target_us + alarm_latency(alarm->target_us), alarm_fire, alarm);
+}
+
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    if (time <= now_us) {
+        if (fire_if_past)
+            callback(0, user_data);
+        return 0;
+    }
+    for (int i = 0; i < SIM_MAX_ALARMS; ++i) {
+        sim_alarm_t *alarm = &alarms[i];
+        if (alarm->id == 0) {
+            alarm->id = next_alarm_id++;
+            if (next_alarm_id <= 0)
+                next_alarm_id = 1;
+            alarm->callback = callback;
+            alarm->user_data = user_data;
+            alarm->target_us = time;
+            alarm->event = sim_schedule_at(time + alarm_latency(time), alarm_fire, alarm);
+            return alarm->id;
+        }
+    }
+    return -1;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_at(now_us + us, callback, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us((uint64_t)ms * 1000, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    if (alarm_id <= 0)
+        return false;
+    for (int i = 0; i < SIM_MAX_ALARMS; ++i) {
+        sim_alarm_t *alarm = &alarms[i];
+        if (alarm->id == alarm_id) {
+            if (alarm->event)
+                sim_cancel(alarm->event);
+            alarm->id = 0;
+            alarm->event = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Repeating timers, built on alarms like in the SDK
+
+static int64_t repeating_timer_fire(alarm_id_t id, void *user_data) {
+    repeating_timer_t *rt = user_data;
+    (void)id;
+    if (rt->callback(rt))
+        return rt->delay_us;
+    rt->alarm_id = 0;
+    return 0;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out) {
+    if (delay_us == 0)
+        delay_us = 1;
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    out->alarm_id = add_alarm_in_us(delay_us < 0 ? -delay_us : delay_us, repeating_timer_fire, out, true);
+    return out->alarm_id > 0;
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out) {
+    return add_repeating_timer_us((int64_t)delay_ms * 1000, callback, user_data, out);
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer) {
+    bool cancelled = cancel_alarm(timer->alarm_id);
+    timer->alarm_id = 0;
+    return cancelled;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file sim_clock.h
+ * @brief Virtual clock and event scheduler of the host simulation.
+ *
+ * Everything that happens "later" on the board (alarms, DMA completions,
+ * scripted button presses) is an event on this scheduler. Time jumps
+ * straight to the next event, so idle stretches cost nothing to simulate.
+ * Events run one at a time, like interrupts of equal priority.
+ */
+
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include "pico/types.h"
+
+#define SIM_MAX_EVENTS 64 ///< Events that can be pending at once
+
+typedef void (*sim_event_fn_t)(void *context);
+
+/**
+ * @brief Schedules fn(context) at an absolute virtual time.
+ *
+ * @return A handle for sim_cancel(), never 0.
+ */
+int sim_schedule_at(uint64_t time_us, sim_event_fn_t fn, void *context);
+
+/**
+ * @brief Schedules an event of hardware that runs without the CPU, such
+ * as paced DMA. It raises no interrupt, so it does not end a __wfe().
+ */
+int sim_schedule_background_at(uint64_t time_us, sim_event_fn_t fn, void *context);
+
+/**
+ * @brief Removes a pending event. Returns false if it already ran.
+ */
+bool sim_cancel(int handle);
+
+/**
+ * @brief Advances the clock to the earliest pending event and runs it.
+ *
+ * Stops the simulation (see sim_run()) when nothing is pending or the
+ * next event lies beyond the time limit.
+ */
+void sim_step(void);
+
+/**
+ * @brief Runs entry() until it returns, sim_stop() is called, nothing is
+ * left to do or the virtual clock reaches limit_us.
+ */
+void sim_run(void (*entry)(void), uint64_t limit_us);
+
+/**
+ * @brief Ends the current sim_run() from anywhere inside it.
+ */
+void sim_stop(void);
+
+/**
+ * @brief Moves the clock forward without running anything, like code
+ * running with interrupts off. Events that fall due meanwhile run late.
+ */
+void sim_stall_us(uint64_t us);
+
+/**
+ * @brief Makes every alarm fire up to max_us late, pseudo-randomly, to
+ * model interrupt latency. 0, the default, fires them on time.
+ */
+void sim_set_alarm_latency(uint32_t max_us);
+
+/**
+ * @brief Gives the latency of an alarm from the time it is set for.
+ */
+typedef uint64_t (*sim_latency_fn_t)(uint64_t target_us);
+
+/**
+ * @brief Takes the latency of every alarm from fn instead, so alarms fire
+ * when they did on a recorded board. NULL goes back to the pseudo-random
+ * one.
+ */
+void sim_set_alarm_latency_fn(sim_latency_fn_t fn);
+
+/**
+ * @brief Waits for outside input for up to timeout_us of wall-clock time,
+ * UINT64_MAX for as long as it takes.
+ *
+ * @return true if input was handed to the firmware.
+ */
+typedef bool (*sim_wait_fn_t)(uint64_t timeout_us);
+
+/**
+ * @brief Runs the virtual clock at wall-clock speed from now on, for
+ * talking to real programs. Instead of jumping to the next event, the
+ * scheduler calls wait() until the event is due; input arriving meanwhile
+ * is handled at once, at the time it arrived.
+ */
+void sim_set_realtime(sim_wait_fn_t wait);
+
+/**
+ * @brief Number of events run since start-up.
+ */
+uint64_t sim_events_run(void);
+
+#endif // SIM_CLOCK_H
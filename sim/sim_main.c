@@ -0,0 +1,467 @@
+/**
+ * @file sim_main.c
+ * @brief Host simulator: runs the unmodified firmware on a virtual board.
+ *
+ * The firmware's main() is compiled as pomodoro_main() and runs against
+ * the stand-in HAL. Button presses are scripted as GPIO edges on the
+ * virtual clock, each press and release bouncing like a real switch. The
+ * LEDs are watched to count completed work/break cycles, and the panel
+ * model behind the mock I2C bus can be dumped.
+ *
+ * Each completed cycle is also compared with where it should end, counting
+ * whole cycles from the moment the timer was started, to measure drift;
+ * --latency makes every alarm fire up to that many microseconds late.
+ *
+ * --pty runs the board in real time behind a pseudo-terminal, like the
+ * USB CDC port of a real board: its path is printed first, and a host
+ * program such as pomodoro-ctl can drive the firmware through it. Nothing
+ * is pressed; the run ends after --hours, or when killed.
+ *
+ * --flash keeps the flash image in a file, so durations and session totals
+ * saved by one run are loaded by the next; the presses then step from the
+ * saved durations.
+ *
+ * --record writes the firmware's input trace to a file (see sim_trace.h).
+ * --replay runs a trace instead of the script, recorded here or streamed
+ * from a board with pomodoro-ctl, and fails unless the firmware makes the
+ * same records, frame hashes included. The durations the board booted with
+ * are put in flash first, unless --flash gives the whole image.
+ *
+ * --fast has the firmware draw the running countdown only when it starts
+ * and at each phase change, with no per-second redraw or animation frame,
+ * so a cycle costs a few dozen events and long runs of the script finish
+ * in moments. Phase deadlines, LEDs, buzzer and flash run as usual.
+ *
+ * Usage: Pomodoro-Timer-sim [--work MIN] [--break MIN] [--cycles N | --hours H]
+ *                           [--latency US] [--dump FILE.pbm] [--flash FILE]
+ *                           [--record FILE] [--replay FILE]
+ *                           [--pty] [--fast] [--show] [--probes] [--verbose]
+ */
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim_clock.h"
+#include "bounce.h"
+#include "mock_i2c.h"
+#include "mock_flash.h"
+#include "mock_pwm.h"
+#include "sim_trace.h"
+#include "../src/hardware_init.h"
+#include "../src/probe.h"
+#include "../src/power.h"
+#include "../src/flash_store.h"
+#include "../src/animation.h"
+
+#define PRESS_SPACING_MS 100
+#define PRESS_LENGTH_MS 50
+#define MAX_PRESSES 128
+
+int pomodoro_main(void);
+extern animation_t animation;
+extern bool countdown_static;
+
+typedef struct {
+    uint64_t time_us;
+    uint8_t pin;
+} press_t;
+
+static press_t presses[MAX_PRESSES];
+static int press_count;
+static int press_next;
+
+static bool led_green;
+static uint64_t cycles;
+static uint64_t cycles_target = 1;
+static uint64_t start_us;       ///< When the first cycle started, 0 before
+static uint64_t cycle_us;       ///< Length of one work + break cycle
+static int64_t drift_last_us;
+static int64_t drift_worst_us;
+static uint32_t buzzer_notes;
+static uint64_t buzzer_on_ns;   ///< Time the buzzer sounded, up to the last silence
+static uint64_t buzzer_since_ns;
+static uint32_t buzzer_top;
+static bool buzzer_sounding;
+static int pty_master = -1;
+
+static void add_press(uint8_t pin) {
+    if (press_count == MAX_PRESSES) {
+        fprintf(stderr, "too many scripted presses\n");
+        exit(2);
+    }
+    presses[press_count].time_us = (uint64_t)(press_count + 1) * PRESS_SPACING_MS * 1000;
+    presses[press_count].pin = pin;
+    press_count++;
+}
+
+// Presses take turns through the recorded waveforms
+static void press_button(void *context) {
+    press_t *press = context;
+    int i = (int)(press - presses);
+    sim_play_bounce(press->pin, &sim_press_bounces[i % sim_press_bounce_count], time_us_64());
+    sim_play_bounce(press->pin, &sim_release_bounces[i % sim_release_bounce_count],
+                    time_us_64() + PRESS_LENGTH_MS * 1000);
+    if (++press_next < press_count)
+        sim_schedule_at(presses[press_next].time_us, press_button, &presses[press_next]);
+}
+
+// The first cycle starts when the green LED first turns on. A cycle ends
+// when the break finishes: the firmware turns the green LED on and then
+// the blue one off.
+static void watch_leds(uint gpio, bool value) {
+    if (gpio == LED_GREEN) {
+        led_green = value;
+        if (value && !start_us)
+            start_us = time_us_64();
+    } else if (gpio == LED_BLUE && !value && led_green) {
+        ++cycles;
+        drift_last_us = (int64_t)(time_us_64() - start_us - cycles * cycle_us);
+        if (llabs(drift_last_us) > llabs(drift_worst_us))
+            drift_worst_us = drift_last_us;
+        if (cycles >= cycles_target)
+            sim_stop();
+    }
+}
+
+/**
+ * @brief Counts the notes the buzzer plays: it sounds while its slice
+ * runs with a level above 0, and a new TOP while it sounds is a new note.
+ */
+static void watch_buzzer(uint slice, uint64_t time_ns, const mock_pwm_slice_t *state) {
+    if (slice != pwm_gpio_to_slice_num(BUZZER))
+        return;
+    bool sounding = state->enabled && (state->cc >> (16 * pwm_gpio_to_channel(BUZZER)) & 0xFFFF);
+    if (sounding && (!buzzer_sounding || state->top != buzzer_top))
+        buzzer_notes++;
+    if (sounding && !buzzer_sounding)
+        buzzer_since_ns = time_ns;
+    else if (!sounding && buzzer_sounding)
+        buzzer_on_ns += time_ns - buzzer_since_ns;
+    buzzer_sounding = sounding;
+    buzzer_top = state->top;
+}
+
+/**
+ * @brief Opens a raw pseudo-terminal. The slave end stays open here too, so
+ * reads never fail while no client is connected.
+ *
+ * @return The path of the slave end, NULL on failure.
+ */
+static const char *open_pty(void) {
+    pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty_master < 0 || grantpt(pty_master) || unlockpt(pty_master))
+        return NULL;
+    const char *path = ptsname(pty_master);
+    int slave = path ? open(path, O_RDWR | O_NOCTTY) : -1;
+    struct termios raw;
+    if (slave < 0 || tcgetattr(slave, &raw))
+        return NULL;
+    cfmakeraw(&raw);
+    tcsetattr(slave, TCSANOW, &raw);
+    return path;
+}
+
+// Real-time wait: firmware output goes out, then input is awaited
+static bool pty_wait(uint64_t timeout_us) {
+    struct pollfd pfd = { .fd = pty_master, .events = POLLIN };
+    struct timespec timeout = { (time_t)(timeout_us / 1000000), (long)(timeout_us % 1000000) * 1000 };
+
+    fflush(stdout);
+    if (ppoll(&pfd, 1, timeout_us == UINT64_MAX ? NULL : &timeout, NULL) <= 0)
+        return false;
+
+    uint8_t data[256];
+    size_t room = sim_stdio_room();
+    if (room == 0)
+        return true;
+    ssize_t n = read(pty_master, data, room < sizeof(data) ? room : sizeof(data));
+    if (n <= 0)
+        return false;
+    sim_stdio_feed_bytes(data, (size_t)n);
+    return true;
+}
+
+static void run_firmware(void) {
+    pomodoro_main();
+}
+
+static void write_pbm(const char *path) {
+    const uint8_t *gddram = mock_ssd1306_gddram(I2C_PORT);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        exit(2);
+    }
+    fprintf(f, "P4\n%d %d\n", MOCK_SSD1306_COLUMNS, MOCK_SSD1306_PAGES * 8);
+    for (int y = 0; y < MOCK_SSD1306_PAGES * 8; ++y) {
+        for (int x = 0; x < MOCK_SSD1306_COLUMNS; x += 8) {
+            uint8_t byte = 0;
+            for (int i = 0; i < 8; ++i) {
+                if (gddram[(y >> 3) + (x + i) * MOCK_SSD1306_PAGES] & (1 << (y & 7)))
+                    byte |= 0x80 >> i;
+            }
+            fputc(byte, f);
+        }
+    }
+    fclose(f);
+}
+
+static void show_panel(FILE *out, i2c_inst_t *i2c) {
+    const uint8_t *gddram = mock_ssd1306_gddram(i2c);
+    for (int y = 0; y < MOCK_SSD1306_PAGES * 8; ++y) {
+        for (int x = 0; x < MOCK_SSD1306_COLUMNS; ++x)
+            fputc(gddram[(y >> 3) + x * MOCK_SSD1306_PAGES] & (1 << (y & 7)) ? '#' : '.', out);
+        fputc('\n', out);
+    }
+}
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    int work = 25, rest = 5;
+    double hours = 0;
+    uint32_t latency_us = 0;
+    const char *dump = NULL, *flash = NULL, *record = NULL, *replay = NULL;
+    bool show = false, probes = false, verbose = false, pty = false, fast = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--work") && i + 1 < argc) {
+            work = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--break") && i + 1 < argc) {
+            rest = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--cycles") && i + 1 < argc) {
+            cycles_target = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--hours") && i + 1 < argc) {
+            hours = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--latency") && i + 1 < argc) {
+            latency_us = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--dump") && i + 1 < argc) {
+            dump = argv[++i];
+        } else if (!strcmp(argv[i], "--flash") && i + 1 < argc) {
+            flash = argv[++i];
+        } else if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+            record = argv[++i];
+        } else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+            replay = argv[++i];
+        } else if (!strcmp(argv[i], "--pty")) {
+            pty = true;
+        } else if (!strcmp(argv[i], "--fast")) {
+            fast = true;
+        } else if (!strcmp(argv[i], "--show")) {
+            show = true;
+        } else if (!strcmp(argv[i], "--probes")) {
+            probes = true;
+        } else if (!strcmp(argv[i], "--verbose")) {
+            verbose = true;
+        } else {
+            fprintf(stderr, "usage: %s [--work MIN] [--break MIN] [--cycles N | --hours H] "
+                            "[--latency US] [--dump FILE.pbm] [--flash FILE] [--record FILE] [--replay FILE] "
+                            "[--pty] [--fast] [--show] [--probes] [--verbose]\n", argv[0]);
+            return 2;
+        }
+    }
+#if !POMODORO_TRACE
+    if (record || replay) {
+        fprintf(stderr, "built without POMODORO_TRACE\n");
+        return 2;
+    }
+#endif
+    if (replay && pty) {
+        fprintf(stderr, "--replay runs on the virtual clock, not with --pty\n");
+        return 2;
+    }
+    if (fast && (pty || replay || record)) {
+        fprintf(stderr, "--fast only runs the script, not with --pty, --record or --replay\n");
+        return 2;
+    }
+    trace_record_t boot;
+    if (replay && !sim_trace_load(replay, &boot)) {
+        fprintf(stderr, "%s: not a trace from boot\n", replay);
+        return 2;
+    }
+    if (record && !sim_trace_record(record)) {
+        perror(record);
+        return 2;
+    }
+    if (work < 1 || work > 60 || rest < 1 || rest > 30 || cycles_target == 0) {
+        fprintf(stderr, "work must be 1-60, break 1-30 and cycles at least 1\n");
+        return 2;
+    }
+
+    // The firmware's printf goes to stdout; the report goes to the real one.
+    FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+    if (pty) {
+        // The firmware's output, text and frames, goes to the client
+        const char *path = open_pty();
+        if (!path) {
+            perror("pty");
+            return 2;
+        }
+        fprintf(report, "pty             %s\n", path);
+        fflush(report);
+        dup2(pty_master, STDOUT_FILENO);
+        setvbuf(stdout, NULL, _IOFBF, BUFSIZ);
+    } else if (!verbose) {
+        freopen("/dev/null", "w", stdout);
+    }
+
+    // B and the joystick button step the durations up from the saved ones,
+    // 25 and 5 minutes on blank flash, wrapping at 60 and 30; A then starts
+    // the first cycle.
+    store_settings_t saved = { 25, 5 };
+    if (flash) {
+        if (!mock_flash_load(flash)) {
+            fprintf(stderr, "%s: not a flash image\n", flash);
+            return 2;
+        }
+        flash_store_t store;
+        flash_store_init(&store, FLASH_STORE_OFFSET);
+        flash_store_get(&store, STORE_SETTINGS, &saved, sizeof(saved));
+    }
+    if (replay && !flash && (boot.arg != saved.work_minutes || boot.value != saved.break_minutes)) {
+        flash_store_t store;
+        store_settings_t settings = { .work_minutes = boot.arg, .break_minutes = (uint8_t)boot.value };
+        flash_store_init(&store, FLASH_STORE_OFFSET);
+        flash_store_set(&store, STORE_SETTINGS, &settings, sizeof(settings));
+        flash_store_sync(&store);
+    }
+    bool scripted = !pty && !replay;
+    for (int i = 0; scripted && i < (work - saved.work_minutes + 60) % 60; ++i)
+        add_press(BUTTON_B);
+    for (int i = 0; scripted && i < (rest - saved.break_minutes + 30) % 30; ++i)
+        add_press(BUTTON_JS);
+    if (scripted) {
+        add_press(BUTTON_A);
+        sim_schedule_at(presses[0].time_us, press_button, &presses[0]);
+    }
+    sim_gpio_set_output_hook(watch_leds);
+    mock_pwm_set_hook(watch_buzzer);
+    sim_set_alarm_latency(latency_us);
+    countdown_static = fast;
+
+    uint64_t pressed_us = scripted ? presses[press_count - 1].time_us : 0;
+    cycle_us = (work + rest) * 60ull * 1000000;
+    uint64_t limit_us;
+    if (replay) {
+        // Ends when every record is matched; the limit only bounds a replay
+        // whose firmware goes quiet early
+        sim_replay_start();
+        cycles_target = UINT64_MAX;
+        limit_us = boot.time_us + sim_trace_length_us() + 60ull * 1000000;
+    } else if (pty) {
+        sim_set_realtime(pty_wait);
+        cycles_target = UINT64_MAX;
+        limit_us = hours > 0 ? (uint64_t)(hours * 3600e6) : UINT64_MAX;
+    } else if (hours > 0) {
+        cycles_target = UINT64_MAX;
+        limit_us = pressed_us + (uint64_t)(hours * 3600e6);
+    } else {
+        limit_us = pressed_us + cycles_target * (cycle_us + 60ull * 1000000);
+    }
+    double start = wall_seconds();
+    sim_run(run_firmware, limit_us);
+    double wall = wall_seconds() - start;
+
+    double simulated = time_us_64() * 1e-6;
+    const mock_i2c_stats_t *bus = mock_i2c_stats(I2C_PORT);
+    uint32_t overlaps = bus->overlaps;
+    if (replay) {
+        const sim_replay_result_t *r = sim_replay_result();
+        fprintf(report, "replay          %lu of %lu records matched, %lu frames identical, times within %llu us\n",
+                (unsigned long)r->matched, (unsigned long)r->records, (unsigned long)r->frames,
+                (unsigned long long)r->skew_us);
+        if (r->ahead)
+            fprintf(report, "ahead           %lu frames flushed before an input the board read first\n",
+                    (unsigned long)r->ahead);
+        if (r->diverged)
+            fprintf(report, "FAIL            record %lu at %.6f s: expected %s %02x %08lx, got %s %02x %08lx at %.6f s\n",
+                    (unsigned long)r->index, r->expected.time_us * 1e-6, sim_trace_type_name(r->expected.type),
+                    r->expected.arg, (unsigned long)r->expected.value, sim_trace_type_name(r->got.type), r->got.arg,
+                    (unsigned long)r->got.value, r->got.time_us * 1e-6);
+        else if (r->matched < r->records)
+            fprintf(report, "FAIL            the firmware went quiet before the end of the trace\n");
+    } else if (hours > 0)
+        fprintf(report, "cycles          %llu in %.1f h (%d min work, %d min break)\n",
+                (unsigned long long)cycles, hours, work, rest);
+    else
+        fprintf(report, "cycles          %llu of %llu (%d min work, %d min break)\n",
+                (unsigned long long)cycles, (unsigned long long)cycles_target, work, rest);
+    if (!replay)
+        fprintf(report, "drift           last %+lld us, worst %+lld us (alarm latency up to %lu us)\n",
+                (long long)drift_last_us, (long long)drift_worst_us, (unsigned long)latency_us);
+    fprintf(report, "simulated       %.1f s in %.3f s wall (%.0fx real time)\n",
+            simulated, wall, simulated / wall);
+    fprintf(report, "throughput      %.1f cycles/s, %.0f events/s\n",
+            cycles / wall, sim_events_run() / wall);
+    fprintf(report, "wakeups         %lu (%.2f per simulated minute)\n",
+            (unsigned long)power_stats()->wakeups, power_stats()->wakeups * 60.0 / simulated);
+    fprintf(report, "i2c             %llu transactions, %llu bytes, %.3f%% bus busy\n",
+            (unsigned long long)bus->transactions, (unsigned long long)bus->bytes,
+            100.0 * bus->bus_time_ns * 1e-9 / simulated);
+#if POMODORO_STATS_DISPLAY
+    const mock_i2c_stats_t *aux = mock_i2c_stats(I2C_AUX_PORT);
+    fprintf(report, "i2c stats panel %llu transactions, %llu bytes, %.3f%% bus busy\n",
+            (unsigned long long)aux->transactions, (unsigned long long)aux->bytes,
+            100.0 * aux->bus_time_ns * 1e-9 / simulated);
+    overlaps += aux->overlaps;
+#endif
+    if (overlaps)
+        fprintf(report, "FAIL            %lu I2C writes started while DMA still held the bus\n",
+                (unsigned long)overlaps);
+    const mock_flash_stats_t *flash_stats = mock_flash_stats();
+    fprintf(report, "flash           %lu programs, %lu erases, %.1f ms stalled\n",
+            (unsigned long)flash_stats->programs, (unsigned long)flash_stats->erases, flash_stats->busy_us / 1e3);
+#if POMODORO_TONE
+    fprintf(report, "buzzer          %lu notes, %.2f s sounding\n", (unsigned long)buzzer_notes, buzzer_on_ns * 1e-9);
+#endif
+    uint64_t animated_us = animation.run_us + (animation.running ? time_us_64() - animation.started_us : 0);
+    fprintf(report, "frames          %lu at %.1f fps of %lu, %lu skipped (%lu display busy, %lu late)\n",
+            (unsigned long)animation.frames, animated_us ? animation.frames * 1e6 / animated_us : 0.0,
+            (unsigned long)animation.fps, (unsigned long)(animation.busy + animation.late),
+            (unsigned long)animation.busy, (unsigned long)animation.late);
+    if (!sim_trace_close()) {
+        perror(record);
+        return 2;
+    }
+    if (flash && !mock_flash_save(flash)) {
+        perror(flash);
+        return 2;
+    }
+    if (show) {
+        show_panel(report, I2C_PORT);
+#if POMODORO_STATS_DISPLAY
+        fputc('\n', report);
+        show_panel(report, I2C_AUX_PORT);
+#endif
+    }
+    if (dump)
+        write_pbm(dump);
+    if (probes) {
+        // Histograms are printed by the firmware's own code, on stdout
+        fflush(report);
+        fflush(stdout);
+        dup2(fileno(report), STDOUT_FILENO);
+        probe_dump();
+        fflush(stdout);
+    }
+    fclose(report);
+
+    // Drift must stay within one alarm's latency however long the run; a
+    // replay must make every record of the trace
+    bool completed = pty || (hours > 0 ? cycles > 0 : cycles >= cycles_target);
+    if (replay) {
+        const sim_replay_result_t *r = sim_replay_result();
+        completed = !r->diverged && r->matched == r->records;
+        drift_worst_us = 0;
+    }
+    return completed && llabs(drift_worst_us) <= latency_us && overlaps == 0 ? 0 : 1;
+}
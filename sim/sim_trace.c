@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim_trace.h"
+#include "sim_clock.h"
+#include "pico/stdio.h"
+#include "hardware/gpio.h"
+#include "hardware/timer.h"
+#include "../src/trace.h"
+
+static FILE *recording;
+static bool recording_failed;
+
+static trace_record_t *records;    ///< The trace being replayed
+static uint32_t count;
+static uint32_t next[TRACE_FRAME + 1]; ///< Per type, the next record of that type to match
+static uint32_t input_next;        ///< Next edge or console byte to play
+static bool booted;
+static int64_t offset_us;          ///< Replayed time minus recorded time
+static sim_replay_result_t result;
+
+const char *sim_trace_type_name(uint8_t type) {
+    static const char *const names[] = {
+        [TRACE_BOOT] = "boot", [TRACE_EDGE] = "edge", [TRACE_TICK] = "tick",
+        [TRACE_RX] = "rx",     [TRACE_FRAME] = "frame",
+    };
+    return type < sizeof(names) / sizeof(names[0]) ? names[type] : "?";
+}
+
+static void tap(const trace_record_t *record, void *data);
+
+static uint32_t next_of(uint8_t type, uint32_t from) {
+    while (from < count && records[from].type != type)
+        from++;
+    return from;
+}
+
+bool sim_trace_record(const char *path) {
+    recording = fopen(path, "wb");
+    if (!recording)
+        return false;
+    trace_set_tap(tap, NULL);
+    return true;
+}
+
+bool sim_trace_close(void) {
+    if (!recording)
+        return true;
+    bool ok = !recording_failed && fclose(recording) == 0;
+    recording = NULL;
+    return ok;
+}
+
+bool sim_trace_load(const char *path, trace_record_t *boot) {
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    if (size < TRACE_RECORD_SIZE || size % TRACE_RECORD_SIZE) {
+        fclose(f);
+        return false;
+    }
+
+    count = (uint32_t)(size / TRACE_RECORD_SIZE);
+    records = calloc(count, sizeof(*records));
+    uint8_t packed[TRACE_RECORD_SIZE];
+    for (uint32_t i = 0; i < count; ++i) {
+        if (fread(packed, sizeof(packed), 1, f) != 1) {
+            fclose(f);
+            return false;
+        }
+        trace_unpack(packed, &records[i]);
+    }
+    fclose(f);
+
+    result.records = count;
+    for (uint8_t type = 0; type <= TRACE_FRAME; ++type)
+        next[type] = next_of(type, 0);
+    *boot = records[0];
+    return records[0].type == TRACE_BOOT;
+}
+
+uint64_t sim_trace_length_us(void) {
+    return count ? records[count - 1].time_us - records[0].time_us : 0;
+}
+
+// Ticks are matched on their type alone: when they arrive is the input
+static bool same(const trace_record_t *expected, const trace_record_t *got) {
+    if (expected->type != got->type)
+        return false;
+    switch (got->type) {
+    case TRACE_TICK:
+        return true;
+    case TRACE_RX:
+        return expected->arg == got->arg;
+    case TRACE_FRAME:
+        return expected->value == got->value;
+    default:
+        return expected->arg == got->arg && expected->value == got->value;
+    }
+}
+
+static uint64_t replayed_time(const trace_record_t *record) {
+    return (uint64_t)((int64_t)record->time_us + offset_us);
+}
+
+static bool is_input(const trace_record_t *record) {
+    return record->type == TRACE_EDGE || record->type == TRACE_RX;
+}
+
+/**
+ * @brief Plays the next input and schedules the one after. Console bytes
+ * read together are fed together.
+ */
+static void play_input(void *context) {
+    const trace_record_t *record = &records[input_next];
+
+    if (record->type == TRACE_EDGE) {
+        sim_gpio_set_input(record->arg, (record->value & GPIO_IRQ_EDGE_RISE) != 0);
+        input_next++;
+    } else {
+        uint8_t bytes[64];
+        size_t length = 0;
+        uint64_t time_us = record->time_us;
+        for (; input_next < count && length < sizeof(bytes); ++input_next) {
+            record = &records[input_next];
+            if (record->time_us != time_us || (is_input(record) && record->type != TRACE_RX))
+                break;
+            if (record->type == TRACE_RX)
+                bytes[length++] = record->arg;
+        }
+        sim_stdio_feed_bytes(bytes, length);
+    }
+
+    while (input_next < count && !is_input(&records[input_next]))
+        input_next++;
+    if (input_next < count)
+        sim_schedule_at(replayed_time(&records[input_next]), play_input, NULL);
+}
+
+/**
+ * @brief An alarm fires when the next recorded tick arrived, if that is
+ * not before its deadline here.
+ */
+static uint64_t tick_latency(uint64_t target_us) {
+    if (!booted || next[TRACE_TICK] == count)
+        return 0;
+    uint64_t arrival = replayed_time(&records[next[TRACE_TICK]]);
+    return arrival > target_us ? arrival - target_us : 0;
+}
+
+static void diverge(uint32_t index, const trace_record_t *got) {
+    result.diverged = true;
+    result.index = index;
+    result.expected = index < count ? records[index] : (trace_record_t){ .type = got->type };
+    result.got = *got;
+    sim_stop();
+}
+
+/**
+ * @brief Matches a record of the replay with the next one of its type in
+ * the file. Each type is matched in its own order: the simulated board
+ * takes no time to run code, so a frame may come before an input it
+ * followed on the board. Such a frame, made while an input recorded
+ * before the expected one is still to be played, is not a divergence if
+ * it differs: the board was still busy then and never showed it. Records
+ * made after the end of the file are not part of the replay.
+ */
+static void replay(const trace_record_t *got) {
+    if (result.diverged || got->type > TRACE_FRAME)
+        return;
+    if (!booted) {
+        if (got->type != TRACE_BOOT)
+            return;
+        booted = true;
+        offset_us = (int64_t)got->time_us - (int64_t)records[0].time_us;
+        input_next = 1;
+        while (input_next < count && !is_input(&records[input_next]))
+            input_next++;
+        if (input_next < count)
+            sim_schedule_at(replayed_time(&records[input_next]), play_input, NULL);
+    }
+
+    uint32_t i = next[got->type];
+    if (i == count && got->time_us > replayed_time(&records[count - 1]))
+        return;
+    if (i < count && got->type == TRACE_FRAME && input_next < i && !same(&records[i], got)) {
+        result.ahead++;
+        return;
+    }
+    if (i == count || !same(&records[i], got)) {
+        diverge(i, got);
+        return;
+    }
+
+    next[got->type] = next_of(got->type, i + 1);
+    result.matched++;
+    result.frames += got->type == TRACE_FRAME;
+    uint64_t expected_us = replayed_time(&records[i]);
+    uint64_t skew = got->time_us > expected_us ? got->time_us - expected_us : expected_us - got->time_us;
+    if (skew > result.skew_us)
+        result.skew_us = skew;
+    if (result.matched == count)
+        sim_stop();
+}
+
+static void tap(const trace_record_t *record, void *data) {
+    if (recording) {
+        uint8_t packed[TRACE_RECORD_SIZE];
+        trace_pack(record, packed);
+        recording_failed |= fwrite(packed, sizeof(packed), 1, recording) != 1;
+    }
+    if (records)
+        replay(record);
+}
+
+void sim_replay_start(void) {
+    trace_set_tap(tap, NULL);
+    sim_set_alarm_latency_fn(tick_latency);
+}
+
+const sim_replay_result_t *sim_replay_result(void) {
+    return &result;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file sim_trace.h
+ * @brief Records the firmware's input trace to a file, and replays one.
+ *
+ * Recording writes every record the firmware makes (see src/trace.h),
+ * whether the run is scripted, a --pty session or itself a replay.
+ *
+ * A replay drives the virtual board from a trace file instead of the
+ * script. Each edge is put on its pin and each console byte fed to stdio
+ * at its recorded time, and every alarm fires when the recorded one
+ * arrived. The firmware's own records are then matched against the file,
+ * each type in its own order, so the same inputs must give the same
+ * frames, down to the hash of each.
+ *
+ * The replay is shifted by the difference between the two boot times.
+ * Times are not part of the match: the simulated board takes no time to
+ * run code, so a real one is a little later, and may read an input
+ * before a frame that the replay flushes first. Those frames are counted
+ * apart. The largest time difference is reported; it and the frames
+ * ahead are 0 for a trace the simulator recorded.
+ */
+
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../src/trace_record.h"
+
+/**
+ * @brief Outcome of a replay.
+ */
+typedef struct {
+    uint32_t records;        ///< In the file
+    uint32_t matched;        ///< Made by the replay and equal to one in the file
+    uint32_t frames;         ///< Of them, frames
+    uint32_t ahead;          ///< Frames made before an input the board had read first, not matched
+    uint64_t skew_us;        ///< Largest difference between a recorded time and the replayed one
+    bool diverged;
+    uint32_t index;          ///< Of the record in the file that was not matched
+    trace_record_t expected; ///< That record
+    trace_record_t got;      ///< And what the firmware made instead
+} sim_replay_result_t;
+
+/**
+ * @brief Writes the firmware's records to a file from now on.
+ *
+ * @return false if the file cannot be created.
+ */
+bool sim_trace_record(const char *path);
+
+/**
+ * @brief Flushes and closes the recorded file.
+ *
+ * @return false on a write error.
+ */
+bool sim_trace_close(void);
+
+/**
+ * @brief Loads a trace to replay.
+ *
+ * @param path The trace file.
+ * @param boot Its TRACE_BOOT record, for the durations to put in flash.
+ * @return false if the file cannot be read or does not start at boot.
+ */
+bool sim_trace_load(const char *path, trace_record_t *boot);
+
+/**
+ * @brief Time from the boot record to the last one.
+ */
+uint64_t sim_trace_length_us(void);
+
+/**
+ * @brief Drives the inputs and alarms from the loaded trace, starting at
+ * the firmware's boot record. The run stops once every record is matched
+ * or at the first that is not.
+ */
+void sim_replay_start(void);
+
+const sim_replay_result_t *sim_replay_result(void);
+
+/**
+ * @brief Name of a record type, for reports.
+ */
+const char *sim_trace_type_name(uint8_t type);
+
+#endif // SIM_TRACE_H
@@ -4,25 +4,122 @@
  *
  * This file contains the main logic for a Pomodoro Timer, including
  * initialization, timer callbacks, and GPIO interrupt handling.
+ *
+ * Interrupt handlers only post events to a ring; the main loop drains the
+ * ring in batches, applies every state change, flushes the display once
+ * per batch and then sleeps until the next event.
+ *
+ * The countdown is tickless: each phase has an absolute deadline, the time
+ * shown is derived from it, and a one-shot alarm is armed for the next
+ * moment the display has to change. Nothing runs while the timer is idle.
+ * With POMODORO_FPS set, a running countdown is instead redrawn by an
+ * animation at that rate, on a grid of frames anchored on the phase
+ * deadline, so the progress bar moves smoothly between the seconds.
+ * All deadlines live on a timer wheel serviced by the main loop, and a
+ * single hardware alarm is armed for the earliest of them.
+ *
+ * The application never draws directly: it describes the screen with a
+ * display_state_t and hands it to display_show(). With POMODORO_MULTICORE
+ * the state is published to core1, which owns the display, so button and
+ * timer handling on core0 never waits for an I2C transfer. With
+ * POMODORO_STATS_DISPLAY a second panel, on the other I2C controller,
+ * keeps showing the statistics while the main one shows the countdown.
+ *
+ * With POMODORO_TRACE every input is recorded as it arrives: button edges,
+ * alarm arrivals and console bytes, with a hash of each frame sent to the
+ * display, so a session can be replayed on the simulator and checked
+ * frame by frame.
+ *
+ * With POMODORO_TONE each phase change plays an alert on the buzzer,
+ * which DMA feeds to the PWM while the core goes back to sleep.
  * 
  * @include "pico/stdlib.h"
  * @include "pico/time.h"
  * @include "hardware/timer.h"
  * @include "hardware_init.h"
  * @include "display_status.h"
+ * @include "event_queue.h"
+ * @include "console.h"
+ * @include "probe.h"
+ * @include "power.h"
+ * @include "timer_wheel.h"
+ * @include "input.h"
+ * @include "flash_store.h"
+ * @include "stats.h"
+ * @include "link.h"
+ * @include "trace.h"
+ * @include "tone.h"
  *
  * @function gpio_irq_handler(uint gpio, uint32_t events)
  * Interrupt handler for GPIO events.
  *
- * @function timer_callback(repeating_timer_t *rt)
- * Callback function for the repeating timer.
+ * @function timer_callback(alarm_id_t id, void *user_data)
+ * Callback function for the hardware alarm of the timer wheel.
+ *
+ * @function service_timers(void)
+ * Runs the due timers and re-arms the hardware alarm.
+ *
+ * @function dispatch_event(const event_t *event)
+ * Applies one event from the ring, in the main loop.
+ *
+ * @function handle_input(const input_event_t *event, void *data)
+ * Acts on a debounced button event.
+ *
+ * @function handle_button(uint gpio)
+ * Acts on a button press.
+ *
+ * @function phase_timer_expired(timer_wheel_timer_t *timer, void *data)
+ * Ends a work or break period and starts the next one.
+ *
+ * @function display_timer_expired(timer_wheel_timer_t *timer, void *data)
+ * Redraws the countdown when the time shown changes.
+ *
+ * @function inactive_timer_expired(timer_wheel_timer_t *timer, void *data)
+ * Brings back the initial display after an adjustment.
  *
- * @function inactive_timer_callback(repeating_timer_t *rt)
- * Callback function for the inactive timer.
+ * @function draw_countdown(uint64_t now)
+ * Draws the countdown as of a given time.
+ *
+ * @function countdown_frame(uint64_t frame_us, void *data)
+ * Draws an animation frame of the running countdown.
+ *
+ * @function show_countdown(void)
+ * Shows the time left and schedules the next redraw.
+ *
+ * @function show_screen(display_screen_t screen, int value)
+ * Shows a screen other than the countdown.
  *
  * @function adjust_time(bool is_work_time)
  * Adjusts the timer based on whether it is work time or break time.
  *
+ * @function reset_durations(void)
+ * Restores the default work and break durations.
+ *
+ * @function set_durations(int work, int rest)
+ * Sets the work and break durations.
+ *
+ * @function load_settings(void)
+ * Takes the work and break durations saved in flash.
+ *
+ * @function save_settings(void)
+ * Saves the work and break durations to flash a while after the last change.
+ *
+ * @function count_session(void)
+ * Adds a completed work period to the totals kept in flash.
+ *
+ * @function store_timer_expired(timer_wheel_timer_t *timer, void *data)
+ * Writes the changed values to flash, and erases ahead for the next
+ * compaction, when nothing is due for a while.
+ *
+ * @function show_stats(void)
+ * Shows the work done today and this week.
+ *
+ * @function handle_command(const link_message_t *command, void *data)
+ * Runs a command received over the USB link.
+ *
+ * @function fill_status(link_status_t *status, void *data)
+ * Describes the timer for a status message of the USB link.
+ *
  * @var default_work_minutes
  * Default duration for work periods in minutes.
  *
@@ -50,11 +147,58 @@
  * @var timer_on
  * Flag indicating if the timer is currently on.
  *
- * @var timer
- * Repeating timer structure for the main timer.
+ * @var timers
+ * Timer wheel holding every deadline of the application.
+ *
+ * @var phase_timer
+ * Fires at the end of the current work or break period, while running.
+ *
+ * @var display_timer
+ * Fires when the time shown changes, while running without animation.
+ *
+ * @var animation
+ * Redraws the running countdown POMODORO_FPS times a second.
+ *
+ * @var countdown_static
+ * Draws the running countdown only when it starts or changes period; set
+ * by the simulator's fast mode.
  *
  * @var inactive_timer
- * Repeating timer structure for the inactive timer.
+ * Fires a while after the last adjustment.
+ *
+ * @var store_timer
+ * Fires when changed values should be written to flash.
+ *
+ * @var store_at_phase_change
+ * An erase that changed values wait behind was put off to just after a
+ * phase change, and runs then even if the animation does not stop.
+ *
+ * @var wheel_alarm
+ * Hardware alarm armed for the earliest deadline of the wheel.
+ *
+ * @var wheel_alarm_us
+ * Deadline wheel_alarm is armed for, 0 if none.
+ *
+ * @var phase_remaining_us
+ * Time left in the current period while the timer is stopped or paused.
+ *
+ * @var event_queue
+ * Ring of events posted by the interrupt handlers.
+ *
+ * @var input
+ * Debouncers of the three buttons.
+ *
+ * @var store
+ * Settings and session totals, kept in the last flash sectors.
+ *
+ * @var stats
+ * History of the periods and their daily and weekly totals.
+ *
+ * @var link
+ * Binary control and telemetry protocol over USB.
+ *
+ * @var mirror
+ * Copy of the framebuffer streamed over the link on request.
  *
  * @var ssd
  * External variable for the SSD1306 display.
@@ -68,12 +212,61 @@
 #include "hardware/timer.h"
 #include "hardware_init.h"
 #include "display_status.h"
+#include "event_queue.h"
+#include "console.h"
+#include "probe.h"
+#include "power.h"
+#include "timer_wheel.h"
+#include "input.h"
+#include "flash_store.h"
+#include "stats.h"
+#include "link.h"
+#include "mirror.h"
+#include "animation.h"
+#include "trace.h"
+#include "tone.h"
+#if POMODORO_MULTICORE
+#include "pico/multicore.h"
+#endif
+
+#define COUNTDOWN_STEP_US 1000000 ///< Microseconds in a second of the countdown
+#if POMODORO_TENTHS
+#define READOUT_STEP_US 100000    ///< The countdown shows tenths of a second
+#else
+#define READOUT_STEP_US COUNTDOWN_STEP_US
+#endif
+#ifndef POMODORO_FPS
+#define POMODORO_FPS 30           ///< Countdown frames per second, set by CMake
+#endif
+#define INACTIVE_TIMEOUT_US 4000000
+#define BUTTON_EDGES (GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE)
+#define STORE_DELAY_US 3000000    ///< Changes are saved once they stop for this long
+#define STORE_RETRY_US 10000      ///< After a timer that was due too soon, once its redraw is sent
 
 // Prototypes
 void gpio_irq_handler(uint gpio, uint32_t events);
-bool timer_callback(repeating_timer_t *rt);
-bool inactive_timer_callback(repeating_timer_t *rt);
+int64_t timer_callback(alarm_id_t id, void *user_data);
+void service_timers(void);
+void dispatch_event(const event_t *event);
+void handle_input(const input_event_t *event, void *data);
+void handle_button(uint gpio);
+void phase_timer_expired(timer_wheel_timer_t *timer, void *data);
+void display_timer_expired(timer_wheel_timer_t *timer, void *data);
+void inactive_timer_expired(timer_wheel_timer_t *timer, void *data);
+void show_countdown(void);
+uint64_t draw_countdown(uint64_t now);
+bool countdown_frame(uint64_t frame_us, void *data);
+void show_screen(display_screen_t screen, int value);
 void adjust_time(bool is_work_time);
+void reset_durations(void);
+void set_durations(int work, int rest);
+void load_settings(void);
+void save_settings(void);
+void count_session(void);
+void store_timer_expired(timer_wheel_timer_t *timer, void *data);
+void show_stats(void);
+link_result_t handle_command(const link_message_t *command, void *data);
+void fill_status(link_status_t *status, void *data);
 
 // Variables
 int default_work_minutes = 25;
@@ -85,62 +278,192 @@ int seconds = 0;
 bool on_break = false;
 bool timer_running = false;
 bool timer_on = false;
-repeating_timer_t timer;
-repeating_timer_t inactive_timer;
+timer_wheel_t timers;
+timer_wheel_timer_t phase_timer;
+timer_wheel_timer_t display_timer;
+timer_wheel_timer_t inactive_timer;
+timer_wheel_timer_t store_timer;
+bool store_at_phase_change = false;
+alarm_id_t wheel_alarm;
+volatile uint64_t wheel_alarm_us;
+uint64_t phase_remaining_us = 25 * 60 * (uint64_t)COUNTDOWN_STEP_US;
+event_queue_t event_queue;
+input_t input;
+flash_store_t store;
+stats_t stats;
+link_t link;
+mirror_t mirror;
+animation_t animation;
+bool countdown_static = false;
 extern ssd1306_t ssd;
+#if POMODORO_STATS_DISPLAY
+extern ssd1306_t ssd_aux;
+#endif
 
 int main()
 {
     stdio_init_all();
     hardware_init();
+#if POMODORO_MULTICORE
+    multicore_launch_core1(display_core1_main);
+#else
+    ssd1306_set_flush_callback(&ssd, display_flush_done, &event_queue);
+#if POMODORO_STATS_DISPLAY
+    ssd1306_set_flush_callback(&ssd_aux, display_flush_done, &event_queue);
+#endif
+    mirror_init(&mirror, &link, ssd.ram_buffer + 1);
+#endif
+    console_init(&event_queue, &timers, &store, &stats, &link, &animation);
+    stats_init(&stats);
+    flash_store_init(&store, FLASH_STORE_OFFSET);
+    load_settings();
+    trace_record(TRACE_BOOT, (uint8_t)default_work_minutes, (uint32_t)default_break_minutes);
+    show_screen(SCREEN_INITIAL, 0);
+#if POMODORO_STATS_DISPLAY
+    show_stats();
+#endif
+
+    timer_wheel_init(&timers, time_us_64());
+    timer_wheel_timer_init(&phase_timer, "phase", phase_timer_expired, NULL);
+    timer_wheel_timer_init(&display_timer, "display", display_timer_expired, NULL);
+    animation_init(&animation, &timers, POMODORO_FPS, countdown_frame, NULL);
+    timer_wheel_timer_init(&inactive_timer, "inactive", inactive_timer_expired, NULL);
+    timer_wheel_timer_init(&store_timer, "store", store_timer_expired, NULL);
+    // Once the ring has wrapped, erase ahead now, before the animation can run
+    if (flash_store_prepare_us(&store))
+        timer_wheel_add(&timers, &store_timer, time_us_64());
+    link_init(&link, &timers, handle_command, fill_status, NULL);
 
-    gpio_set_irq_enabled_with_callback(BUTTON_A, GPIO_IRQ_EDGE_FALL, true, &gpio_irq_handler);
-    gpio_set_irq_enabled(BUTTON_B, GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(BUTTON_JS, GPIO_IRQ_EDGE_FALL, true);
+    input_init(&input, &timers, handle_input, NULL);
+    input_add_button(&input, BUTTON_A);
+    input_add_button(&input, BUTTON_B);
+    input_add_button(&input, BUTTON_JS);
+    gpio_set_irq_enabled_with_callback(BUTTON_A, BUTTON_EDGES, true, &gpio_irq_handler);
+    gpio_set_irq_enabled(BUTTON_B, BUTTON_EDGES, true);
+    gpio_set_irq_enabled(BUTTON_JS, BUTTON_EDGES, true);
 
     while (true) {
-        sleep_ms(1000);
+        event_t event;
+        while (event_queue_pop(&event_queue, &event)) {
+            dispatch_event(&event);
+        }
+        service_timers();
+        bool flushed = display_flush();
+        if (flushed)
+            trace_frame(ssd.ram_buffer + 1, SSD1306_BUFSIZE - 1);
+        mirror_update(&mirror, flushed);
+        trace_stream(&link);
+        power_sleep();
     }
 }
 
 /**
  * @brief GPIO interrupt handler for the Pomodoro Timer.
  *
- * This function handles GPIO interrupts for the Pomodoro Timer. It debounces
- * the button presses and performs actions based on which button was pressed.
+ * Posts the edge to the event ring and returns; debouncing happens on
+ * the main loop, which gets at most one pending edge per button however
+ * much the contacts bounce.
  *
  * @param gpio The GPIO pin number that triggered the interrupt.
  * @param events The event type that triggered the interrupt.
+ */
+void gpio_irq_handler(uint gpio, uint32_t events) 
+{
+    PROBE_BEGIN(start);
+    trace_record(TRACE_EDGE, (uint8_t)gpio, events);
+    if (input_irq(&input, gpio))
+        event_queue_post(&event_queue, EVENT_BUTTON, (uint8_t)gpio);
+    PROBE_END(PROBE_GPIO_IRQ, start);
+}
+
+/**
+ * @brief Applies one event taken from the ring.
+ *
+ * Runs in the main loop, which is the only place where the timer state
+ * changes.
+ *
+ * @param event The event to apply.
+ */
+void dispatch_event(const event_t *event)
+{
+    switch (event->type) {
+    case EVENT_BUTTON:
+        input_edge(&input, event->arg, event->time_us);
+        break;
+    case EVENT_TIMER:
+        // Due timers run in service_timers() at the end of the batch
+        break;
+    case EVENT_FLUSH_DONE:
+        // Anything drawn during the transfer is sent at the end of the batch
+        break;
+    case EVENT_CONSOLE:
+        console_poll();
+        break;
+    }
+}
+
+/**
+ * @brief Acts on a debounced button event.
+ *
+ * - A press runs handle_button().
+ * - Holding B or the joystick button while the timer is off keeps
+ *   stepping the work or break time up.
+ * - Pressing B and the joystick button together while the timer is off
+ *   restores the default durations.
+ *
+ * @param event The event.
+ * @param data Unused.
+ */
+void handle_input(const input_event_t *event, void *data)
+{
+    switch (event->type) {
+    case INPUT_PRESS:
+        handle_button(event->gpio);
+        break;
+    case INPUT_REPEAT:
+        if (!timer_on && event->gpio != BUTTON_A)
+            adjust_time(event->gpio == BUTTON_B);
+        break;
+    case INPUT_CHORD:
+        if (!timer_on && input_is_held(&input, BUTTON_B) && input_is_held(&input, BUTTON_JS))
+            reset_durations();
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Handles a button press for the Pomodoro Timer.
+ *
+ * This function performs actions based on which button was pressed.
+ *
+ * @param gpio The GPIO pin number that was pressed.
  *
  * - BUTTON_A: Starts the Pomodoro timer if it is not already running. If the timer
  *   is on a break, it sets the LED to blue; otherwise, it sets the LED to green.
  * - BUTTON_B: Pauses the Pomodoro timer if it is running. If the timer is not running
  *   and not on, it adjusts the work time.
  * - BUTTON_JS: Stops the Pomodoro timer if it is on. Resets the timer to the default
- *   work time and turns off the LEDs. If the timer is not on, it adjusts the break time.
+ *   work time, turns off the LEDs and shows the statistics for a while. If the timer
+ *   is not on, it adjusts the break time.
  *
  * The function also updates the display and manages the timer state.
  */
-void gpio_irq_handler(uint gpio, uint32_t events) 
+void handle_button(uint gpio) 
 {
-    static absolute_time_t last_interrupt_time = {0};
-    absolute_time_t current_time = get_absolute_time();
-    int64_t time_diff = absolute_time_diff_us(last_interrupt_time, current_time);
-
-    if (time_diff < 300000) 
-    { // 300ms debounce time
-        return;
-    }
-
-    last_interrupt_time = current_time;
-
     if (gpio == BUTTON_A) {
         if (timer_running) {
             printf("Pomodoro already running\n");
             return;
         }
 
-        add_repeating_timer_ms(-1000, timer_callback, NULL, &timer);
+        uint64_t now = time_us_64();
+        if (timer_on)
+            stats_resume(&stats, now);
+        else
+            stats_begin(&stats, STATS_WORK, work_minutes * 60, now);
+        timer_wheel_add(&timers, &phase_timer, now + phase_remaining_us);
         if (on_break) {
             gpio_put(LED_RED, 0);
             gpio_put(LED_BLUE, 1);
@@ -154,7 +477,7 @@ void gpio_irq_handler(uint gpio, uint32_t events)
         timer_running = true;
         timer_on = true;
         printf("Pomodoro started\n");
-        update_timer(minutes, seconds, on_break);
+        show_countdown();
         return;
     } else if (gpio == BUTTON_B) {
         if (timer_running) {
@@ -163,9 +486,12 @@ void gpio_irq_handler(uint gpio, uint32_t events)
             gpio_put(LED_BLUE, 0);
             gpio_put(LED_GREEN, 1);
             gpio_put(LED_RED, 1);
-            cancel_repeating_timer(&timer);
-            ssd1306_draw_string(&ssd, "Paused", 60, 10);
-            ssd1306_send_data(&ssd);
+            phase_remaining_us = timer_wheel_remaining_us(&phase_timer, time_us_64());
+            stats_pause(&stats, time_us_64());
+            timer_wheel_cancel(&timers, &phase_timer);
+            timer_wheel_cancel(&timers, &display_timer);
+            animation_stop(&animation, time_us_64());
+            show_countdown();
             return;
         } else if (!timer_on) {
             adjust_time(true); // Ajustar tempo de trabalho
@@ -175,6 +501,7 @@ void gpio_irq_handler(uint gpio, uint32_t events)
             printf("Pomodoro finished\n");
             minutes = default_work_minutes;
             seconds = 0;
+            phase_remaining_us = minutes * 60 * (uint64_t)COUNTDOWN_STEP_US;
 
             timer_running = false;
             timer_on = false;
@@ -183,8 +510,15 @@ void gpio_irq_handler(uint gpio, uint32_t events)
             gpio_put(LED_RED, 0);
             gpio_put(LED_GREEN, 0);
 
-            cancel_repeating_timer(&timer);
-            initial_display();
+            timer_wheel_cancel(&timers, &phase_timer);
+            timer_wheel_cancel(&timers, &display_timer);
+            animation_stop(&animation, time_us_64());
+            stats_end(&stats, false, time_us_64());
+            show_stats();
+#if POMODORO_STATS_DISPLAY
+            show_screen(SCREEN_INITIAL, 0); // The stats are on their own panel
+#endif
+            timer_wheel_add(&timers, &inactive_timer, time_us_64() + INACTIVE_TIMEOUT_US);
             return;
         } else if (!timer_on) {
             adjust_time(false); // Ajustar tempo de pausa
@@ -201,8 +535,6 @@ void gpio_irq_handler(uint gpio, uint32_t events)
  * @param is_work_time A boolean value indicating whether to adjust the work time (true) or break time (false).
  *
  * The function performs the following steps:
- * - Clears the SSD1306 display.
- * - Draws a rectangle on the display.
  * - If `is_work_time` is true:
  *   - Increments the default work minutes by 1.
  *   - Resets the default work minutes to 1 if it exceeds 60.
@@ -214,95 +546,450 @@ void gpio_irq_handler(uint gpio, uint32_t events)
  *   - Prints the new break time to the console.
  *   - Updates the display with the new break time.
  * - Updates the global variables for minutes, work_minutes, and break_minutes.
- * - Sends the updated data to the SSD1306 display.
- * - Cancels the inactive timer and sets a new repeating timer with a 4000 ms interval.
+ * - Saves the new durations to flash once the adjustments stop.
+ * - Re-arms the inactive timer to fire 4 s from now.
  */
 void adjust_time(bool is_work_time) {
-    ssd1306_fill(&ssd, false);
-    ssd1306_rect(&ssd, 0, 0, WIDTH, HEIGHT, true, false);
-
     if (is_work_time) {
         default_work_minutes += 1;
         if (default_work_minutes > 60) default_work_minutes = 1;
         printf("Work time set to %d minutes\n", default_work_minutes);
-        ssd1306_draw_string(&ssd, "Work time set ", 10, 10);
-        ssd1306_draw_string(&ssd, "to", 10, 20);
-        char buffer[16];
-        snprintf(buffer, sizeof(buffer), "%d minutes", default_work_minutes);
-        ssd1306_draw_string(&ssd, buffer, 10, 30);
+        show_screen(SCREEN_ADJUST_WORK, default_work_minutes);
     } else {
         default_break_minutes += 1;
         if (default_break_minutes > 30) default_break_minutes = 1;
         printf("Break time set to %d minutes\n", default_break_minutes);
-        ssd1306_draw_string(&ssd, "Break time set", 10, 10);
-        ssd1306_draw_string(&ssd, "to", 10, 20);
-        char buffer[16];
-        snprintf(buffer, sizeof(buffer), "%d minutes", default_break_minutes);
-        ssd1306_draw_string(&ssd, buffer, 10, 30);
+        show_screen(SCREEN_ADJUST_BREAK, default_break_minutes);
     }
 
     minutes = default_work_minutes;
+    phase_remaining_us = minutes * 60 * (uint64_t)COUNTDOWN_STEP_US;
     work_minutes = default_work_minutes;
     break_minutes = default_break_minutes;
 
-    ssd1306_send_data(&ssd);
+    save_settings();
+    timer_wheel_add(&timers, &inactive_timer, time_us_64() + INACTIVE_TIMEOUT_US);
+}
 
-    cancel_repeating_timer(&inactive_timer);
-    add_repeating_timer_ms(4000, inactive_timer_callback, NULL, &inactive_timer);
+/**
+ * @brief Restores the default work and break durations, 25 and 5 minutes,
+ * and shows the work duration.
+ */
+void reset_durations(void) {
+    set_durations(25, 5);
 }
 
 /**
- * @brief Callback function for the repeating timer.
+ * @brief Sets the work and break durations while the timer is off, shows
+ * the work duration and saves both.
  *
- * This function is called periodically by the repeating timer. It updates the 
- * timer's state, switching between work and break periods, and updates the 
- * LED indicators accordingly.
+ * @param work Work minutes, 1 to 60.
+ * @param rest Break minutes, 1 to 30.
+ */
+void set_durations(int work, int rest) {
+    default_work_minutes = work;
+    default_break_minutes = rest;
+    printf("Durations set to %d and %d minutes\n", default_work_minutes, default_break_minutes);
+    show_screen(SCREEN_ADJUST_WORK, default_work_minutes);
+
+    minutes = default_work_minutes;
+    phase_remaining_us = minutes * 60 * (uint64_t)COUNTDOWN_STEP_US;
+    work_minutes = default_work_minutes;
+    break_minutes = default_break_minutes;
+
+    save_settings();
+    timer_wheel_add(&timers, &inactive_timer, time_us_64() + INACTIVE_TIMEOUT_US);
+}
+
+/**
+ * @brief Takes the work and break durations saved in flash, if any and
+ * in range.
+ */
+void load_settings(void) {
+    store_settings_t settings;
+    if (!flash_store_get(&store, STORE_SETTINGS, &settings, sizeof(settings)))
+        return;
+    if (settings.work_minutes < 1 || settings.work_minutes > 60 ||
+        settings.break_minutes < 1 || settings.break_minutes > 30)
+        return;
+
+    default_work_minutes = work_minutes = minutes = settings.work_minutes;
+    default_break_minutes = break_minutes = settings.break_minutes;
+    phase_remaining_us = minutes * 60 * (uint64_t)COUNTDOWN_STEP_US;
+    printf("Durations loaded: %d and %d minutes\n", default_work_minutes, default_break_minutes);
+}
+
+/**
+ * @brief Saves the work and break durations. Each adjustment pushes the
+ * write back, so holding a button to step through values writes once.
+ */
+void save_settings(void) {
+    store_settings_t settings = {
+        .work_minutes = (uint8_t)default_work_minutes,
+        .break_minutes = (uint8_t)default_break_minutes,
+    };
+    flash_store_set(&store, STORE_SETTINGS, &settings, sizeof(settings));
+    if (flash_store_pending(&store))
+        timer_wheel_add(&timers, &store_timer, time_us_64() + STORE_DELAY_US);
+}
+
+/**
+ * @brief Adds the work period that just ended to the session totals.
+ */
+void count_session(void) {
+    store_sessions_t sessions = { 0 };
+    flash_store_get(&store, STORE_SESSIONS, &sessions, sizeof(sessions));
+    sessions.completed++;
+    sessions.work_minutes += work_minutes;
+    flash_store_set(&store, STORE_SESSIONS, &sessions, sizeof(sessions));
+    timer_wheel_add(&timers, &store_timer, time_us_64() + STORE_DELAY_US);
+}
+
+/**
+ * @brief Writes the changed values to flash, then erases the sector the
+ * next compaction will use.
  *
- * @param rt Pointer to the repeating timer structure.
- * @return true to keep the timer running, false to stop it.
+ * Both stall the core with interrupts off: appending, or compacting into
+ * an erased sector, for up to FLASH_STORE_APPEND_MAX_US, and erasing for
+ * up to FLASH_STORE_ERASE_MAX_US. If the countdown has a deadline within
+ * the stall, the work waits until just after it, so the countdown is
+ * never late because of the flash. While the animation runs, the work
+ * goes in the gap after the next frame if it fits in one. An erase, which
+ * no frame period at 30 fps is long enough for, waits until the animation
+ * stops; only if changed values wait behind it, which takes a few hundred
+ * periods without a pause, it runs just after the next phase change and
+ * frames it overlaps are skipped. Other timers, like the status stream of
+ * the USB link, may be late. Failed or deferred work is retried later.
  */
-bool timer_callback(repeating_timer_t *rt) 
+void store_timer_expired(timer_wheel_timer_t *timer, void *data)
 {
-    if (seconds == 0) {
-        if (minutes == 0) {
-            if (on_break) {
-                minutes = work_minutes;
-                seconds = 0;
-                on_break = false;
-                gpio_put(LED_GREEN, 1);
-                gpio_put(LED_BLUE, 0);
-                printf("Break finished\n");
-            } else {
-                minutes = break_minutes;
-                seconds = 0;
-                on_break = true;
-                gpio_put(LED_GREEN, 0);
-                gpio_put(LED_BLUE, 1);
-                printf("Work finished\n");
-            }
-            return true;
+    uint64_t now = time_us_64();
+    bool sync = flash_store_pending(&store);
+    uint64_t stall = sync ? flash_store_sync_us(&store) : flash_store_prepare_us(&store);
+    uint64_t next = UINT64_MAX;
+
+    if (!stall)
+        return;
+    if (phase_timer.pending)
+        next = phase_timer.deadline_us;
+    if (display_timer.pending && display_timer.deadline_us < next)
+        next = display_timer.deadline_us;
+    if (next < now + stall) {
+        timer_wheel_add(&timers, timer, next + STORE_RETRY_US);
+        return;
+    }
+    if (animation.timer.pending && animation.timer.deadline_us < now + stall && !store_at_phase_change) {
+        if (STORE_RETRY_US + stall < COUNTDOWN_STEP_US / animation.fps) {
+            timer_wheel_add(&timers, timer, animation.timer.deadline_us + STORE_RETRY_US);
+        } else if (sync && phase_timer.pending) {
+            store_at_phase_change = true;
+            timer_wheel_add(&timers, timer, phase_timer.deadline_us + STORE_RETRY_US);
+        } else {
+            timer_wheel_add(&timers, timer, now + STORE_DELAY_US);
         }
-        minutes--;
-        seconds = 59;
+        return;
+    }
+    store_at_phase_change = false;
+    bool done = sync ? flash_store_sync(&store) : flash_store_prepare(&store);
+    if (!done || flash_store_prepare_us(&store))
+        timer_wheel_add(&timers, timer, now + STORE_DELAY_US);
+}
+
+/**
+ * @brief Runs a command received over the USB link, as the buttons would.
+ *
+ * @param command The command; only start, pause, reset, set-durations,
+ * set-mirror and set-trace reach this handler.
+ * @param data Unused.
+ * @return The result sent back in the acknowledgement.
+ */
+link_result_t handle_command(const link_message_t *command, void *data)
+{
+    switch (command->type) {
+    case LINK_START:
+        if (timer_running)
+            return LINK_REJECTED;
+        handle_button(BUTTON_A);
+        return LINK_OK;
+    case LINK_PAUSE:
+        if (!timer_running)
+            return LINK_REJECTED;
+        handle_button(BUTTON_B);
+        return LINK_OK;
+    case LINK_RESET:
+        if (timer_on)
+            handle_button(BUTTON_JS);
+        return LINK_OK;
+    case LINK_SET_DURATIONS:
+        if (command->length != 2)
+            return LINK_BAD_LENGTH;
+        if (command->payload[0] < 1 || command->payload[0] > 60 ||
+            command->payload[1] < 1 || command->payload[1] > 30)
+            return LINK_BAD_VALUE;
+        if (timer_on)
+            return LINK_REJECTED;
+        set_durations(command->payload[0], command->payload[1]);
+        return LINK_OK;
+    case LINK_SET_MIRROR:
+#if POMODORO_MULTICORE
+        // The framebuffer belongs to core1
+        return LINK_REJECTED;
+#else
+        if (command->length != 1)
+            return LINK_BAD_LENGTH;
+        if (command->payload[0] > 1)
+            return LINK_BAD_VALUE;
+        mirror_enable(&mirror, command->payload[0]);
+        return LINK_OK;
+#endif
+    case LINK_SET_TRACE:
+#if POMODORO_TRACE
+        if (command->length != 1)
+            return LINK_BAD_LENGTH;
+        if (command->payload[0] > 1)
+            return LINK_BAD_VALUE;
+        trace_enable(command->payload[0]);
+        return LINK_OK;
+#else
+        return LINK_REJECTED;
+#endif
+    default:
+        return LINK_UNKNOWN;
+    }
+}
+
+/**
+ * @brief Describes the timer for a status message of the USB link. The
+ * link adds its own counters.
+ *
+ * @param status Filled in.
+ * @param data Unused.
+ */
+void fill_status(link_status_t *status, void *data)
+{
+    uint64_t now = time_us_64();
+    uint64_t left = timer_running ? timer_wheel_remaining_us(&phase_timer, now) : phase_remaining_us;
+    uint64_t shown = (left + COUNTDOWN_STEP_US - 1) / COUNTDOWN_STEP_US;
+    uint64_t period = (on_break ? break_minutes : work_minutes) * 60 * (uint64_t)COUNTDOWN_STEP_US;
+    const power_stats_t *power = power_stats();
+
+    status->uptime_ms = (uint32_t)(now / 1000);
+    status->flags = (timer_running ? LINK_STATUS_RUNNING : 0) | (timer_on ? LINK_STATUS_ON : 0) |
+                    (on_break ? LINK_STATUS_BREAK : 0);
+    status->minutes = (uint8_t)(shown / 60);
+    status->seconds = (uint8_t)(shown % 60);
+    status->work_minutes = (uint8_t)default_work_minutes;
+    status->break_minutes = (uint8_t)default_break_minutes;
+    status->progress = left < period ? (uint8_t)((period - left) * UINT8_MAX / period) : 0;
+    status->today_completed = stats_today(&stats, now)->completed;
+    status->week_completed = stats_week(&stats, now)->completed;
+    status->wakeups = power->wakeups;
+    status->active_permille = now ? (uint16_t)((now - power->asleep_us) * 1000 / now) : 0;
+}
+
+/**
+ * @brief Callback function for the hardware alarm of the timer wheel.
+ *
+ * Runs in the timer alarm IRQ and only posts EVENT_TIMER; the due timers
+ * run in the main loop.
+ *
+ * @param id The alarm that fired.
+ * @param user_data Unused.
+ * @return 0, the alarm is re-armed by service_timers().
+ */
+int64_t timer_callback(alarm_id_t id, void *user_data)
+{
+    PROBE_BEGIN(start);
+    PROBE_LATE(PROBE_TICK_LATENESS, start, wheel_alarm_us);
+    trace_record(TRACE_TICK, 0, (uint32_t)(time_us_64() - wheel_alarm_us));
+    event_queue_post(&event_queue, EVENT_TIMER, 0);
+    PROBE_END(PROBE_TICK_CALLBACK, start);
+    return 0;
+}
+
+/**
+ * @brief Runs the due timers and re-arms the hardware alarm.
+ *
+ * Called by the main loop after every batch of events. The alarm is only
+ * moved when the earliest deadline changed. If that deadline passes while
+ * the alarm is being armed, the wheel is serviced again straight away.
+ */
+void service_timers(void)
+{
+    uint64_t next;
+
+    timer_wheel_advance(&timers, time_us_64());
+    while (timer_wheel_next(&timers, &next)) {
+        if (next == wheel_alarm_us)
+            return;
+        cancel_alarm(wheel_alarm);
+        wheel_alarm_us = next;
+        wheel_alarm = add_alarm_at(from_us_since_boot(next), timer_callback, NULL, false);
+        if (wheel_alarm > 0)
+            return;
+        timer_wheel_advance(&timers, time_us_64());
+    }
+    cancel_alarm(wheel_alarm);
+    wheel_alarm_us = 0;
+}
+
+/**
+ * @brief Ends a work or break period and starts the next one.
+ *
+ * The next period starts from the deadline of the one that ended, not
+ * from now, so the lateness of this callback never accumulates. The LED
+ * indicators follow the period and the buzzer plays the alert of the
+ * period that ended, and the statistics record it as completed; a
+ * statistics panel shows the new totals.
+ */
+void phase_timer_expired(timer_wheel_timer_t *timer, void *data)
+{
+    stats_end(&stats, true, timer->deadline_us);
+    stats_begin(&stats, on_break ? STATS_WORK : STATS_BREAK, (on_break ? work_minutes : break_minutes) * 60,
+                timer->deadline_us);
+    if (on_break) {
+        timer_wheel_add(&timers, timer, timer->deadline_us + work_minutes * 60 * (uint64_t)COUNTDOWN_STEP_US);
+        on_break = false;
+        gpio_put(LED_GREEN, 1);
+        gpio_put(LED_BLUE, 0);
+        tone_play(&tone_break_done);
+        printf("Break finished\n");
     } else {
-        seconds--;
+        timer_wheel_add(&timers, timer, timer->deadline_us + break_minutes * 60 * (uint64_t)COUNTDOWN_STEP_US);
+        on_break = true;
+        gpio_put(LED_GREEN, 0);
+        gpio_put(LED_BLUE, 1);
+        tone_play(&tone_work_done);
+        printf("Work finished\n");
+        count_session();
     }
-    
-    update_timer(minutes, seconds, on_break);
-    return true;
+#if POMODORO_STATS_DISPLAY
+    show_stats();
+#endif
+    show_countdown();
+}
+
+/**
+ * @brief Redraws the countdown when the time shown changes.
+ */
+void display_timer_expired(timer_wheel_timer_t *timer, void *data)
+{
+    show_countdown();
+}
+
+/**
+ * @brief Brings back the initial display after an adjustment or the
+ * statistics, unless the timer was started in the meantime.
+ */
+void inactive_timer_expired(timer_wheel_timer_t *timer, void *data)
+{
+    if (!timer_on) {
+        show_screen(SCREEN_INITIAL, 0);
+    }
+}
+
+/**
+ * @brief Shows the time left and schedules the next redraw.
+ *
+ * While running, the countdown is redrawn by the animation if there is
+ * one; otherwise the display timer is armed for the next change of the
+ * time shown. The last change of a period is the phase timer itself.
+ * With countdown_static neither is scheduled.
+ */
+void show_countdown(void)
+{
+    uint64_t now = time_us_64();
+    uint64_t shown = draw_countdown(now);
+
+    if (!timer_running || countdown_static)
+        return;
+#if POMODORO_FPS
+    (void)shown;
+    if (!animation.running)
+        animation_start(&animation, phase_timer.deadline_us, now);
+#else
+    if (shown > 1)
+        timer_wheel_add(&timers, &display_timer, phase_timer.deadline_us - (shown - 1) * READOUT_STEP_US);
+    else
+        timer_wheel_cancel(&timers, &display_timer);
+#endif
 }
 
+/**
+ * @brief Draws the countdown as of a given time.
+ *
+ * The time shown is what is left until the phase deadline, rounded up to
+ * whole seconds, or tenths with POMODORO_TENTHS, so it changes each time
+ * the time left drops below one of them. While paused, the time left is
+ * frozen in phase_remaining_us. The progress bar shows how much of the
+ * period has elapsed.
+ *
+ * @param now The time to draw.
+ * @return The time shown, in READOUT_STEP_US.
+ */
+uint64_t draw_countdown(uint64_t now)
+{
+    uint64_t left = timer_running ? timer_wheel_remaining_us(&phase_timer, now) : phase_remaining_us;
+    uint64_t shown = (left + READOUT_STEP_US - 1) / READOUT_STEP_US;
+    uint64_t per_second = COUNTDOWN_STEP_US / READOUT_STEP_US;
+    uint64_t period = (on_break ? break_minutes : work_minutes) * 60 * (uint64_t)COUNTDOWN_STEP_US;
+
+    minutes = (int)(shown / per_second / 60);
+    seconds = (int)(shown / per_second % 60);
+    display_show(&(display_state_t){
+        .screen = SCREEN_COUNTDOWN,
+        .minutes = (uint8_t)minutes,
+        .seconds = (uint8_t)seconds,
+        .tenths = per_second > 1 ? (uint8_t)(shown % per_second) : DISPLAY_TENTHS_OFF,
+        .on_break = on_break,
+        .paused = !timer_running,
+        .progress = left < period ? (uint16_t)((period - left) * UINT16_MAX / period) : 0,
+    });
+    return shown;
+}
 
 /**
- * @brief Callback function for the inactive timer.
+ * @brief Draws an animation frame of the running countdown, unless the
+ * display is still busy with the previous one.
  *
- * This function is called when the timer is inactive. It initializes the display.
+ * @param frame_us The time the frame shows.
+ * @param data Unused.
+ * @return false if the frame was skipped.
+ */
+bool countdown_frame(uint64_t frame_us, void *data)
+{
+    if (display_busy())
+        return false;
+    draw_countdown(frame_us);
+    return true;
+}
+
+/**
+ * @brief Shows the work done today and this week, from the running totals.
+ */
+void show_stats(void)
+{
+    uint64_t now = time_us_64();
+    const stats_totals_t *today = stats_today(&stats, now);
+    const stats_totals_t *week = stats_week(&stats, now);
+
+    display_show(&(display_state_t){
+        .screen = SCREEN_STATS,
+        .today_completed = today->completed,
+        .today_minutes = (uint16_t)(today->work_s / 60),
+        .week_completed = week->completed,
+        .week_started = week->started,
+        .week_minutes = (uint16_t)(week->work_s / 60 > UINT16_MAX ? UINT16_MAX : week->work_s / 60),
+    });
+}
+
+/**
+ * @brief Shows a screen other than the countdown.
  *
- * @param rt Pointer to the repeating timer structure.
- * @return false to stop the timer.
+ * @param screen The screen.
+ * @param value The duration shown by the adjustment screens.
  */
-bool inactive_timer_callback(repeating_timer_t *rt) 
+void show_screen(display_screen_t screen, int value)
 {
-    initial_display();
-    return false;
-}
\ No newline at end of file
+    display_show(&(display_state_t){ .screen = (uint8_t)screen, .minutes = (uint8_t)value });
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include "animation.h"
+#include "probe.h"
+#include "hardware/timer.h"
+
+static void animation_expired(timer_wheel_timer_t *timer, void *data);
+
+void animation_init(animation_t *animation, timer_wheel_t *timers, uint32_t fps, animation_frame_fn_t frame,
+                    void *data) {
+    *animation = (animation_t){ .timers = timers, .fps = fps, .frame = frame, .data = data };
+    timer_wheel_timer_init(&animation->timer, "frame", animation_expired, animation);
+}
+
+static uint64_t animation_frame_us(const animation_t *animation, int64_t number) {
+    return animation->origin_us + number * 1000000 / (int64_t)animation->fps;
+}
+
+/**
+ * @brief Number of the first frame due after now_us.
+ */
+static int64_t animation_next(const animation_t *animation, uint64_t now_us) {
+    int64_t elapsed = (int64_t)(now_us - animation->origin_us);
+    int64_t number = elapsed * (int64_t)animation->fps / 1000000;
+
+    // Division rounds towards zero; step to the first grid point after now
+    while (animation_frame_us(animation, number) <= now_us)
+        ++number;
+    while (animation_frame_us(animation, number - 1) > now_us)
+        --number;
+    return number;
+}
+
+void animation_start(animation_t *animation, uint64_t anchor_us, uint64_t now_us) {
+    if (!animation->running)
+        animation->started_us = now_us;
+    animation->running = true;
+    animation->origin_us = anchor_us;
+    animation->number = animation_next(animation, now_us);
+    timer_wheel_add(animation->timers, &animation->timer, animation_frame_us(animation, animation->number));
+}
+
+void animation_stop(animation_t *animation, uint64_t now_us) {
+    if (!animation->running)
+        return;
+    animation->running = false;
+    animation->run_us += now_us - animation->started_us;
+    timer_wheel_cancel(animation->timers, &animation->timer);
+}
+
+/**
+ * @brief Draws the frame due and schedules the next one still ahead.
+ */
+static void animation_expired(timer_wheel_timer_t *timer, void *data) {
+    animation_t *animation = data;
+    uint32_t start = time_us_32();
+
+    if (animation->frame(timer->deadline_us, animation->data)) {
+        uint32_t elapsed = time_us_32() - start;
+        probe_record(PROBE_FRAME, elapsed);
+        animation->frames++;
+        animation->render_us += elapsed;
+        if (elapsed > animation->render_max_us)
+            animation->render_max_us = elapsed;
+    } else {
+        animation->busy++;
+    }
+
+    // The frame function may have stopped or moved the animation
+    if (!animation->running || animation->timer.pending)
+        return;
+    int64_t next = animation_next(animation, time_us_64());
+    animation->late += (uint32_t)(next - animation->number - 1);
+    animation->number = next;
+    timer_wheel_add(animation->timers, timer, animation_frame_us(animation, next));
+}
+
+void animation_report(const animation_t *animation, uint64_t now_us) {
+    uint64_t run_us = animation->run_us + (animation->running ? now_us - animation->started_us : 0);
+    uint32_t shown = animation->frames;
+
+    printf("frames %lu in %.1f s: %.1f fps of %lu, %lu skipped (%lu display busy, %lu late)\n",
+           (unsigned long)shown, run_us / 1e6, run_us ? shown * 1e6 / run_us : 0.0, (unsigned long)animation->fps,
+           (unsigned long)(animation->busy + animation->late), (unsigned long)animation->busy,
+           (unsigned long)animation->late);
+    printf("render %.1f us per frame, %lu us at most\n", shown ? (double)animation->render_us / shown : 0.0,
+           (unsigned long)animation->render_max_us);
+}
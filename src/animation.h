@@ -0,0 +1,81 @@
+/**
+ * @file animation.h
+ * @brief Fixed-rate frame scheduler on the timer wheel.
+ *
+ * Frames are due on a grid, frame n at origin + n / fps, computed from
+ * the frame number so the rate never drifts. The grid is anchored on a
+ * deadline of the caller's choosing, so a frame falls exactly on it and
+ * on every whole second around it.
+ *
+ * A frame is skipped rather than queued: if the frame function reports
+ * the display still busy with the previous one, or the scheduler comes
+ * back late, the next frame is the first grid point still ahead. The
+ * animation never falls behind; it shows fewer frames.
+ */
+
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "timer_wheel.h"
+
+/**
+ * @brief Draws one frame.
+ *
+ * @param frame_us The time the frame shows, on the grid.
+ * @param data As given to animation_init().
+ * @return false if the frame could not be drawn, the display being busy.
+ */
+typedef bool (*animation_frame_fn_t)(uint64_t frame_us, void *data);
+
+/**
+ * @brief The scheduler and its counters, kept across runs.
+ */
+typedef struct {
+    timer_wheel_t *timers;
+    timer_wheel_timer_t timer;
+    animation_frame_fn_t frame;
+    void *data;
+    uint32_t fps;
+    bool running;
+    uint64_t origin_us;   ///< Grid anchor
+    int64_t number;       ///< Of the frame due next, from origin_us
+    uint64_t started_us;  ///< Start of the current run
+    uint64_t run_us;      ///< Time run before the current run
+    uint32_t frames;      ///< Frames drawn
+    uint32_t busy;        ///< Frames skipped, display busy
+    uint32_t late;        ///< Frames skipped, deadline passed
+    uint64_t render_us;   ///< Time spent in the frame function
+    uint32_t render_max_us;
+} animation_t;
+
+/**
+ * @brief Prepares a stopped animation.
+ *
+ * @param animation The animation to initialise.
+ * @param timers Wheel the frames are scheduled on.
+ * @param fps Frames per second.
+ * @param frame Draws a frame.
+ * @param data Passed to frame.
+ */
+void animation_init(animation_t *animation, timer_wheel_t *timers, uint32_t fps, animation_frame_fn_t frame,
+                    void *data);
+
+/**
+ * @brief Starts the frames, or moves the grid of a running animation.
+ *
+ * @param anchor_us A time the grid goes through, in the past or future.
+ * @param now_us The current time; the first frame is the next grid point.
+ */
+void animation_start(animation_t *animation, uint64_t anchor_us, uint64_t now_us);
+
+void animation_stop(animation_t *animation, uint64_t now_us);
+
+/**
+ * @brief Prints the frame rate reached, the frames skipped and the time
+ * per frame.
+ */
+void animation_report(const animation_t *animation, uint64_t now_us);
+
+#endif // ANIMATION_H
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "console.h"
+#include "probe.h"
+#include "power.h"
+#include "flash_store.h"
+#include "stats.h"
+#include "link.h"
+#include "animation.h"
+#include "trace.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+#define CONSOLE_LINE_MAX 32
+
+static char line[CONSOLE_LINE_MAX];
+static uint8_t line_len;
+static const timer_wheel_t *console_timers;
+static const flash_store_t *console_store;
+static stats_t *console_stats;
+static link_t *console_link;
+static const animation_t *console_animation;
+
+/**
+ * @brief Called by the stdio driver when characters arrive; only wakes
+ * the main loop. The driver calls it from a low-priority IRQ or from
+ * thread mode, where a button or alarm IRQ could post in the middle, so
+ * the post runs with interrupts off.
+ */
+static void console_chars_available(void *param) {
+    uint32_t status = save_and_disable_interrupts();
+    event_queue_post((event_queue_t *)param, EVENT_CONSOLE, 0);
+    restore_interrupts(status);
+}
+
+void console_init(event_queue_t *queue, const timer_wheel_t *timers, const flash_store_t *store,
+                  stats_t *stats, link_t *link, const animation_t *animation) {
+    console_timers = timers;
+    console_store = store;
+    console_stats = stats;
+    console_link = link;
+    console_animation = animation;
+    stdio_set_chars_available_callback(console_chars_available, queue);
+}
+
+static void console_run(const char *command) {
+    if (strcmp(command, "probes") == 0) {
+        probe_dump();
+    } else if (strcmp(command, "probes reset") == 0) {
+        probe_reset();
+    } else if (strcmp(command, "power") == 0) {
+        power_report();
+    } else if (strcmp(command, "timers") == 0) {
+        timer_wheel_dump(console_timers, time_us_64());
+    } else if (strcmp(command, "store") == 0) {
+        flash_store_report(console_store);
+    } else if (strcmp(command, "stats") == 0) {
+        stats_report(console_stats, time_us_64());
+    } else if (strcmp(command, "frames") == 0) {
+        animation_report(console_animation, time_us_64());
+    } else if (strcmp(command, "trace") == 0) {
+        trace_report();
+    } else if (command[0]) {
+        printf("unknown command: %s\n", command);
+    }
+}
+
+/**
+ * @brief Records each byte in the trace and hands it to the binary link
+ * first; what is outside its frames is collected into a line and run on
+ * CR or LF. Lines longer than the buffer are cut short.
+ */
+void console_poll(void) {
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        trace_record(TRACE_RX, (uint8_t)c, 0);
+        if (link_rx(console_link, (uint8_t)c))
+            continue;
+        if (c == '\r' || c == '\n') {
+            line[line_len] = '\0';
+            console_run(line);
+            line_len = 0;
+        } else if (line_len < CONSOLE_LINE_MAX - 1) {
+            line[line_len++] = (char)c;
+        }
+    }
+}
@@ -0,0 +1,47 @@
+/**
+ * @file console.h
+ * @brief Line commands read from stdio (USB CDC on the board).
+ *
+ * Binary link frames (see link.h) share the stream; the bytes between
+ * their delimiters never reach the line console.
+ *
+ * Commands:
+ * - "probes": prints the latency histograms.
+ * - "probes reset": clears them.
+ * - "power": prints the share of time the core was awake.
+ * - "timers": lists the pending timers.
+ * - "store": shows the state of the flash store.
+ * - "stats": prints today's and this week's totals and the latest periods.
+ * - "frames": prints the frame rate of the countdown animation.
+ * - "trace": prints the counters of the input trace.
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include "event_queue.h"
+#include "timer_wheel.h"
+#include "flash_store.h"
+#include "stats.h"
+#include "link.h"
+#include "animation.h"
+
+/**
+ * @brief Posts EVENT_CONSOLE to the queue whenever input arrives.
+ *
+ * @param queue The main loop's event ring.
+ * @param timers The timer wheel listed by the "timers" command.
+ * @param store The store shown by the "store" command.
+ * @param stats The statistics printed by the "stats" command.
+ * @param link The binary link that gets the input first.
+ * @param animation The animation reported by the "frames" command.
+ */
+void console_init(event_queue_t *queue, const timer_wheel_t *timers, const flash_store_t *store,
+                  stats_t *stats, link_t *link, const animation_t *animation);
+
+/**
+ * @brief Reads the pending input and runs the completed lines. Main loop only.
+ */
+void console_poll(void);
+
+#endif // CONSOLE_H
@@ -0,0 +1,29 @@
+/**
+ * @file crc16.h
+ * @brief CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF).
+ *
+ * Used by the flash store records and the USB link frames. A nibble at a
+ * time: four times the speed of the bitwise loop for a 32-byte table,
+ * where a byte-wide one would take 512.
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+static inline uint16_t crc16(const uint8_t *data, size_t length) {
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+    uint16_t crc = 0xFFFF;
+    while (length--) {
+        crc = (uint16_t)(crc << 4) ^ table[(crc >> 12) ^ (*data >> 4)];
+        crc = (uint16_t)(crc << 4) ^ table[(crc >> 12) ^ (*data++ & 0x0F)];
+    }
+    return crc;
+}
+
+#endif // CRC16_H
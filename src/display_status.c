@@ -1,28 +1,109 @@
 #include "display_status.h"
 #include "../inc/ssd1306.h"
+#include "event_queue.h"
+#include "probe.h"
+#include "widget.h"
 #include <stdio.h>
 
+#if POMODORO_MULTICORE
+#include "hardware_init.h"
+#include "seqlock.h"
+#include "hardware/sync.h"
+#include "pico/flash.h"
+
+static seqlock_t display_lock;
+static display_state_t display_published; ///< Written by core0 under display_lock
+static volatile uint32_t display_sent;    ///< Sequence of the last state core1 sent
+#endif
+
 extern ssd1306_t ssd;
+#if POMODORO_STATS_DISPLAY
+extern ssd1306_t ssd_aux;
+#define STATS_PANEL ssd_aux ///< The statistics have a panel of their own
+#else
+#define STATS_PANEL ssd
+#endif
+
+#if POMODORO_PROBES && !POMODORO_MULTICORE
+static uint32_t flush_start_us; ///< Start of the transfer in flight
+#endif
+
+_Static_assert(WIDTH == 128 && HEIGHT == 64, "the screens are laid out for a 128x64 panel");
+
+#define PROGRESS_WIDTH (WIDTH - 20)
+#define COUNTDOWN_FONT font_7seg ///< Or font_8x8, font_16x16, font_24x24
+#define COUNTDOWN_Y 24           ///< Page-aligned, so digits are blitted as whole bytes
+#if POMODORO_TENTHS
+#define TENTHS_CHARS 2           ///< ".9" after the seconds; font_24x24 leaves no room for it
+#else
+#define TENTHS_CHARS 0
+#endif
+#define COUNTDOWN_X ((WIDTH - 5 * COUNTDOWN_FONT.width - TENTHS_CHARS * font_8x8.width) / 2)
+
+// Two bars, in the column/page layout of the framebuffer
+static const uint8_t pause_columns[] = {0x00, 0x7E, 0x7E, 0x00, 0x00, 0x7E, 0x7E, 0x00};
+static const ssd1306_bitmap_t pause_icon = {8, 8, 1, pause_columns};
+
+static widget_t title, start_hint, pause_hint;
+static widget_t status, paused, countdown, tenths, progress;
+static widget_t adjust_title, adjust_to, adjust_value;
+static widget_t stats_title, stats_today, stats_week, stats_done;
+static bool widgets_ready;
+
+static widget_t *const initial_widgets[] = {&title, &start_hint, &pause_hint};
+static widget_t *const countdown_widgets[] = {&status, &paused, &countdown, &tenths, &progress};
+static widget_t *const adjust_widgets[] = {&adjust_title, &adjust_to, &adjust_value};
+static widget_t *const stats_widgets[] = {&stats_title, &stats_today, &stats_week, &stats_done};
+
+static const widget_screen_t initial_screen = {initial_widgets, 3, true};
+static const widget_screen_t countdown_screen = {countdown_widgets, 5, true};
+static const widget_screen_t adjust_screen = {adjust_widgets, 3, true};
+static const widget_screen_t stats_screen = {stats_widgets, 4, true};
+
+/**
+ * @brief Lays out every widget the first time a screen is drawn.
+ */
+static void init_widgets(void) {
+    if (widgets_ready)
+        return;
+    widgets_ready = true;
+
+    widget_text_init(&title, &font_8x8, 10, 10, 14, "Pomodoro Timer");
+    widget_text_init(&start_hint, &font_8x8, 10, 30, 10, "A to start");
+    widget_text_init(&pause_hint, &font_8x8, 10, 40, 10, "B to pause");
+
+    widget_text_init(&status, &font_8x8, 10, 10, 5, "Work");
+    widget_icon_init(&paused, 60, 10, pause_icon.width, pause_icon.height);
+    widget_text_init(&countdown, &COUNTDOWN_FONT, COUNTDOWN_X, COUNTDOWN_Y, 5, "00:00");
+    // Bottom-aligned with the digits, on a page boundary too
+    widget_text_init(&tenths, &font_8x8, COUNTDOWN_X + 5 * COUNTDOWN_FONT.width,
+                     COUNTDOWN_Y + COUNTDOWN_FONT.height - font_8x8.height, TENTHS_CHARS, "");
+    widget_progress_init(&progress, 10, 48, PROGRESS_WIDTH, 8);
+
+    widget_text_init(&adjust_title, &font_8x8, 10, 10, 14, "");
+    widget_text_init(&adjust_to, &font_8x8, 10, 20, 2, "to");
+    widget_text_init(&adjust_value, &font_8x8, 10, 30, 10, "");
+
+    widget_text_init(&stats_title, &font_8x8, 10, 10, 10, "Statistics");
+    widget_text_init(&stats_today, &font_8x8, 10, 26, 14, "");
+    widget_text_init(&stats_week, &font_8x8, 10, 38, 14, "");
+    widget_text_init(&stats_done, &font_8x8, 10, 50, 14, "");
+}
 
 /**
  * @brief Initializes the display with the initial screen for the Pomodoro Timer.
  * 
- * This function clears the display, draws a border around the screen, and displays
- * the initial instructions for the Pomodoro Timer. The instructions include:
+ * This function shows a border around the screen and the initial
+ * instructions for the Pomodoro Timer. The instructions include:
  * - "Pomodoro Timer" at coordinates (10, 10)
  * - "A to start" at coordinates (10, 30)
  * - "B to pause" at coordinates (10, 40)
  * 
- * The function then sends the data to the display to update it.
+ * The main loop sends the changes to the display with display_flush().
  */
 void initial_display()  {
-    ssd1306_fill(&ssd, false);
-    
-    ssd1306_rect(&ssd, 0, 0, WIDTH, HEIGHT, true, false);
-    ssd1306_draw_string(&ssd, "Pomodoro Timer", 10, 10);
-    ssd1306_draw_string(&ssd, "A to start", 10, 30);
-    ssd1306_draw_string(&ssd, "B to pause", 10, 40);
-    ssd1306_send_data(&ssd);
+    init_widgets();
+    widget_screen_render(&ssd, &initial_screen);
 }
 
 /**
@@ -30,22 +111,207 @@ void initial_display()  {
  *
  * This function updates the timer display with the given minutes and seconds.
  * It also indicates whether the timer is in a break period or a work period.
+ * Coming from another screen the whole countdown screen is drawn; after
+ * that only the characters that changed are, usually the last digit.
  *
  * @param minutes The number of minutes to display.
  * @param seconds The number of seconds to display.
  * @param on_break A boolean indicating if the timer is in a break period (true) or a work period (false).
  */
 void update_timer(int minutes, int seconds, bool on_break) {
-    char timer[16];
-    snprintf(timer, sizeof(timer), "%02d:%02d", minutes, seconds);
-
-    ssd1306_fill(&ssd, false);
-    ssd1306_rect(&ssd, 0, 0, WIDTH, HEIGHT, true, false);
-    if (on_break) {
-        ssd1306_draw_string(&ssd, "Break", 10, 10);
-    } else {
-        ssd1306_draw_string(&ssd, "Work", 10, 10);
+    init_widgets();
+    widget_set_text(&status, on_break ? "Break" : "Work");
+    widget_set_time(&countdown, minutes, seconds);
+    widget_screen_render(&ssd, &countdown_screen);
+}
+
+/**
+ * @brief Draws the screen announcing a new work or break duration.
+ *
+ * @param is_work_time Whether the work or the break duration changed.
+ * @param minutes The new duration.
+ */
+void adjust_display(bool is_work_time, int minutes) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%d minutes", minutes);
+
+    init_widgets();
+    widget_set_text(&adjust_title, is_work_time ? "Work time set " : "Break time set");
+    widget_set_text(&adjust_value, buffer);
+    widget_screen_render(&ssd, &adjust_screen);
+}
+
+/**
+ * @brief Draws the work done today and this week.
+ *
+ * Periods completed and minutes of work, then how many of the week's
+ * work periods were run to the end. Minutes are capped at 9999 and
+ * periods at 999 to keep each line inside its widget and the border.
+ * With POMODORO_STATS_DISPLAY they are drawn on the statistics panel and
+ * the main one is left as it is.
+ *
+ * @param state The totals, in the stats fields.
+ */
+void stats_display(const display_state_t *state) {
+    char buffer[WIDGET_TEXT_MAX + 1];
+
+    init_widgets();
+    snprintf(buffer, sizeof(buffer), "Today%3u %4um", state->today_completed > 999 ? 999 : state->today_completed,
+             state->today_minutes > 9999 ? 9999 : state->today_minutes);
+    widget_set_text(&stats_today, buffer);
+    snprintf(buffer, sizeof(buffer), "Week %3u %4um", state->week_completed > 999 ? 999 : state->week_completed,
+             state->week_minutes > 9999 ? 9999 : state->week_minutes);
+    widget_set_text(&stats_week, buffer);
+    snprintf(buffer, sizeof(buffer), "Done %u/%u", state->week_completed > 999 ? 999 : state->week_completed,
+             state->week_started > 999 ? 999 : state->week_started);
+    widget_set_text(&stats_done, buffer);
+    widget_screen_render(&STATS_PANEL, &stats_screen);
+}
+
+/**
+ * @brief Draws the screen described by a state.
+ *
+ * @param state The screen and its values.
+ */
+void display_render(const display_state_t *state) {
+    switch (state->screen) {
+    case SCREEN_INITIAL:
+        initial_display();
+        break;
+    case SCREEN_COUNTDOWN:
+        init_widgets();
+        widget_set_icon(&paused, state->paused ? &pause_icon : NULL);
+        widget_set_progress(&progress, state->progress, UINT16_MAX);
+        if (state->tenths == DISPLAY_TENTHS_OFF)
+            widget_set_text(&tenths, "");
+        else
+            widget_set_text(&tenths, (char[]){'.', (char)('0' + state->tenths), '\0'});
+        update_timer(state->minutes, state->seconds, state->on_break);
+        break;
+    case SCREEN_ADJUST_WORK:
+    case SCREEN_ADJUST_BREAK:
+        adjust_display(state->screen == SCREEN_ADJUST_WORK, state->minutes);
+        break;
+    case SCREEN_STATS:
+        stats_display(state);
+        break;
     }
-    ssd1306_draw_string(&ssd, timer, 10, 30);
-    ssd1306_send_data(&ssd);
-}
\ No newline at end of file
+}
+
+#if POMODORO_MULTICORE
+/**
+ * @brief Publishes a state to core1 and wakes it. Never waits for core1.
+ *
+ * @param state The screen and its values.
+ */
+void display_show(const display_state_t *state) {
+    seqlock_write_begin(&display_lock);
+    display_published = *state;
+    seqlock_write_end(&display_lock);
+    __sev();
+}
+
+bool display_busy(void) {
+    return display_lock.sequence != display_sent;
+}
+
+bool display_flush(void) {
+    return false;
+}
+
+/**
+ * @brief Core1 loop: draws and sends the latest published state.
+ *
+ * States published while a transfer is in progress are coalesced: only
+ * the latest one is drawn afterwards. A publish between the check and
+ * __wfe() sets the event register, so it is never slept through. Core0
+ * parks this core while it writes the flash store.
+ */
+void display_core1_main(void) {
+    uint32_t drawn = 0;
+
+    flash_safe_execute_core_init();
+    init_display();
+    for (;;) {
+        display_state_t state;
+        uint32_t sequence;
+        do {
+            sequence = seqlock_read_begin(&display_lock);
+            state = display_published;
+        } while (seqlock_read_retry(&display_lock, sequence));
+
+        if (sequence == drawn) {
+            __wfe();
+            continue;
+        }
+        drawn = sequence;
+
+        display_render(&state);
+        PROBE_BEGIN(start);
+        ssd1306_send_data(&ssd);
+        PROBE_END(PROBE_FLUSH, start);
+        display_sent = sequence;
+    }
+}
+#else
+/**
+ * @brief Draws a state at once; display_flush() sends it.
+ *
+ * @param state The screen and its values.
+ */
+void display_show(const display_state_t *state) {
+    display_render(state);
+}
+
+bool display_busy(void) {
+    return ssd1306_busy(&ssd);
+}
+
+/**
+ * @brief Starts sending the framebuffer changes to the display.
+ *
+ * The transfer runs on DMA and this function returns right away. If a
+ * previous transfer is still in flight, the changes stay pending; its
+ * completion posts EVENT_FLUSH_DONE, which wakes the main loop to call
+ * this function again.
+ *
+ * With POMODORO_STATS_DISPLAY the statistics panel is flushed first. It
+ * has its own bus and DMA channel, so both transfers run side by side.
+ *
+ * @return true if changes were sent to the main panel, so its framebuffer
+ * is now what it will show.
+ */
+bool display_flush(void) {
+#if POMODORO_STATS_DISPLAY
+    if (ssd1306_is_dirty(&ssd_aux))
+        ssd1306_send_data_async(&ssd_aux);
+#endif
+    if (!ssd1306_is_dirty(&ssd))
+        return false;
+#if POMODORO_PROBES
+    uint32_t now = time_us_32();
+    if (!ssd1306_send_data_async(&ssd))
+        return false;
+    if (ssd1306_busy(&ssd))
+        flush_start_us = now;
+    return true;
+#else
+    return ssd1306_send_data_async(&ssd);
+#endif
+}
+
+/**
+ * @brief Flush completion callback, runs in the DMA IRQ.
+ *
+ * Only posts EVENT_FLUSH_DONE: the main loop may be halfway through
+ * drawing, so the next transfer must be started from there.
+ *
+ * @param display The display whose transfer completed.
+ * @param data The event_queue_t to post to.
+ */
+void display_flush_done(ssd1306_t *display, void *data) {
+    if (display == &ssd)
+        PROBE_END(PROBE_FLUSH, flush_start_us);
+    event_queue_post((event_queue_t *)data, EVENT_FLUSH_DONE, 0);
+}
+#endif // POMODORO_MULTICORE
\ No newline at end of file
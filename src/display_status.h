@@ -10,6 +10,40 @@
 #define DISPLAY_STATUS_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "../inc/ssd1306.h"
+
+/**
+ * @brief Screens the application can show.
+ */
+typedef enum {
+    SCREEN_INITIAL,       ///< Instructions
+    SCREEN_COUNTDOWN,     ///< Work or break countdown
+    SCREEN_ADJUST_WORK,   ///< New work duration, in minutes
+    SCREEN_ADJUST_BREAK,  ///< New break duration, in minutes
+    SCREEN_STATS,         ///< Work done today and this week
+} display_screen_t;
+
+#define DISPLAY_TENTHS_OFF 0xFF ///< No tenths readout
+
+/**
+ * @brief Everything needed to draw a screen, small enough to be copied
+ * between cores.
+ */
+typedef struct {
+    uint8_t screen;   ///< One of display_screen_t
+    uint8_t minutes;  ///< Countdown minutes, or the adjusted duration
+    uint8_t seconds;  ///< Countdown seconds
+    bool on_break;    ///< Countdown of a break
+    bool paused;      ///< Countdown paused
+    uint8_t tenths;   ///< Countdown tenths of a second, or DISPLAY_TENTHS_OFF
+    uint16_t progress; ///< Part of the period elapsed, out of 65535
+    uint16_t today_completed; ///< Stats: work periods completed today
+    uint16_t today_minutes;   ///< Stats: minutes of work today
+    uint16_t week_completed;  ///< Stats: work periods completed this week
+    uint16_t week_started;    ///< Stats: work periods started this week
+    uint16_t week_minutes;    ///< Stats: minutes of work this week
+} display_state_t;
 
 /**
  * @brief Initializes the display.
@@ -21,7 +55,8 @@ void initial_display(void);
 /**
  * @brief Updates the timer display.
  *
- * This function updates the display with the current timer values.
+ * This function updates the display with the current timer values,
+ * redrawing only what changed since the last call.
  *
  * @param minutes The number of minutes remaining.
  * @param seconds The number of seconds remaining.
@@ -29,4 +64,64 @@ void initial_display(void);
  */
 void update_timer(int minutes, int seconds, bool on_break);
 
+/**
+ * @brief Draws the screen announcing a new work or break duration.
+ *
+ * @param is_work_time Whether the work or the break duration changed.
+ * @param minutes The new duration.
+ */
+void adjust_display(bool is_work_time, int minutes);
+
+/**
+ * @brief Draws the work done today and this week.
+ *
+ * @param state The totals, in the stats fields.
+ */
+void stats_display(const display_state_t *state);
+
+/**
+ * @brief Draws the screen described by a state.
+ */
+void display_render(const display_state_t *state);
+
+/**
+ * @brief Shows a state on the display.
+ *
+ * In the single-core build the state is drawn at once and sent by
+ * display_flush(). With POMODORO_MULTICORE it is published to core1,
+ * which draws and sends it while core0 carries on.
+ */
+void display_show(const display_state_t *state);
+
+/**
+ * @brief Whether the display is still taking the last frame: a transfer
+ * in flight, or on core1 a published state not yet sent.
+ */
+bool display_busy(void);
+
+/**
+ * @brief Sends the framebuffer changes to the display without blocking.
+ * Does nothing in the multicore build, where core1 sends them.
+ *
+ * @return true if changes were sent.
+ */
+bool display_flush(void);
+
+#if POMODORO_MULTICORE
+/**
+ * @brief Core1 entry point: initialises the display, then draws and sends
+ * every state published by display_show(), skipping the ones superseded
+ * while a transfer was in progress.
+ */
+void display_core1_main(void);
+#else
+/**
+ * @brief Flush completion callback registered with the SSD1306 driver.
+ *
+ * @param display The display whose transfer completed.
+ * @param data The event_queue_t to post to.
+ */
+void display_flush_done(ssd1306_t *display, void *data);
+#endif
+
 #endif // DISPLAY_STATUS_H
\ No newline at end of file
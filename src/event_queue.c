@@ -0,0 +1,53 @@
+#include "event_queue.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+/**
+ * @brief Posts an event and wakes the main loop.
+ *
+ * The slot is filled before head is published, with a barrier in between,
+ * so the consumer never reads a partially written event. __sev() makes a
+ * __wfe() that races with the post return immediately.
+ *
+ * @param queue The ring.
+ * @param type Kind of event.
+ * @param arg Event-specific argument.
+ * @return false if the ring was full and the event was dropped.
+ */
+bool event_queue_post(event_queue_t *queue, event_type_t type, uint8_t arg) {
+    uint32_t head = queue->head;
+    if (head - queue->tail == EVENT_QUEUE_SIZE) {
+        queue->dropped++;
+        return false;
+    }
+
+    event_t *event = &queue->events[head & (EVENT_QUEUE_SIZE - 1)];
+    event->type = type;
+    event->arg = arg;
+    event->time_us = time_us_32();
+
+    __dmb();
+    queue->head = head + 1;
+    __sev();
+    return true;
+}
+
+/**
+ * @brief Takes the oldest event.
+ *
+ * @param queue The ring.
+ * @param event Receives the event.
+ * @return false if the ring is empty.
+ */
+bool event_queue_pop(event_queue_t *queue, event_t *event) {
+    uint32_t tail = queue->tail;
+    if (tail == queue->head) {
+        return false;
+    }
+
+    __dmb();
+    *event = queue->events[tail & (EVENT_QUEUE_SIZE - 1)];
+    __dmb();
+    queue->tail = tail + 1;
+    return true;
+}
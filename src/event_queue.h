@@ -0,0 +1,70 @@
+/**
+ * @file event_queue.h
+ * @brief Fixed-capacity single-producer/single-consumer event ring.
+ *
+ * Interrupt handlers post compact events and return; the main loop drains
+ * them and does the actual work. The GPIO, timer alarm and DMA IRQs run
+ * at the same NVIC priority and cannot preempt each other. Any other
+ * producer, like the stdio callback of the console, posts with interrupts
+ * off, so together they act as a single producer. The main loop is the
+ * only consumer.
+ */
+
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define EVENT_QUEUE_SIZE 32 ///< Capacity, must be a power of two
+
+/**
+ * @brief Kinds of events posted from interrupt context.
+ */
+typedef enum {
+    EVENT_BUTTON,            ///< Edge on a button, arg is the GPIO
+    EVENT_TIMER,             ///< The timer wheel's hardware alarm fired
+    EVENT_FLUSH_DONE,        ///< A display transfer completed
+    EVENT_CONSOLE,           ///< Characters arrived on stdio
+} event_type_t;
+
+/**
+ * @brief One queued event, 8 bytes.
+ */
+typedef struct {
+    uint8_t type;     ///< One of event_type_t
+    uint8_t arg;      ///< Event-specific argument
+    uint32_t time_us; ///< Low 32 bits of time_us_64() when posted
+} event_t;
+
+/**
+ * @brief The ring itself. head is written only by the producer, tail only
+ * by the consumer.
+ */
+typedef struct {
+    event_t events[EVENT_QUEUE_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped; ///< Events lost because the ring was full
+} event_queue_t;
+
+/**
+ * @brief Posts an event. Safe to call from interrupt context.
+ *
+ * @param queue The ring.
+ * @param type Kind of event.
+ * @param arg Event-specific argument.
+ * @return false if the ring was full and the event was dropped.
+ */
+bool event_queue_post(event_queue_t *queue, event_type_t type, uint8_t arg);
+
+/**
+ * @brief Takes the oldest event. Main loop only.
+ *
+ * @param queue The ring.
+ * @param event Receives the event.
+ * @return false if the ring is empty.
+ */
+bool event_queue_pop(event_queue_t *queue, event_t *event);
+
+#endif // EVENT_QUEUE_H
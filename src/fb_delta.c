@@ -0,0 +1,96 @@
+#include <string.h>
+#include "fb_delta.h"
+
+#define SKIP_MAX 128
+#define REPEAT_MIN 3
+#define REPEAT_MAX 66
+#define LITERAL_MAX 64
+
+/**
+ * @brief Codes one page line of XOR bytes. Unchanged bytes only add to
+ * *skip, so a run of them can go on into the next line, and is written
+ * once something changes after it.
+ */
+static size_t encode_line(const uint8_t *line, uint8_t width, unsigned *skip, uint8_t *out) {
+    size_t n = 0;
+
+    for (unsigned x = 0; x < width;) {
+        if (line[x] == 0) {
+            ++*skip;
+            ++x;
+            continue;
+        }
+        for (; *skip > 0; *skip -= *skip < SKIP_MAX ? *skip : SKIP_MAX)
+            out[n++] = (uint8_t)((*skip < SKIP_MAX ? *skip : SKIP_MAX) - 1);
+
+        unsigned run = 1;
+        while (x + run < width && run < REPEAT_MAX && line[x + run] == line[x])
+            ++run;
+        if (run >= REPEAT_MIN) {
+            out[n++] = (uint8_t)(0x80 | (run - REPEAT_MIN));
+            out[n++] = line[x];
+            x += run;
+            continue;
+        }
+
+        // Literals, through single zeros, up to two zeros or a repeat
+        unsigned start = x;
+        while (x < width && x - start < LITERAL_MAX) {
+            if (line[x] == 0 && (x + 1 == width || line[x + 1] == 0))
+                break;
+            if (x > start && x + 2 < width && line[x] == line[x + 1] && line[x] == line[x + 2])
+                break;
+            ++x;
+        }
+        out[n++] = (uint8_t)(0xC0 | (x - start - 1));
+        memcpy(&out[n], &line[start], x - start);
+        n += x - start;
+    }
+    return n;
+}
+
+size_t fb_delta_encode(uint8_t *reference, const uint8_t *frame, uint8_t width, uint8_t pages, uint8_t *out) {
+    uint8_t line[FB_DELTA_WIDTH_MAX];
+    unsigned skip = 0;
+    size_t n = 0;
+
+    for (uint8_t page = 0; page < pages; ++page) {
+        for (unsigned x = 0, i = page; x < width; ++x, i += pages) {
+            line[x] = reference[i] ^ frame[i];
+            reference[i] = frame[i];
+        }
+        n += encode_line(line, width, &skip, out + n);
+    }
+    return n;
+}
+
+bool fb_delta_decode(uint8_t *frame, uint8_t width, uint8_t pages, const uint8_t *in, size_t length) {
+    size_t total = (size_t)width * pages, k = 0;
+
+    for (size_t i = 0; i < length;) {
+        uint8_t code = in[i++];
+        size_t count;
+        if (code < 0x80) {
+            k += code + 1u;
+            if (k > total)
+                return false;
+            continue;
+        }
+        if (code < 0xC0) {
+            count = code - 0x80u + REPEAT_MIN;
+            if (i + 1 > length)
+                return false;
+        } else {
+            count = code - 0xC0u + 1;
+            if (i + count > length)
+                return false;
+        }
+        if (k + count > total)
+            return false;
+
+        for (size_t j = 0; j < count; ++j, ++k)
+            frame[(k % width) * pages + k / width] ^= code < 0xC0 ? in[i] : in[i + j];
+        i += code < 0xC0 ? 1 : count;
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file fb_delta.h
+ * @brief Compression of SSD1306 framebuffers for mirroring to a host.
+ *
+ * A frame is encoded as the XOR of it with the previous one, so unchanged
+ * bytes are zero; a key frame is simply the XOR with a blank screen. The
+ * XOR bytes are taken page by page, left to right, which puts a line of
+ * text or a bar in one stretch, and coded as tokens:
+ *
+ * - 0x00-0x7F: n + 1 unchanged bytes (1-128)
+ * - 0x80-0xBF: the next byte, n + 3 times (3-66)
+ * - 0xC0-0xFF: n + 1 literal bytes follow (1-64)
+ *
+ * Unchanged bytes at the end are left out, so an unchanged frame encodes
+ * to nothing. Frames use the driver's layout, column after column with
+ * the pages of a column next to each other. This file needs no SDK: the
+ * host-side viewer decodes with it.
+ */
+
+#ifndef FB_DELTA_H
+#define FB_DELTA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FB_DELTA_WIDTH_MAX 128
+
+/// Worst case of fb_delta_encode(): two literal headers per page line
+#define FB_DELTA_MAX(width, pages) ((size_t)(width) * (pages) + 2 * (pages) * (((width) + 63) / 64))
+
+/**
+ * @brief Encodes the changes from reference to frame, and updates
+ * reference to frame.
+ *
+ * @param reference The frame the decoder has, width * pages bytes.
+ * @param frame The new frame.
+ * @param out At least FB_DELTA_MAX(width, pages) bytes.
+ * @return Bytes written, 0 if nothing changed.
+ */
+size_t fb_delta_encode(uint8_t *reference, const uint8_t *frame, uint8_t width, uint8_t pages, uint8_t *out);
+
+/**
+ * @brief Applies encoded changes to a frame.
+ *
+ * @return false if the data is malformed or runs past the frame.
+ */
+bool fb_delta_decode(uint8_t *frame, uint8_t width, uint8_t pages, const uint8_t *in, size_t length);
+
+#endif // FB_DELTA_H
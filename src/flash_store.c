@@ -0,0 +1,275 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "flash_store.h"
+#include "crc16.h"
+#include "pico/flash.h"
+
+#define FLASH_STORE_MAGIC 0x506D5354u  ///< "TSmP", in the header of every sector
+#define FLASH_STORE_HEADER 0           ///< Key of the header record
+#define FLASH_STORE_OP_PAGES 2         ///< Pages one sync programs at most
+#define FLASH_STORE_TIMEOUT_MS 10      ///< To park the other core
+
+/**
+ * @brief One record as it sits in flash. Erased flash reads as all 0xFF,
+ * which is never a valid record.
+ */
+typedef struct {
+    uint8_t key;
+    uint8_t length;
+    uint8_t value[FLASH_STORE_VALUE_MAX];
+    uint16_t crc; ///< CRC-16/CCITT of everything before it
+} flash_store_record_t;
+
+_Static_assert(sizeof(flash_store_record_t) == FLASH_STORE_RECORD_SIZE, "records must tile the pages");
+_Static_assert(FLASH_PAGE_SIZE % FLASH_STORE_RECORD_SIZE == 0, "records must not straddle pages");
+_Static_assert(STORE_KEYS * FLASH_STORE_RECORD_SIZE <= FLASH_PAGE_SIZE, "a compacted log must fit in one page");
+
+/**
+ * @brief Flash work run with the flash taken: an optional sector erase,
+ * then page programs in order.
+ */
+typedef struct {
+    bool erase;
+    uint32_t erase_offset;
+    uint8_t count;
+    uint32_t offsets[FLASH_STORE_OP_PAGES];
+    uint8_t pages[FLASH_STORE_OP_PAGES][FLASH_PAGE_SIZE];
+} flash_store_op_t;
+
+static flash_store_op_t flash_store_op; ///< Too big for the stack
+
+static uint32_t flash_store_slot_offset(const flash_store_t *store, uint8_t sector, uint16_t slot) {
+    return store->offset + sector * FLASH_SECTOR_SIZE + slot * FLASH_STORE_RECORD_SIZE;
+}
+
+// Flash is read through the XIP window
+static const flash_store_record_t *flash_store_slot(const flash_store_t *store, uint8_t sector, uint16_t slot) {
+    return (const flash_store_record_t *)(XIP_BASE + flash_store_slot_offset(store, sector, slot));
+}
+
+static bool flash_store_erased(const flash_store_record_t *record) {
+    const uint8_t *bytes = (const uint8_t *)record;
+    for (size_t i = 0; i < sizeof(*record); ++i) {
+        if (bytes[i] != 0xFF)
+            return false;
+    }
+    return true;
+}
+
+static bool flash_store_sector_erased(const flash_store_t *store, uint8_t sector) {
+    for (uint16_t slot = 0; slot < FLASH_STORE_SLOTS; ++slot) {
+        if (!flash_store_erased(flash_store_slot(store, sector, slot)))
+            return false;
+    }
+    return true;
+}
+
+static bool flash_store_valid(const flash_store_record_t *record) {
+    return record->length <= FLASH_STORE_VALUE_MAX &&
+           record->crc == crc16((const uint8_t *)record, offsetof(flash_store_record_t, crc));
+}
+
+static flash_store_record_t flash_store_record(uint8_t key, const void *value, uint8_t length) {
+    flash_store_record_t record = { .key = key, .length = length };
+    memset(record.value, 0xFF, sizeof(record.value));
+    memcpy(record.value, value, length);
+    record.crc = crc16((const uint8_t *)&record, offsetof(flash_store_record_t, crc));
+    return record;
+}
+
+void flash_store_init(flash_store_t *store, uint32_t offset) {
+    // With no valid sector the first sync compacts into sector 0
+    *store = (flash_store_t){
+        .offset = offset,
+        .active = FLASH_STORE_SECTORS - 1,
+        .next_slot = FLASH_STORE_SLOTS,
+    };
+
+    bool found = false;
+    for (uint8_t sector = 0; sector < FLASH_STORE_SECTORS; ++sector) {
+        const flash_store_record_t *header = flash_store_slot(store, sector, 0);
+        uint32_t magic, sequence;
+        if (header->key != FLASH_STORE_HEADER || header->length != 8 || !flash_store_valid(header))
+            continue;
+        memcpy(&magic, header->value, 4);
+        memcpy(&sequence, header->value + 4, 4);
+        if (magic != FLASH_STORE_MAGIC)
+            continue;
+        if (!found || (int32_t)(sequence - store->sequence) > 0) {
+            found = true;
+            store->active = sector;
+            store->sequence = sequence;
+        }
+    }
+    store->spare_erased = flash_store_sector_erased(store, (store->active + 1) % FLASH_STORE_SECTORS);
+    if (!found)
+        return;
+
+    // Later records of a key replace earlier ones
+    store->next_slot = 1;
+    for (uint16_t slot = 1; slot < FLASH_STORE_SLOTS; ++slot) {
+        const flash_store_record_t *record = flash_store_slot(store, store->active, slot);
+        if (flash_store_erased(record))
+            break;
+        store->next_slot = slot + 1;
+        if (record->key == FLASH_STORE_HEADER || record->key >= STORE_KEYS || !flash_store_valid(record)) {
+            store->skipped++;
+            continue;
+        }
+        memcpy(store->values[record->key], record->value, record->length);
+        store->lengths[record->key] = record->length;
+    }
+}
+
+bool flash_store_get(const flash_store_t *store, store_key_t key, void *value, uint8_t length) {
+    if (store->lengths[key] != length)
+        return false;
+    memcpy(value, store->values[key], length);
+    return true;
+}
+
+void flash_store_set(flash_store_t *store, store_key_t key, const void *value, uint8_t length) {
+    hard_assert(key > FLASH_STORE_HEADER && key < STORE_KEYS && length > 0 && length <= FLASH_STORE_VALUE_MAX);
+    if (store->lengths[key] == length && memcmp(store->values[key], value, length) == 0)
+        return;
+    memcpy(store->values[key], value, length);
+    store->lengths[key] = length;
+    store->dirty |= 1 << key;
+}
+
+bool flash_store_pending(const flash_store_t *store) {
+    return store->dirty != 0;
+}
+
+static uint16_t flash_store_dirty_count(const flash_store_t *store) {
+    uint16_t count = 0;
+    for (uint8_t key = FLASH_STORE_HEADER + 1; key < STORE_KEYS; ++key)
+        count += (store->dirty >> key) & 1;
+    return count;
+}
+
+uint32_t flash_store_sync_us(const flash_store_t *store) {
+    if (!store->dirty)
+        return 0;
+    if (store->next_slot + flash_store_dirty_count(store) > FLASH_STORE_SLOTS && !store->spare_erased)
+        return FLASH_STORE_SYNC_MAX_US;
+    return FLASH_STORE_APPEND_MAX_US;
+}
+
+uint32_t flash_store_prepare_us(const flash_store_t *store) {
+    return store->spare_erased ? 0 : FLASH_STORE_ERASE_MAX_US;
+}
+
+static void flash_store_apply(void *param) {
+    const flash_store_op_t *op = param;
+    if (op->erase)
+        flash_range_erase(op->erase_offset, FLASH_SECTOR_SIZE);
+    for (uint8_t i = 0; i < op->count; ++i)
+        flash_range_program(op->offsets[i], op->pages[i], FLASH_PAGE_SIZE);
+}
+
+/**
+ * @brief Places a record in the op, adding a page of 0xFF for it if it is
+ * the first one there. Programming 0xFF leaves flash as it is, so the
+ * records already in the page are untouched.
+ */
+static void flash_store_op_put(flash_store_op_t *op, uint32_t offset, const flash_store_record_t *record) {
+    uint32_t page = offset & ~(uint32_t)(FLASH_PAGE_SIZE - 1);
+    if (op->count == 0 || op->offsets[op->count - 1] != page) {
+        hard_assert(op->count < FLASH_STORE_OP_PAGES);
+        op->offsets[op->count] = page;
+        memset(op->pages[op->count], 0xFF, FLASH_PAGE_SIZE);
+        op->count++;
+    }
+    memcpy(&op->pages[op->count - 1][offset - page], record, sizeof(*record));
+}
+
+/**
+ * @brief Starts the log over in the next sector of the ring with the
+ * current value of every key, erasing it first unless
+ * flash_store_prepare() already has.
+ *
+ * The records are programmed before the header, so until the header is
+ * there the old sector is still the valid one.
+ */
+static bool flash_store_compact(flash_store_t *store) {
+    flash_store_op_t *op = &flash_store_op;
+    uint8_t sector = (store->active + 1) % FLASH_STORE_SECTORS;
+    uint32_t sequence = store->sequence + 1;
+    uint16_t slot = 1;
+
+    *op = (flash_store_op_t){ .erase = !store->spare_erased, .erase_offset = flash_store_slot_offset(store, sector, 0) };
+    for (uint8_t key = FLASH_STORE_HEADER + 1; key < STORE_KEYS; ++key) {
+        if (!store->lengths[key])
+            continue;
+        flash_store_record_t record = flash_store_record(key, store->values[key], store->lengths[key]);
+        flash_store_op_put(op, flash_store_slot_offset(store, sector, slot++), &record);
+    }
+
+    uint8_t value[8];
+    uint32_t magic = FLASH_STORE_MAGIC;
+    memcpy(value, &magic, 4);
+    memcpy(value + 4, &sequence, 4);
+    flash_store_record_t header = flash_store_record(FLASH_STORE_HEADER, value, sizeof(value));
+    op->offsets[op->count] = op->erase_offset;
+    memset(op->pages[op->count], 0xFF, FLASH_PAGE_SIZE);
+    memcpy(op->pages[op->count], &header, sizeof(header));
+    op->count++;
+
+    if (flash_safe_execute(flash_store_apply, op, FLASH_STORE_TIMEOUT_MS) != PICO_OK)
+        return false;
+    store->active = sector;
+    store->sequence = sequence;
+    store->next_slot = slot;
+    store->compactions++;
+    store->dirty = 0;
+    // Blank while the ring is still being walked for the first time
+    store->spare_erased = flash_store_sector_erased(store, (sector + 1) % FLASH_STORE_SECTORS);
+    return true;
+}
+
+bool flash_store_prepare(flash_store_t *store) {
+    flash_store_op_t *op = &flash_store_op;
+    uint8_t sector = (store->active + 1) % FLASH_STORE_SECTORS;
+
+    if (store->spare_erased)
+        return true;
+    *op = (flash_store_op_t){ .erase = true, .erase_offset = flash_store_slot_offset(store, sector, 0) };
+    if (flash_safe_execute(flash_store_apply, op, FLASH_STORE_TIMEOUT_MS) != PICO_OK)
+        return false;
+    store->spare_erased = true;
+    return true;
+}
+
+bool flash_store_sync(flash_store_t *store) {
+    flash_store_op_t *op = &flash_store_op;
+    uint16_t count = flash_store_dirty_count(store);
+
+    if (!store->dirty)
+        return true;
+    if (store->next_slot + count > FLASH_STORE_SLOTS)
+        return flash_store_compact(store);
+
+    uint16_t slot = store->next_slot;
+    *op = (flash_store_op_t){ 0 };
+    for (uint8_t key = FLASH_STORE_HEADER + 1; key < STORE_KEYS; ++key) {
+        if (!(store->dirty & (1 << key)))
+            continue;
+        flash_store_record_t record = flash_store_record(key, store->values[key], store->lengths[key]);
+        flash_store_op_put(op, flash_store_slot_offset(store, store->active, slot++), &record);
+    }
+    if (flash_safe_execute(flash_store_apply, op, FLASH_STORE_TIMEOUT_MS) != PICO_OK)
+        return false;
+    store->appends += count;
+    store->next_slot = slot;
+    store->dirty = 0;
+    return true;
+}
+
+void flash_store_report(const flash_store_t *store) {
+    printf("store: sector %u of %u, sequence %lu, %u of %u slots used\n", store->active,
+           FLASH_STORE_SECTORS, (unsigned long)store->sequence, store->next_slot, FLASH_STORE_SLOTS);
+    printf("store: %lu appends, %lu compactions since boot, %u bad records skipped\n",
+           (unsigned long)store->appends, (unsigned long)store->compactions, store->skipped);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file flash_store.h
+ * @brief Small key/value store kept as a record log in the last flash sectors.
+ *
+ * Values are appended as fixed-size records, each with its own CRC, so
+ * changing a value costs one page program and never an erase. The log
+ * lives in one sector of a ring of FLASH_STORE_SECTORS. When that sector
+ * is full the next one in the ring is erased, the current value of every
+ * key is copied into it and its header is written last; the ring walks
+ * through every sector in turn, so erases are spread evenly across them.
+ *
+ * Recovery at boot reads the sector headers, takes the valid one with the
+ * highest sequence number and replays its records. A record torn by a
+ * power cut fails its CRC and is skipped, leaving the previous value; a
+ * compaction cut short leaves a sector without a header, which is ignored.
+ *
+ * Changes only reach flash through flash_store_sync(), which runs the
+ * erases and programs through flash_safe_execute(): code runs from flash,
+ * so the other core is parked and interrupts are off meanwhile. Callers
+ * schedule it where that stall does no harm; FLASH_STORE_SYNC_MAX_US is
+ * the longest it can take, a compaction at the worst-case erase and
+ * program times of the flash datasheet. Typical times are about a tenth.
+ *
+ * The erase can be split off: flash_store_prepare() erases the sector the
+ * next compaction will use ahead of time, and a sync then takes at most
+ * FLASH_STORE_APPEND_MAX_US, compaction included. flash_store_sync_us()
+ * and flash_store_prepare_us() tell how long the next of each can take.
+ */
+
+#ifndef FLASH_STORE_H
+#define FLASH_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/flash.h"
+
+#define FLASH_STORE_SECTORS 4                                  ///< Sectors in the ring
+#define FLASH_STORE_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_STORE_SECTORS * FLASH_SECTOR_SIZE)
+#define FLASH_STORE_RECORD_SIZE 16
+#define FLASH_STORE_VALUE_MAX 12                               ///< Bytes of a value
+#define FLASH_STORE_SLOTS (FLASH_SECTOR_SIZE / FLASH_STORE_RECORD_SIZE) ///< Records per sector, header included
+#define FLASH_STORE_ERASE_MAX_US 400000                        ///< Sector erase, worst case of the W25Q16JV
+#define FLASH_STORE_PROGRAM_MAX_US 3000                        ///< Page program, worst case
+#define FLASH_STORE_APPEND_MAX_US (2 * FLASH_STORE_PROGRAM_MAX_US) ///< Appending the changed values
+#define FLASH_STORE_SYNC_MAX_US (FLASH_STORE_ERASE_MAX_US + 2 * FLASH_STORE_PROGRAM_MAX_US) ///< A compaction
+
+/**
+ * @brief Keys of the stored values. 0 is the sector header.
+ */
+typedef enum {
+    STORE_SETTINGS = 1, ///< store_settings_t
+    STORE_SESSIONS,     ///< store_sessions_t
+    STORE_KEYS,
+} store_key_t;
+
+/**
+ * @brief Work and break durations chosen with the buttons.
+ */
+typedef struct {
+    uint8_t work_minutes;
+    uint8_t break_minutes;
+} store_settings_t;
+
+/**
+ * @brief Running totals of the work periods completed.
+ */
+typedef struct {
+    uint32_t completed;    ///< Work periods that ran to the end
+    uint32_t work_minutes; ///< Their total length
+} store_sessions_t;
+
+/**
+ * @brief The store: the position of the log and a copy of every value.
+ */
+typedef struct {
+    uint32_t offset;                                  ///< Flash offset of the first sector
+    uint8_t active;                                   ///< Sector holding the log
+    uint32_t sequence;                                ///< Sequence number of that sector
+    uint16_t next_slot;                               ///< First free record slot in it
+    uint8_t values[STORE_KEYS][FLASH_STORE_VALUE_MAX];
+    uint8_t lengths[STORE_KEYS];                      ///< 0: never stored
+    uint8_t dirty;                                    ///< Keys changed since the last sync, one bit each
+    uint32_t appends;                                 ///< Records appended since boot
+    bool spare_erased;                                ///< The next sector of the ring is blank
+    uint32_t compactions;                             ///< Log restarts since boot
+    uint16_t skipped;                                 ///< Bad records skipped at boot
+} flash_store_t;
+
+/**
+ * @brief Recovers the store from the log starting at a flash offset.
+ *
+ * An empty or unreadable region gives an empty store; the first sync then
+ * starts a new log.
+ *
+ * @param store The store to initialise.
+ * @param offset Sector-aligned flash offset, normally FLASH_STORE_OFFSET.
+ */
+void flash_store_init(flash_store_t *store, uint32_t offset);
+
+/**
+ * @brief Copies a value out.
+ *
+ * @return false, leaving value untouched, if the key was never stored or
+ * was stored with a different length.
+ */
+bool flash_store_get(const flash_store_t *store, store_key_t key, void *value, uint8_t length);
+
+/**
+ * @brief Changes a value in RAM and marks it for the next sync. Setting
+ * the value the key already has changes nothing.
+ */
+void flash_store_set(flash_store_t *store, store_key_t key, const void *value, uint8_t length);
+
+/**
+ * @brief Whether a sync has something to write.
+ */
+bool flash_store_pending(const flash_store_t *store);
+
+/**
+ * @brief The longest the next flash_store_sync() can stall: 0 with nothing
+ * to write, FLASH_STORE_SYNC_MAX_US if it compacts into a sector that
+ * still has to be erased, FLASH_STORE_APPEND_MAX_US otherwise.
+ */
+uint32_t flash_store_sync_us(const flash_store_t *store);
+
+/**
+ * @brief The longest the next flash_store_prepare() can stall: 0 if the
+ * next sector of the ring is already blank, FLASH_STORE_ERASE_MAX_US
+ * otherwise.
+ */
+uint32_t flash_store_prepare_us(const flash_store_t *store);
+
+/**
+ * @brief Writes the changed values to flash, compacting first if the
+ * sector has no room for them. Takes up to FLASH_STORE_SYNC_MAX_US with
+ * interrupts off, compaction included.
+ *
+ * @return false if the flash could not be taken; the values stay pending.
+ */
+bool flash_store_sync(flash_store_t *store);
+
+/**
+ * @brief Erases the next sector of the ring, unless it is already blank,
+ * so that the next compaction only programs. Takes up to
+ * FLASH_STORE_ERASE_MAX_US with interrupts off.
+ *
+ * @return false if the flash could not be taken.
+ */
+bool flash_store_prepare(flash_store_t *store);
+
+/**
+ * @brief Prints where the log is and what was written since boot.
+ */
+void flash_store_report(const flash_store_t *store);
+
+#endif // FLASH_STORE_H
@@ -1,25 +1,31 @@
 #include "hardware_init.h"
 #include "display_status.h"
+#include "tone.h"
 
 ssd1306_t ssd;
+#if POMODORO_STATS_DISPLAY
+ssd1306_t ssd_aux; ///< The statistics panel
+#endif
 
 /**
  * @brief Initializes the hardware components required for the Pomodoro Timer.
  *
  * This function sets up the necessary hardware by initializing the button, display, and LED.
- * It also performs the initial display setup.
  *
  * The following components are initialized:
  * - Button: Prepares the button for user input.
- * - Display: Sets up the display for showing information.
+ * - Display: Sets up the display for showing information. In the multicore
+ *   build core1 owns the display and initializes it itself.
  * - LED: Initializes the LED for visual feedback.
- * - Initial Display: Configures the initial state of the display.
+ * - Buzzer: Sets up the PWM and DMA that play the alerts, silent.
  */
 void hardware_init() {
     init_button();
+#if !POMODORO_MULTICORE
     init_display();
+#endif
     init_led();
-    initial_display();
+    tone_init();
 }
 
 /**
@@ -42,25 +48,45 @@ void init_button() {
     gpio_pull_up(BUTTON_JS);
 }
 
+/**
+ * @brief Sets up one bus and configures the panel on it.
+ *
+ * @param panel The panel's driver state.
+ * @param i2c The controller it is wired to.
+ * @param sda GPIO pin for SDA.
+ * @param scl GPIO pin for SCL.
+ */
+static void init_panel(ssd1306_t *panel, i2c_inst_t *i2c, uint sda, uint scl) {
+    i2c_init(i2c, POMODORO_I2C_HZ);
+    gpio_set_function(sda, GPIO_FUNC_I2C);
+    gpio_set_function(scl, GPIO_FUNC_I2C);
+    gpio_pull_up(sda);
+    gpio_pull_up(scl);
+
+    ssd1306_init(panel, false, 0x3C, i2c);
+    ssd1306_config(panel);
+}
+
 /**
  * @brief Initializes the display hardware.
  *
  * This function sets up the necessary configurations and initializes
- * the display hardware for use in the Pomodoro Timer application.
+ * the display hardware for use in the Pomodoro Timer application. The bus
+ * runs at POMODORO_I2C_HZ; at 1 MHz the internal pull-ups are too weak
+ * and the display module's own pull-ups must be fitted. With
+ * POMODORO_STATS_DISPLAY both panels are cleared at the same time, each
+ * on its own bus.
  */
 void init_display() {
-    i2c_init(I2C_PORT, 400 * 1000);
-    gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
-    gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
-    gpio_pull_up(I2C_SDA);
-    gpio_pull_up(I2C_SCL);
-
-    ssd1306_init(&ssd, WIDTH, HEIGHT, false, 0x3C, I2C_PORT);
-    ssd1306_config(&ssd);
-    ssd1306_send_data(&ssd);
-
-    ssd1306_fill(&ssd, false);
+    init_panel(&ssd, I2C_PORT, I2C_SDA, I2C_SCL);
+#if POMODORO_STATS_DISPLAY
+    init_panel(&ssd_aux, I2C_AUX_PORT, I2C_AUX_SDA, I2C_AUX_SCL);
+    ssd1306_send_data_async(&ssd_aux);
+#endif
     ssd1306_send_data(&ssd);
+#if POMODORO_STATS_DISPLAY
+    ssd1306_wait(&ssd_aux);
+#endif
 }
 
 /**
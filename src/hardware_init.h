@@ -4,7 +4,7 @@
  *
  * This file contains the definitions and function prototypes for initializing
  * the hardware components used in the Pomodoro Timer project. It includes
- * initialization for buttons, LEDs, and the I2C display.
+ * initialization for buttons, LEDs, the buzzer and the I2C display.
  *
  * @author Italo
  * @date 2023
@@ -26,16 +26,35 @@
 #define LED_BLUE 12   ///< GPIO pin for Blue LED
 #define LED_GREEN 11  ///< GPIO pin for Green LED
 
+#define BUZZER 21     ///< GPIO pin for the buzzer, driven by PWM
+
 // I2C defines
 #define I2C_PORT i2c1 ///< I2C port used for communication
 #define I2C_SDA 14    ///< GPIO pin for I2C SDA
 #define I2C_SCL 15    ///< GPIO pin for I2C SCL
 
+#if POMODORO_STATS_DISPLAY
+// Second panel, showing the statistics, on the other controller
+#define I2C_AUX_PORT i2c0 ///< I2C port of the statistics panel
+#define I2C_AUX_SDA 0     ///< GPIO pin for its SDA
+#define I2C_AUX_SCL 1     ///< GPIO pin for its SCL
+#if POMODORO_MULTICORE
+#error "core1 drives a single panel; POMODORO_STATS_DISPLAY needs the single-core build"
+#endif
+#endif
+
+#ifndef POMODORO_I2C_HZ
+#define POMODORO_I2C_HZ 400000 ///< I2C clock, set by CMake
+#endif
+#if POMODORO_I2C_HZ > 1000000
+#error "The RP2040 I2C runs at 1 MHz (Fast-mode Plus) at most"
+#endif
+
 /**
  * @brief Initializes the hardware components.
  *
  * This function initializes the hardware components including buttons, LEDs,
- * and the I2C display.
+ * the buzzer and the I2C display.
  */
 void hardware_init(void);
 
@@ -51,7 +70,7 @@ void init_button(void);
  * @brief Initializes the display.
  *
  * This function sets up the I2C communication and initializes the SSD1306
- * display.
+ * display, and with POMODORO_STATS_DISPLAY the statistics panel.
  */
 void init_display(void);
 
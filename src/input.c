@@ -0,0 +1,128 @@
+#include "input.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "probe.h"
+
+static void input_settle_expired(timer_wheel_timer_t *timer, void *data);
+static void input_hold_expired(timer_wheel_timer_t *timer, void *data);
+
+void input_init(input_t *input, timer_wheel_t *timers, input_handler_t handler, void *data) {
+    *input = (input_t){ .timers = timers, .handler = handler, .data = data };
+}
+
+int input_add_button(input_t *input, uint gpio) {
+    int index = input->count++;
+    input_button_t *button = &input->buttons[index];
+
+    *button = (input_button_t){ .input = input, .gpio = (uint8_t)gpio };
+    timer_wheel_timer_init(&button->settle_timer, "settle", input_settle_expired, button);
+    timer_wheel_timer_init(&button->hold_timer, "hold", input_hold_expired, button);
+    return index;
+}
+
+static int input_index(const input_t *input, uint gpio) {
+    for (int i = 0; i < input->count; ++i) {
+        if (input->buttons[i].gpio == gpio)
+            return i;
+    }
+    return -1;
+}
+
+bool input_is_held(const input_t *input, uint gpio) {
+    int index = input_index(input, gpio);
+    return index >= 0 && input->buttons[index].pressed;
+}
+
+bool input_irq(input_t *input, uint gpio) {
+    int index = input_index(input, gpio);
+    if (index < 0)
+        return false;
+
+    uint8_t bit = 1 << index;
+    if (input->edges & bit) {
+        input->bounces++;
+        return false;
+    }
+    input->edges |= bit;
+    return true;
+}
+
+void input_edge(input_t *input, uint gpio, uint32_t time_us) {
+    int index = input_index(input, gpio);
+    if (index < 0)
+        return;
+
+    input_button_t *button = &input->buttons[index];
+    // Edges after this point post again, so the pin is quiet from now on
+    // unless told otherwise.
+    uint32_t status = save_and_disable_interrupts();
+    input->edges &= ~(1 << index);
+    if (button->settle_timer.pending)
+        input->bounces++;
+    restore_interrupts(status);
+
+    if (!button->settle_timer.pending)
+        button->first_edge_us = time_us;
+    timer_wheel_add(input->timers, &button->settle_timer, time_us_64() + INPUT_SETTLE_US);
+}
+
+static void input_emit(input_t *input, input_event_type_t type, const input_button_t *button) {
+    input_event_t event = {
+        .type = (uint8_t)type,
+        .gpio = button->gpio,
+        .held = input->held,
+        .time_us = time_us_64(),
+    };
+    input->handler(&event, input->data);
+}
+
+/**
+ * @brief The pin has been quiet for INPUT_SETTLE_US: takes its level.
+ *
+ * A chatter that ends on the level the button already had changes
+ * nothing.
+ */
+static void input_settle_expired(timer_wheel_timer_t *timer, void *data) {
+    input_button_t *button = data;
+    input_t *input = button->input;
+    uint8_t bit = 1 << (button - input->buttons);
+    bool pressed = !gpio_get(button->gpio);
+
+    if (pressed == button->pressed)
+        return;
+    button->pressed = pressed;
+    probe_record(PROBE_INPUT, time_us_32() - button->first_edge_us);
+
+    if (pressed) {
+        bool chord = input->held != 0;
+        input->held |= bit;
+        if (chord) {
+            // Long presses and repeats make no sense for a chord
+            for (int i = 0; i < input->count; ++i)
+                timer_wheel_cancel(input->timers, &input->buttons[i].hold_timer);
+            input_emit(input, INPUT_CHORD, button);
+        } else {
+            button->repeating = false;
+            timer_wheel_add(input->timers, &button->hold_timer, timer->deadline_us + INPUT_LONG_PRESS_US);
+            input_emit(input, INPUT_PRESS, button);
+        }
+    } else {
+        input->held &= ~bit;
+        timer_wheel_cancel(input->timers, &button->hold_timer);
+        input_emit(input, INPUT_RELEASE, button);
+    }
+}
+
+/**
+ * @brief Reports a long press the first time, repeats afterwards. Each
+ * repeat is armed from the previous deadline, so the rate stays exact.
+ */
+static void input_hold_expired(timer_wheel_timer_t *timer, void *data) {
+    input_button_t *button = data;
+    input_t *input = button->input;
+
+    timer_wheel_add(input->timers, timer, timer->deadline_us + INPUT_REPEAT_US);
+    input_emit(input, button->repeating ? INPUT_REPEAT : INPUT_LONG_PRESS, button);
+    button->repeating = true;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file input.h
+ * @brief Debounced buttons with long-press, repeat and chord detection.
+ *
+ * Every button has its own debouncer: each edge restarts the button's
+ * settle timer, and once the pin has been quiet for INPUT_SETTLE_US its
+ * level is taken as the new state. A clean press is reported
+ * INPUT_SETTLE_US after its first edge, a bouncing one as soon as the
+ * contacts stop chattering, and presses of different buttons never mask
+ * each other.
+ *
+ * The GPIO IRQ only notes the edge with input_irq(); input_edge() and the
+ * timers run in the main loop, which receives the events through the
+ * handler given to input_init().
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/types.h"
+#include "timer_wheel.h"
+
+#define INPUT_MAX_BUTTONS 4
+#define INPUT_SETTLE_US 2000         ///< Quiet time before a level is trusted
+#define INPUT_LONG_PRESS_US 600000   ///< Held this long: INPUT_LONG_PRESS
+#define INPUT_REPEAT_US 150000       ///< Then INPUT_REPEAT at this period
+
+/**
+ * @brief Kinds of input events.
+ */
+typedef enum {
+    INPUT_PRESS,      ///< A button went down on its own
+    INPUT_RELEASE,    ///< A button went up
+    INPUT_LONG_PRESS, ///< A button has been held for INPUT_LONG_PRESS_US
+    INPUT_REPEAT,     ///< Still held, every INPUT_REPEAT_US after the long press
+    INPUT_CHORD,      ///< A button went down while others were held; replaces its INPUT_PRESS
+} input_event_type_t;
+
+/**
+ * @brief One input event.
+ */
+typedef struct {
+    uint8_t type;     ///< One of input_event_type_t
+    uint8_t gpio;     ///< Button the event is about
+    uint8_t held;     ///< Buttons held, one bit per input_add_button() index
+    uint64_t time_us; ///< When the state was accepted or the timer fired
+} input_event_t;
+
+typedef void (*input_handler_t)(const input_event_t *event, void *data);
+
+typedef struct input input_t;
+
+/**
+ * @brief State of one button.
+ */
+typedef struct {
+    input_t *input;
+    uint8_t gpio;
+    bool pressed;                     ///< Debounced state
+    bool repeating;                   ///< The long press was reported
+    uint32_t first_edge_us;           ///< First edge since the state was accepted
+    timer_wheel_timer_t settle_timer;
+    timer_wheel_timer_t hold_timer;   ///< Long press, then repeats
+} input_button_t;
+
+/**
+ * @brief The buttons and their shared state.
+ */
+struct input {
+    timer_wheel_t *timers;
+    input_handler_t handler;
+    void *data;
+    input_button_t buttons[INPUT_MAX_BUTTONS];
+    uint8_t count;
+    uint8_t held;                     ///< Debounced pressed buttons, one bit each
+    volatile uint8_t edges;           ///< Buttons with an edge not yet seen by input_edge()
+    volatile uint32_t bounces;        ///< Edges beyond the first of each change
+};
+
+/**
+ * @brief Prepares the input subsystem.
+ *
+ * @param input The state to initialise.
+ * @param timers Wheel for the settle and hold timers.
+ * @param handler Receives every event, from the main loop.
+ * @param data Passed to handler.
+ */
+void input_init(input_t *input, timer_wheel_t *timers, input_handler_t handler, void *data);
+
+/**
+ * @brief Adds an active-low button. The pin must already be an input with
+ * a pull-up; the caller enables its IRQ on both edges.
+ *
+ * @return The button's bit index in input_event_t::held.
+ */
+int input_add_button(input_t *input, uint gpio);
+
+/**
+ * @brief Debounced state of a button.
+ */
+bool input_is_held(const input_t *input, uint gpio);
+
+/**
+ * @brief Notes an edge, from the GPIO IRQ.
+ *
+ * @return false if an edge of that button is already waiting for
+ * input_edge(), so there is nothing to post.
+ */
+bool input_irq(input_t *input, uint gpio);
+
+/**
+ * @brief Restarts the button's settle timer, from the main loop.
+ *
+ * @param input The buttons.
+ * @param gpio The button.
+ * @param time_us time_us_32() of the edge, for the latency probe.
+ */
+void input_edge(input_t *input, uint gpio, uint32_t time_us);
+
+#endif // INPUT_H
@@ -0,0 +1,122 @@
+#include "link.h"
+#include "pico/stdio.h"
+#include "hardware/timer.h"
+
+static void link_status_expired(timer_wheel_timer_t *timer, void *data);
+
+void link_init(link_t *link, timer_wheel_t *timers, link_command_fn_t command, link_status_fn_t status,
+               void *data) {
+    *link = (link_t){ .timers = timers, .command = command, .status = status, .data = data };
+    timer_wheel_timer_init(&link->status_timer, "link", link_status_expired, link);
+}
+
+void link_send(link_t *link, const link_message_t *message) {
+    size_t length = link_encode(message, link->tx);
+    for (size_t i = 0; i < length; ++i)
+        putchar_raw(link->tx[i]);
+    stdio_flush();
+    link->tx_frames++;
+}
+
+static void link_send_status(link_t *link, uint8_t seq) {
+    link_status_t status = { 0 };
+    link_message_t message = { .type = LINK_STATUS, .seq = seq, .length = LINK_STATUS_SIZE };
+
+    link->status(&status, link->data);
+    status.rx_frames = link->rx_frames;
+    status.rx_errors = link->rx_errors;
+    status.tx_frames = link->tx_frames;
+    link_status_pack(&status, message.payload);
+    link_send(link, &message);
+}
+
+/**
+ * @brief Streams a status message and re-arms from its own deadline, so
+ * the rate stays exact.
+ */
+static void link_status_expired(timer_wheel_timer_t *timer, void *data) {
+    link_t *link = data;
+    timer_wheel_add(link->timers, timer, timer->deadline_us + link->period_us);
+    link_send_status(link, 0);
+}
+
+static link_result_t link_set_rate(link_t *link, const link_message_t *command) {
+    if (command->length != 2)
+        return LINK_BAD_LENGTH;
+    uint16_t period_ms = (uint16_t)(command->payload[0] | command->payload[1] << 8);
+    if (period_ms != 0 && period_ms < LINK_RATE_MIN_MS)
+        return LINK_BAD_VALUE;
+
+    link->period_us = period_ms * 1000u;
+    if (period_ms)
+        timer_wheel_add(link->timers, &link->status_timer, time_us_64() + link->period_us);
+    else
+        timer_wheel_cancel(link->timers, &link->status_timer);
+    return LINK_OK;
+}
+
+static void link_dispatch(link_t *link, const link_message_t *command) {
+    link_message_t reply;
+    link_result_t result;
+
+    switch (command->type) {
+    case LINK_GET_STATUS:
+        link_send_status(link, command->seq);
+        return;
+    case LINK_PING:
+        link_message(&reply, LINK_PONG, command->seq, command->payload, command->length);
+        link_send(link, &reply);
+        return;
+    case LINK_SET_RATE:
+        result = link_set_rate(link, command);
+        break;
+    case LINK_START:
+    case LINK_PAUSE:
+    case LINK_RESET:
+    case LINK_SET_DURATIONS:
+    case LINK_SET_MIRROR:
+    case LINK_SET_TRACE:
+        result = link->command(command, link->data);
+        break;
+    default:
+        result = LINK_UNKNOWN;
+        break;
+    }
+    link_message(&reply, LINK_ACK, command->seq, (uint8_t[]){ command->type, (uint8_t)result }, 2);
+    link_send(link, &reply);
+}
+
+/**
+ * @brief Frames are delimited on both sides: a zero outside a frame opens
+ * one, the next zero closes it. Frames that are too long or fail to decode
+ * are dropped and counted.
+ */
+bool link_rx(link_t *link, uint8_t byte) {
+    if (byte != 0x00) {
+        if (!link->in_frame)
+            return false;
+        if (link->rx_length < sizeof(link->rx))
+            link->rx[link->rx_length++] = byte;
+        else
+            link->overflow = true;
+        return true;
+    }
+
+    if (!link->in_frame || link->rx_length == 0) {
+        // Opening delimiter, or two in a row: start over
+        link->in_frame = true;
+        link->rx_length = 0;
+        link->overflow = false;
+        return true;
+    }
+
+    link_message_t command;
+    link->in_frame = false;
+    if (link->overflow || !link_decode(link->rx, link->rx_length, &command)) {
+        link->rx_errors++;
+        return true;
+    }
+    link->rx_frames++;
+    link_dispatch(link, &command);
+    return true;
+}
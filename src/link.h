@@ -0,0 +1,73 @@
+/**
+ * @file link.h
+ * @brief Board side of the binary USB protocol (see link_protocol.h).
+ *
+ * The console hands every received byte to link_rx(), which keeps the
+ * ones between delimiters and decodes the frame at the closing one. The
+ * protocol commands (rate, status, ping) are answered here; the others go
+ * to the application's handler, whose result is sent back in a LINK_ACK.
+ * Status messages are streamed from a timer on the wheel at the rate the
+ * host asked for, none until it does.
+ *
+ * Frames are built in the link's own buffers: nothing is allocated per
+ * message.
+ */
+
+#ifndef LINK_H
+#define LINK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "link_protocol.h"
+#include "timer_wheel.h"
+
+#define LINK_RATE_MIN_MS 1 ///< Fastest status stream
+
+typedef link_result_t (*link_command_fn_t)(const link_message_t *command, void *data);
+typedef void (*link_status_fn_t)(link_status_t *status, void *data);
+
+/**
+ * @brief The link state and its counters.
+ */
+typedef struct {
+    timer_wheel_t *timers;
+    timer_wheel_timer_t status_timer;
+    uint32_t period_us;                ///< Between status messages, 0 for none
+    link_command_fn_t command;
+    link_status_fn_t status;
+    void *data;
+    bool in_frame;                     ///< Between an opening and a closing delimiter
+    bool overflow;                     ///< The frame in progress is too long
+    uint8_t rx_length;
+    uint8_t rx[LINK_ENCODED_MAX];
+    uint8_t tx[LINK_WIRE_MAX];
+    uint32_t rx_frames;
+    uint32_t rx_errors;
+    uint32_t tx_frames;
+} link_t;
+
+/**
+ * @brief Prepares the link.
+ *
+ * @param link The link to initialise.
+ * @param timers Wheel for the status stream.
+ * @param command Runs start, pause, reset, set-durations, mirror and trace commands.
+ * @param status Fills in the state for status messages.
+ * @param data Passed to both.
+ */
+void link_init(link_t *link, timer_wheel_t *timers, link_command_fn_t command, link_status_fn_t status,
+               void *data);
+
+/**
+ * @brief Takes one received byte. Main loop only.
+ *
+ * @return false if the byte is outside any frame, so it is console text.
+ */
+bool link_rx(link_t *link, uint8_t byte);
+
+/**
+ * @brief Sends a message over stdio.
+ */
+void link_send(link_t *link, const link_message_t *message);
+
+#endif // LINK_H
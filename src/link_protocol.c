@@ -0,0 +1,126 @@
+#include <string.h>
+#include "link_protocol.h"
+#include "crc16.h"
+
+_Static_assert(LINK_FRAME_MAX < 254, "one COBS block per frame");
+
+size_t link_encode(const link_message_t *message, uint8_t *out) {
+    uint8_t frame[LINK_FRAME_MAX];
+    size_t length = 0;
+
+    frame[length++] = message->type;
+    frame[length++] = message->seq;
+    memcpy(&frame[length], message->payload, message->length);
+    length += message->length;
+    uint16_t crc = crc16(frame, length);
+    frame[length++] = (uint8_t)crc;
+    frame[length++] = (uint8_t)(crc >> 8);
+
+    // COBS: each zero becomes the distance to the next one
+    size_t n = 0, code_at = 1;
+    out[n++] = 0x00;
+    out[n++] = 1;
+    for (size_t i = 0; i < length; ++i) {
+        if (frame[i] == 0) {
+            code_at = n;
+            out[n++] = 1;
+        } else {
+            out[n++] = frame[i];
+            out[code_at]++;
+        }
+    }
+    out[n++] = 0x00;
+    return n;
+}
+
+bool link_decode(const uint8_t *encoded, size_t length, link_message_t *message) {
+    uint8_t frame[LINK_FRAME_MAX];
+    size_t n = 0;
+
+    if (length < 5 || length > LINK_ENCODED_MAX)
+        return false;
+    for (size_t i = 0; i < length;) {
+        uint8_t code = encoded[i++];
+        if (code == 0 || i + code - 1 > length)
+            return false;
+        for (uint8_t j = 1; j < code; ++j)
+            frame[n++] = encoded[i++];
+        if (i < length)
+            frame[n++] = 0;
+    }
+
+    if (n < 4)
+        return false;
+    uint16_t crc = (uint16_t)(frame[n - 2] | frame[n - 1] << 8);
+    if (crc != crc16(frame, n - 2))
+        return false;
+    message->type = frame[0];
+    message->seq = frame[1];
+    message->length = (uint8_t)(n - 4);
+    memcpy(message->payload, &frame[2], message->length);
+    return true;
+}
+
+void link_message(link_message_t *message, uint8_t type, uint8_t seq, const void *payload, uint8_t length) {
+    message->type = type;
+    message->seq = seq;
+    message->length = length;
+    if (length)
+        memcpy(message->payload, payload, length);
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    return put_u16(put_u16(p, (uint16_t)v), (uint16_t)(v >> 16));
+}
+
+static const uint8_t *get_u16(const uint8_t *p, uint16_t *v) {
+    *v = (uint16_t)(p[0] | p[1] << 8);
+    return p + 2;
+}
+
+static const uint8_t *get_u32(const uint8_t *p, uint32_t *v) {
+    uint16_t low, high;
+    p = get_u16(get_u16(p, &low), &high);
+    *v = low | (uint32_t)high << 16;
+    return p;
+}
+
+void link_status_pack(const link_status_t *status, uint8_t *payload) {
+    uint8_t *p = put_u32(payload, status->uptime_ms);
+    *p++ = status->flags;
+    *p++ = status->minutes;
+    *p++ = status->seconds;
+    *p++ = status->work_minutes;
+    *p++ = status->break_minutes;
+    *p++ = status->progress;
+    p = put_u16(p, status->today_completed);
+    p = put_u16(p, status->week_completed);
+    p = put_u32(p, status->wakeups);
+    p = put_u16(p, status->active_permille);
+    p = put_u32(p, status->rx_frames);
+    p = put_u32(p, status->rx_errors);
+    put_u32(p, status->tx_frames);
+}
+
+void link_status_unpack(const uint8_t *payload, link_status_t *status) {
+    const uint8_t *p = get_u32(payload, &status->uptime_ms);
+    status->flags = *p++;
+    status->minutes = *p++;
+    status->seconds = *p++;
+    status->work_minutes = *p++;
+    status->break_minutes = *p++;
+    status->progress = *p++;
+    p = get_u16(p, &status->today_completed);
+    p = get_u16(p, &status->week_completed);
+    p = get_u32(p, &status->wakeups);
+    p = get_u16(p, &status->active_permille);
+    p = get_u32(p, &status->rx_frames);
+    p = get_u32(p, &status->rx_errors);
+    get_u32(p, &status->tx_frames);
+}
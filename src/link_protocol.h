@@ -0,0 +1,139 @@
+/**
+ * @file link_protocol.h
+ * @brief Binary control and telemetry protocol over USB CDC: messages and framing.
+ *
+ * A message is a type, a sequence number and up to LINK_PAYLOAD_MAX bytes
+ * of payload, followed by a CRC-16 of all three. It is COBS-encoded, so it
+ * contains no zero byte, and sent between two 0x00 delimiters. Anything
+ * outside a pair of delimiters is text for the line console, so both
+ * share the one serial stream.
+ *
+ * The host sends commands with a sequence number from 1 to 255; the board
+ * answers each with a reply carrying the same number. Status messages the
+ * board streams on its own have sequence number 0.
+ *
+ * A mirrored frame (LINK_FRAME) is split in chunks numbered from 0. The
+ * host applies a frame only once it has all its chunks, and a frame that
+ * is not a key frame only on top of the one numbered just before it;
+ * after a loss it asks for a key frame with LINK_SET_MIRROR again.
+ *
+ * A trace (LINK_TRACE, see trace_record.h) is sent in order, each message
+ * numbering its first record, so the host can tell a trace that starts at
+ * boot and has no gap.
+ *
+ * Multi-byte fields are little-endian. This file is shared by the
+ * firmware and the host-side client; it needs no SDK.
+ */
+
+#ifndef LINK_PROTOCOL_H
+#define LINK_PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LINK_PAYLOAD_MAX 48
+#define LINK_FRAME_MAX (LINK_PAYLOAD_MAX + 4)       ///< Type, sequence, payload, CRC
+#define LINK_ENCODED_MAX (LINK_FRAME_MAX + 1)       ///< COBS adds one byte per 254
+#define LINK_WIRE_MAX (LINK_ENCODED_MAX + 2)        ///< With both delimiters
+#define LINK_STATUS_SIZE 32
+
+/**
+ * @brief Message types. Commands go to the board, the rest come from it.
+ */
+typedef enum {
+    LINK_START = 0x01,     ///< Start or resume the countdown
+    LINK_PAUSE,            ///< Pause it
+    LINK_RESET,            ///< Stop it and go back to the start of a work period
+    LINK_SET_DURATIONS,    ///< u8 work minutes (1-60), u8 break minutes (1-30); timer stopped
+    LINK_SET_RATE,         ///< u16 milliseconds between status messages, 0 to stop them
+    LINK_GET_STATUS,       ///< Answered with LINK_STATUS
+    LINK_PING,             ///< Any payload, echoed in LINK_PONG
+    LINK_SET_MIRROR,       ///< u8 1 to stream the framebuffer in LINK_FRAME, from a key frame; 0 to stop
+    LINK_SET_TRACE,        ///< u8 1 to stream the input trace in LINK_TRACE, from its oldest record; 0 to stop
+
+    LINK_ACK = 0x81,       ///< u8 command type, u8 link_result_t
+    LINK_STATUS,           ///< link_status_t, LINK_STATUS_SIZE bytes
+    LINK_PONG,             ///< The payload of the LINK_PING
+    LINK_FRAME,            ///< u8 frame number, u8 chunk index, u8 LINK_FRAME_* flags, fb_delta.h data
+    LINK_TRACE,            ///< u32 index of the first record, u8 LINK_TRACE_* flags, packed records
+} link_type_t;
+
+/**
+ * @brief Outcome of a command, in LINK_ACK.
+ */
+typedef enum {
+    LINK_OK,
+    LINK_REJECTED,   ///< Not possible in the current state
+    LINK_BAD_LENGTH, ///< Payload of the wrong size
+    LINK_BAD_VALUE,  ///< Argument out of range
+    LINK_UNKNOWN,    ///< Unknown type
+} link_result_t;
+
+/**
+ * @brief One message, decoded.
+ */
+typedef struct {
+    uint8_t type;   ///< One of link_type_t
+    uint8_t seq;
+    uint8_t length; ///< Bytes of payload
+    uint8_t payload[LINK_PAYLOAD_MAX];
+} link_message_t;
+
+#define LINK_STATUS_RUNNING 0x01 ///< Counting down
+#define LINK_STATUS_ON 0x02      ///< Started, possibly paused
+#define LINK_STATUS_BREAK 0x04   ///< In a break
+
+#define LINK_FRAME_HEADER 3                                   ///< Bytes before the data of a chunk
+#define LINK_FRAME_CHUNK (LINK_PAYLOAD_MAX - LINK_FRAME_HEADER) ///< Data bytes per full chunk
+#define LINK_FRAME_KEY 0x01  ///< Changes from a blank screen, not from the previous frame
+#define LINK_FRAME_LAST 0x02 ///< Last chunk of the frame
+
+#define LINK_TRACE_HEADER 5    ///< Bytes before the records of a LINK_TRACE
+#define LINK_TRACE_RECORDS 3   ///< Records per message, at most
+#define LINK_TRACE_LOST 0x01   ///< The board ran out of room after these records; the trace ends here
+
+/**
+ * @brief State and telemetry, the payload of LINK_STATUS.
+ */
+typedef struct {
+    uint32_t uptime_ms;
+    uint8_t flags;            ///< LINK_STATUS_* bits
+    uint8_t minutes;          ///< Time left, as shown
+    uint8_t seconds;
+    uint8_t work_minutes;     ///< Durations set
+    uint8_t break_minutes;
+    uint8_t progress;         ///< Part of the period elapsed, out of 255
+    uint16_t today_completed; ///< Work periods completed today
+    uint16_t week_completed;  ///< And in the last 7 days
+    uint32_t wakeups;         ///< Main loop wakeups since boot
+    uint16_t active_permille; ///< Share of time awake since boot
+    uint32_t rx_frames;       ///< Frames received by the board
+    uint32_t rx_errors;       ///< Frames dropped: bad CRC, encoding or length
+    uint32_t tx_frames;       ///< Frames sent by the board
+} link_status_t;
+
+/**
+ * @brief Frames a message for the wire: delimiter, COBS, delimiter.
+ *
+ * @param out At least LINK_WIRE_MAX bytes.
+ * @return Bytes written.
+ */
+size_t link_encode(const link_message_t *message, uint8_t *out);
+
+/**
+ * @brief Decodes the bytes between two delimiters.
+ *
+ * @return false if the encoding, the length or the CRC is wrong.
+ */
+bool link_decode(const uint8_t *encoded, size_t length, link_message_t *message);
+
+/**
+ * @brief Builds a message from a type and payload.
+ */
+void link_message(link_message_t *message, uint8_t type, uint8_t seq, const void *payload, uint8_t length);
+
+void link_status_pack(const link_status_t *status, uint8_t *payload);
+void link_status_unpack(const uint8_t *payload, link_status_t *status);
+
+#endif // LINK_PROTOCOL_H
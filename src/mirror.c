@@ -0,0 +1,46 @@
+#include <string.h>
+#include "mirror.h"
+
+void mirror_init(mirror_t *mirror, link_t *link, const uint8_t *frame) {
+    memset(mirror, 0, sizeof(*mirror));
+    mirror->link = link;
+    mirror->frame = frame;
+}
+
+void mirror_enable(mirror_t *mirror, bool enabled) {
+    mirror->enabled = enabled;
+    mirror->key = enabled;
+}
+
+void mirror_update(mirror_t *mirror, bool flushed) {
+    if (!mirror->enabled || (!flushed && !mirror->key))
+        return;
+    if (mirror->key)
+        memset(mirror->reference, 0, sizeof(mirror->reference));
+
+    size_t length = fb_delta_encode(mirror->reference, mirror->frame, MIRROR_WIDTH, MIRROR_PAGES, mirror->encoded);
+    if (length == 0 && !mirror->key)
+        return;
+
+    uint8_t flags = mirror->key ? LINK_FRAME_KEY : 0;
+    link_message_t message = { .type = LINK_FRAME, .seq = 0 };
+    mirror->number++;
+    mirror->frames++;
+    mirror->key_frames += mirror->key;
+    mirror->bytes += length;
+    mirror->key = false;
+
+    // A blank key frame still goes out, as a single empty chunk
+    size_t offset = 0;
+    uint8_t index = 0;
+    do {
+        size_t chunk = length - offset < LINK_FRAME_CHUNK ? length - offset : LINK_FRAME_CHUNK;
+        message.payload[0] = mirror->number;
+        message.payload[1] = index++;
+        message.payload[2] = flags | (offset + chunk == length ? LINK_FRAME_LAST : 0);
+        memcpy(&message.payload[LINK_FRAME_HEADER], &mirror->encoded[offset], chunk);
+        message.length = (uint8_t)(LINK_FRAME_HEADER + chunk);
+        link_send(mirror->link, &message);
+        offset += chunk;
+    } while (offset < length);
+}
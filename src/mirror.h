@@ -0,0 +1,63 @@
+/**
+ * @file mirror.h
+ * @brief Streams the framebuffer to the host over the USB link.
+ *
+ * After each flush the main loop calls mirror_update(),
+ * which encodes its changes with fb_delta.h and sends them in LINK_FRAME
+ * chunks. The reference copy and the encoded frame are static: the
+ * mirror costs about 2 KB of RAM whether it is on or not.
+ */
+
+#ifndef MIRROR_H
+#define MIRROR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fb_delta.h"
+#include "link.h"
+
+#define MIRROR_WIDTH 128
+#define MIRROR_PAGES 8
+#define MIRROR_SIZE (MIRROR_WIDTH * MIRROR_PAGES)
+
+/**
+ * @brief The mirror state and its counters.
+ */
+typedef struct {
+    link_t *link;
+    const uint8_t *frame;                ///< The framebuffer, in the driver's layout
+    bool enabled;
+    bool key;                            ///< Next frame is a key frame
+    uint8_t number;                      ///< Of the last frame sent
+    uint8_t reference[MIRROR_SIZE];      ///< What the host has
+    uint8_t encoded[FB_DELTA_MAX(MIRROR_WIDTH, MIRROR_PAGES)];
+    uint32_t frames;                     ///< Frames sent
+    uint32_t key_frames;
+    uint32_t bytes;                      ///< Encoded bytes sent, before framing
+} mirror_t;
+
+/**
+ * @brief Prepares the mirror, off.
+ *
+ * @param mirror The mirror to initialise.
+ * @param link Link to send the frames over.
+ * @param frame MIRROR_SIZE bytes of framebuffer, read by mirror_update().
+ */
+void mirror_init(mirror_t *mirror, link_t *link, const uint8_t *frame);
+
+/**
+ * @brief Starts or stops the stream. Starting, even when already on,
+ * makes the next mirror_update() send a key frame, flushed or not.
+ */
+void mirror_enable(mirror_t *mirror, bool enabled);
+
+/**
+ * @brief Sends the changes since the last frame, if any. Main loop only,
+ * after the flush, so a key frame asked for by a command goes out after
+ * the command's acknowledgement.
+ *
+ * @param flushed The framebuffer changed and was sent to the panel.
+ */
+void mirror_update(mirror_t *mirror, bool flushed);
+
+#endif // MIRROR_H
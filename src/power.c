@@ -0,0 +1,33 @@
+#include <stdio.h>
+#include "power.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+static power_stats_t stats;
+
+/**
+ * @brief Waits for an event with __wfe() and accounts for the time asleep.
+ *
+ * __wfe() rather than __wfi(): an event posted between the main loop's
+ * last check of the queue and this call sets the event register, so the
+ * wait returns at once instead of sleeping through it.
+ */
+void power_sleep(void) {
+    uint64_t start = time_us_64();
+    __wfe();
+    stats.asleep_us += time_us_64() - start;
+    stats.wakeups++;
+}
+
+const power_stats_t *power_stats(void) {
+    return &stats;
+}
+
+void power_report(void) {
+    uint64_t now = time_us_64();
+    if (now == 0)
+        return;
+    printf("active %.3f%% of %.1f s, %lu wakeups (%.2f/s)\n",
+           100.0 * (double)(now - stats.asleep_us) / now, now / 1e6,
+           (unsigned long)stats.wakeups, stats.wakeups * 1e6 / now);
+}
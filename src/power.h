@@ -0,0 +1,39 @@
+/**
+ * @file power.h
+ * @brief Sleep accounting for the main loop.
+ *
+ * The main loop sleeps through power_sleep() so the share of time the core
+ * spends awake can be measured. Interrupt handlers that run while the core
+ * is asleep are counted as sleep: they are short and the core would wake
+ * for them anyway.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Sleep counters since boot.
+ */
+typedef struct {
+    uint64_t asleep_us; ///< Time spent in __wfe()
+    uint32_t wakeups;   ///< Number of times the main loop woke up
+} power_stats_t;
+
+/**
+ * @brief Sleeps until the next event (see event_queue_post()).
+ */
+void power_sleep(void);
+
+/**
+ * @brief Returns the sleep counters.
+ */
+const power_stats_t *power_stats(void);
+
+/**
+ * @brief Prints the active-time percentage and wakeup rate over stdio.
+ */
+void power_report(void);
+
+#endif // POWER_H
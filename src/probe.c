@@ -0,0 +1,40 @@
+#include "probe.h"
+
+#if POMODORO_PROBES
+
+#include <stdio.h>
+#include <string.h>
+
+probe_histogram_t probe_histograms[PROBE_COUNT];
+
+static const char *const probe_names[PROBE_COUNT] = {
+    [PROBE_GPIO_IRQ] = "gpio_irq",
+    [PROBE_TICK_CALLBACK] = "tick_callback",
+    [PROBE_TICK_LATENESS] = "tick_lateness",
+    [PROBE_FLUSH] = "flush",
+    [PROBE_INPUT] = "input",
+    [PROBE_FRAME] = "frame",
+};
+
+/**
+ * @brief Prints one line per probe, followed by its non-empty buckets as
+ * "lower bound in us: count".
+ */
+void probe_dump(void) {
+    printf("%-14s %10s %10s\n", "probe", "count", "max us");
+    for (int id = 0; id < PROBE_COUNT; ++id) {
+        const probe_histogram_t *h = &probe_histograms[id];
+        printf("%-14s %10lu %10lu\n", probe_names[id], (unsigned long)h->count, (unsigned long)h->max_us);
+        for (int b = 0; b < PROBE_BUCKETS; ++b) {
+            if (h->buckets[b])
+                printf("  %8s%lu: %lu\n", b == PROBE_BUCKETS - 1 ? ">=" : "",
+                       b ? 1ul << (b - 1) : 0ul, (unsigned long)h->buckets[b]);
+        }
+    }
+}
+
+void probe_reset(void) {
+    memset(probe_histograms, 0, sizeof(probe_histograms));
+}
+
+#endif // POMODORO_PROBES
@@ -0,0 +1,96 @@
+/**
+ * @file probe.h
+ * @brief Latency histograms for the hot paths.
+ *
+ * Each probe keeps a fixed log2 histogram in microseconds: bucket 0 counts
+ * samples under 1 us and bucket b > 0 counts [2^(b-1), 2^b) us, the last
+ * bucket also taking everything longer. Recording a sample is a timer read,
+ * a count-leading-zeros and two increments.
+ *
+ * Probes are only built with POMODORO_PROBES defined to 1; otherwise the
+ * macros expand to nothing and no storage is reserved.
+ */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdint.h>
+
+#define PROBE_BUCKETS 20 ///< Up to 2^18 us, about a quarter of a second
+
+/**
+ * @brief The probed paths.
+ */
+typedef enum {
+    PROBE_GPIO_IRQ,      ///< gpio_irq_handler, entry to exit
+    PROBE_TICK_CALLBACK, ///< timer_callback, entry to exit
+    PROBE_TICK_LATENESS, ///< timer_callback start versus its deadline
+    PROBE_FLUSH,         ///< Display transfer, DMA start to completion IRQ
+    PROBE_INPUT,         ///< First edge of a button to its debounced change
+    PROBE_FRAME,         ///< Drawing of an animation frame
+    PROBE_COUNT
+} probe_id_t;
+
+#if POMODORO_PROBES
+
+#include "hardware/timer.h"
+
+/**
+ * @brief Histogram of one probe.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t buckets[PROBE_BUCKETS];
+} probe_histogram_t;
+
+extern probe_histogram_t probe_histograms[PROBE_COUNT];
+
+/**
+ * @brief Adds one sample. Safe from interrupt context as long as a probe
+ * is only recorded from one priority level.
+ */
+static inline void probe_record(probe_id_t id, uint32_t us) {
+    probe_histogram_t *h = &probe_histograms[id];
+    uint32_t bucket = us ? 32 - __builtin_clz(us) : 0;
+    if (bucket >= PROBE_BUCKETS)
+        bucket = PROBE_BUCKETS - 1;
+    h->buckets[bucket]++;
+    h->count++;
+    if (us > h->max_us)
+        h->max_us = us;
+}
+
+#define PROBE_BEGIN(start) uint32_t start = time_us_32()
+#define PROBE_END(id, start) probe_record((id), time_us_32() - (start))
+// How late start, taken by PROBE_BEGIN(), was for a deadline
+#define PROBE_LATE(id, start, deadline_us) probe_record((id), (start) - (uint32_t)(deadline_us))
+
+/**
+ * @brief Prints every histogram over stdio.
+ */
+void probe_dump(void);
+
+/**
+ * @brief Clears every histogram.
+ */
+void probe_reset(void);
+
+#else
+
+#define PROBE_BEGIN(start)
+#define PROBE_END(id, start) ((void)0)
+#define PROBE_LATE(id, start, deadline_us) ((void)0)
+
+static inline void probe_record(probe_id_t id, uint32_t us) {
+}
+
+static inline void probe_dump(void) {
+}
+
+static inline void probe_reset(void) {
+}
+
+#endif // POMODORO_PROBES
+
+#endif // PROBE_H
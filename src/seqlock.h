@@ -0,0 +1,53 @@
+/**
+ * @file seqlock.h
+ * @brief Sequence lock for one writer and any number of readers.
+ *
+ * The writer never waits: it makes the sequence odd, updates the data and
+ * makes it even again. A reader copies the data and retries if the
+ * sequence was odd or changed meanwhile, so it always ends up with a copy
+ * of one single write. Used to hand state between the two cores, where
+ * 32-bit loads and stores are atomic.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/sync.h"
+
+typedef struct {
+    volatile uint32_t sequence; ///< Odd while a write is in progress
+} seqlock_t;
+
+static inline void seqlock_write_begin(seqlock_t *lock) {
+    lock->sequence++;
+    __dmb();
+}
+
+static inline void seqlock_write_end(seqlock_t *lock) {
+    __dmb();
+    lock->sequence++;
+}
+
+/**
+ * @brief Waits out a write in progress and returns the sequence to pass
+ * to seqlock_read_retry() after copying the data.
+ */
+static inline uint32_t seqlock_read_begin(const seqlock_t *lock) {
+    uint32_t sequence;
+    while ((sequence = lock->sequence) & 1)
+        ;
+    __dmb();
+    return sequence;
+}
+
+/**
+ * @brief True if the data copied since seqlock_read_begin() may be torn.
+ */
+static inline bool seqlock_read_retry(const seqlock_t *lock, uint32_t sequence) {
+    __dmb();
+    return lock->sequence != sequence;
+}
+
+#endif // SEQLOCK_H
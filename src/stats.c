@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <string.h>
+#include "stats.h"
+
+#define STATS_REPORT_RECORDS 8 ///< Latest records printed by stats_report()
+
+_Static_assert(sizeof(stats_record_t) == 12, "records must stay compact");
+_Static_assert((STATS_RECORDS & (STATS_RECORDS - 1)) == 0, "the ring index is masked");
+
+void stats_init(stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+static uint32_t stats_seconds(uint64_t us) {
+    return (uint32_t)(us / 1000000);
+}
+
+static uint16_t stats_clamp(uint64_t s) {
+    return s > UINT16_MAX ? UINT16_MAX : (uint16_t)s;
+}
+
+/**
+ * @brief Moves the totals forward to a day, retiring the days that leave
+ * the week. Never moves them back.
+ */
+static void stats_roll(stats_t *stats, uint32_t day) {
+    if (day <= stats->day)
+        return;
+    if (day - stats->day >= STATS_DAYS) {
+        memset(stats->days, 0, sizeof(stats->days));
+        memset(&stats->week, 0, sizeof(stats->week));
+        stats->day = day;
+        return;
+    }
+    while (stats->day < day) {
+        stats_totals_t *old = &stats->days[++stats->day % STATS_DAYS];
+        stats->week.started -= old->started;
+        stats->week.completed -= old->completed;
+        stats->week.breaks -= old->breaks;
+        stats->week.pauses -= old->pauses;
+        stats->week.work_s -= old->work_s;
+        stats->week.break_s -= old->break_s;
+        stats->week.paused_s -= old->paused_s;
+        memset(old, 0, sizeof(*old));
+    }
+}
+
+static void stats_count(stats_totals_t *totals, const stats_record_t *record) {
+    if (record->phase == STATS_WORK) {
+        totals->started++;
+        totals->completed += record->actual_s >= record->planned_s;
+        totals->work_s += record->actual_s;
+    } else {
+        totals->breaks++;
+        totals->break_s += record->actual_s;
+    }
+    totals->pauses += record->pauses;
+    totals->paused_s += record->paused_s;
+}
+
+void stats_add(stats_t *stats, const stats_record_t *record) {
+    uint32_t day = record->start_s / STATS_DAY_S;
+
+    stats->records[stats->count++ % STATS_RECORDS] = *record;
+    stats_roll(stats, day);
+    if (stats->day - day >= STATS_DAYS)
+        return;
+    stats_count(&stats->days[day % STATS_DAYS], record);
+    stats_count(&stats->week, record);
+}
+
+void stats_begin(stats_t *stats, stats_phase_t phase, uint32_t planned_s, uint64_t now_us) {
+    if (stats->open)
+        stats_end(stats, false, now_us);
+    stats->open = true;
+    stats->paused = false;
+    stats->start_us = now_us;
+    stats->current = (stats_record_t){
+        .start_s = stats_seconds(now_us),
+        .planned_s = stats_clamp(planned_s),
+        .phase = (uint8_t)phase,
+    };
+}
+
+void stats_pause(stats_t *stats, uint64_t now_us) {
+    if (!stats->open || stats->paused)
+        return;
+    stats->paused = true;
+    stats->paused_us = now_us;
+    if (stats->current.pauses < UINT8_MAX)
+        stats->current.pauses++;
+}
+
+void stats_resume(stats_t *stats, uint64_t now_us) {
+    if (!stats->open || !stats->paused)
+        return;
+    stats->paused = false;
+    stats->current.paused_s = stats_clamp(stats->current.paused_s + stats_seconds(now_us - stats->paused_us));
+}
+
+void stats_end(stats_t *stats, bool completed, uint64_t now_us) {
+    if (!stats->open)
+        return;
+    stats_resume(stats, now_us);
+    stats->open = false;
+
+    stats_record_t *record = &stats->current;
+    if (completed) {
+        record->actual_s = record->planned_s;
+    } else {
+        uint64_t counted_us = now_us - stats->start_us - record->paused_s * 1000000ull;
+        record->actual_s = stats_clamp(stats_seconds(counted_us));
+        // Stopping early never counts as completed
+        if (record->planned_s && record->actual_s >= record->planned_s)
+            record->actual_s = record->planned_s - 1;
+    }
+    stats_add(stats, record);
+}
+
+const stats_record_t *stats_record(const stats_t *stats, uint32_t age) {
+    if (age >= stats->count || age >= STATS_RECORDS)
+        return NULL;
+    return &stats->records[(stats->count - 1 - age) % STATS_RECORDS];
+}
+
+const stats_totals_t *stats_today(stats_t *stats, uint64_t now_us) {
+    uint32_t day = stats_seconds(now_us) / STATS_DAY_S;
+    stats_roll(stats, day);
+    return &stats->days[day % STATS_DAYS];
+}
+
+const stats_totals_t *stats_week(stats_t *stats, uint64_t now_us) {
+    stats_roll(stats, stats_seconds(now_us) / STATS_DAY_S);
+    return &stats->week;
+}
+
+static void stats_print_totals(const char *name, const stats_totals_t *totals) {
+    printf("%-6s %u of %u work periods completed, %lu min work, %u breaks, %lu min break, "
+           "%u pauses (%lu min)\n", name, totals->completed, totals->started,
+           (unsigned long)(totals->work_s / 60), totals->breaks, (unsigned long)(totals->break_s / 60),
+           totals->pauses, (unsigned long)(totals->paused_s / 60));
+}
+
+void stats_report(stats_t *stats, uint64_t now_us) {
+    stats_print_totals("today", stats_today(stats, now_us));
+    stats_print_totals("week", stats_week(stats, now_us));
+    for (uint32_t age = 0; age < STATS_REPORT_RECORDS; ++age) {
+        const stats_record_t *record = stats_record(stats, age);
+        if (!record)
+            break;
+        printf("  at %lu s: %s %u of %u s, %u pauses (%u s)\n", (unsigned long)record->start_s,
+               record->phase == STATS_WORK ? "work " : "break", record->actual_s, record->planned_s,
+               record->pauses, record->paused_s);
+    }
+}
@@ -0,0 +1,134 @@
+/**
+ * @file stats.h
+ * @brief History of the work and break periods, with daily and weekly totals.
+ *
+ * Each period that ends, run to the end or stopped early, becomes a
+ * 12-byte record in a ring of the last STATS_RECORDS. Totals are kept per
+ * day for the last STATS_DAYS days, plus their sum for the week, and are
+ * updated as each record is added: a query never rescans the history.
+ * When the day changes, the bucket that falls out of the week is
+ * subtracted from the weekly sum and reused.
+ *
+ * The board has no real-time clock, so days are 24-hour spans since boot.
+ *
+ * Everything is in the stats_t, sized at build time; nothing is allocated.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define STATS_RECORDS 128          ///< Periods kept in the history
+#define STATS_DAYS 7               ///< Days summed by the weekly totals
+#define STATS_DAY_S (24 * 3600)
+
+/**
+ * @brief Kinds of periods.
+ */
+typedef enum {
+    STATS_WORK,
+    STATS_BREAK,
+} stats_phase_t;
+
+/**
+ * @brief One period.
+ */
+typedef struct {
+    uint32_t start_s;   ///< Seconds since boot when it started
+    uint16_t planned_s; ///< Length it was set to
+    uint16_t actual_s;  ///< Time counted down; planned_s if it ran to the end
+    uint16_t paused_s;  ///< Time spent paused
+    uint8_t phase;      ///< One of stats_phase_t
+    uint8_t pauses;     ///< Times it was paused
+} stats_record_t;
+
+/**
+ * @brief Totals over a span of time.
+ */
+typedef struct {
+    uint16_t started;   ///< Work periods
+    uint16_t completed; ///< Work periods run to the end
+    uint16_t breaks;    ///< Break periods
+    uint16_t pauses;
+    uint32_t work_s;    ///< Time counted down in work periods
+    uint32_t break_s;   ///< Time counted down in breaks
+    uint32_t paused_s;
+} stats_totals_t;
+
+/**
+ * @brief The history, the totals and the period in progress.
+ */
+typedef struct {
+    stats_record_t records[STATS_RECORDS];
+    uint32_t count;                   ///< Records ever added; the ring keeps the last STATS_RECORDS
+    stats_totals_t days[STATS_DAYS];  ///< Day d is in days[d % STATS_DAYS]
+    uint32_t day;                     ///< Latest day in days[]
+    stats_totals_t week;              ///< Sum of days[]
+
+    bool open;                        ///< A period is in progress
+    bool paused;
+    stats_record_t current;           ///< Period in progress
+    uint64_t start_us;
+    uint64_t paused_us;               ///< When the current pause started
+} stats_t;
+
+/**
+ * @brief Empties the history and the totals.
+ */
+void stats_init(stats_t *stats);
+
+/**
+ * @brief Starts recording a period. A period still open is ended first,
+ * as stopped early.
+ */
+void stats_begin(stats_t *stats, stats_phase_t phase, uint32_t planned_s, uint64_t now_us);
+
+/**
+ * @brief Notes a pause of the period in progress.
+ */
+void stats_pause(stats_t *stats, uint64_t now_us);
+
+/**
+ * @brief Notes the end of a pause.
+ */
+void stats_resume(stats_t *stats, uint64_t now_us);
+
+/**
+ * @brief Ends the period in progress and adds its record.
+ *
+ * @param completed It ran to the end, rather than being stopped.
+ */
+void stats_end(stats_t *stats, bool completed, uint64_t now_us);
+
+/**
+ * @brief Adds a record to the history and to the totals of its day.
+ * Records older than the week only go to the history.
+ */
+void stats_add(stats_t *stats, const stats_record_t *record);
+
+/**
+ * @brief A record from the history.
+ *
+ * @param age 0 for the latest, 1 for the one before, and so on.
+ * @return NULL past the oldest record kept.
+ */
+const stats_record_t *stats_record(const stats_t *stats, uint32_t age);
+
+/**
+ * @brief Totals of the current day.
+ */
+const stats_totals_t *stats_today(stats_t *stats, uint64_t now_us);
+
+/**
+ * @brief Totals of the current day and the STATS_DAYS - 1 before it.
+ */
+const stats_totals_t *stats_week(stats_t *stats, uint64_t now_us);
+
+/**
+ * @brief Prints the totals and the latest records over stdio.
+ */
+void stats_report(stats_t *stats, uint64_t now_us);
+
+#endif // STATS_H
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <string.h>
+#include "timer_wheel.h"
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static timer_wheel_timer_t **timer_wheel_head(timer_wheel_t *wheel, uint16_t slot) {
+    if (slot == TIMER_WHEEL_OVERFLOW)
+        return &wheel->overflow;
+    return &wheel->slots[slot / TIMER_WHEEL_SLOTS][slot % TIMER_WHEEL_SLOTS];
+}
+
+/**
+ * @brief Appends a timer to the slot its deadline belongs to.
+ *
+ * Lists are doubly linked, with head->prev pointing at the tail so that
+ * appending is O(1) and timers sharing a deadline expire in the order
+ * they were added.
+ */
+static void timer_wheel_link(timer_wheel_t *wheel, timer_wheel_timer_t *timer) {
+    uint64_t at = timer->deadline_us > wheel->now_us ? timer->deadline_us : wheel->now_us;
+    uint64_t diff = at ^ wheel->now_us;
+    unsigned level = diff ? (63 - __builtin_clzll(diff)) / TIMER_WHEEL_BITS : 0;
+
+    if (level >= TIMER_WHEEL_LEVELS) {
+        timer->slot = TIMER_WHEEL_OVERFLOW;
+    } else {
+        unsigned index = (at >> (level * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK;
+        timer->slot = level * TIMER_WHEEL_SLOTS + index;
+        wheel->occupied[level] |= 1ull << index;
+    }
+
+    timer_wheel_timer_t **head = timer_wheel_head(wheel, timer->slot);
+    timer->next = NULL;
+    if (*head) {
+        timer->prev = (*head)->prev;
+        (*head)->prev->next = timer;
+        (*head)->prev = timer;
+    } else {
+        timer->prev = timer;
+        *head = timer;
+    }
+    timer->pending = true;
+}
+
+static void timer_wheel_unlink(timer_wheel_t *wheel, timer_wheel_timer_t *timer) {
+    timer_wheel_timer_t **head = timer_wheel_head(wheel, timer->slot);
+    if (timer == *head) {
+        *head = timer->next;
+        if (*head)
+            (*head)->prev = timer->prev;
+    } else {
+        timer->prev->next = timer->next;
+        if (timer->next)
+            timer->next->prev = timer->prev;
+        else
+            (*head)->prev = timer->prev;
+    }
+    if (!*head && timer->slot != TIMER_WHEEL_OVERFLOW)
+        wheel->occupied[timer->slot / TIMER_WHEEL_SLOTS] &= ~(1ull << (timer->slot % TIMER_WHEEL_SLOTS));
+    timer->next = timer->prev = NULL;
+    timer->pending = false;
+}
+
+// Moves every timer of a slot to where it belongs now. The list is taken
+// off the slot first, as an overflow timer may well go back to it.
+static void timer_wheel_relink(timer_wheel_t *wheel, uint16_t slot) {
+    timer_wheel_timer_t **head = timer_wheel_head(wheel, slot);
+    timer_wheel_timer_t *timer = *head;
+    *head = NULL;
+    if (slot != TIMER_WHEEL_OVERFLOW)
+        wheel->occupied[slot / TIMER_WHEEL_SLOTS] &= ~(1ull << (slot % TIMER_WHEEL_SLOTS));
+
+    while (timer) {
+        timer_wheel_timer_t *next = timer->next;
+        timer_wheel_link(wheel, timer);
+        wheel->cascades++;
+        timer = next;
+    }
+}
+
+/**
+ * @brief Moves the current time forward to now_us, which must not be past
+ * any pending deadline.
+ *
+ * No timer can then sit in a slot the current time has gone beyond, so
+ * only the slot the current time enters at each level has to be moved
+ * down; going top-down, timers moved from one level are sorted out again
+ * by the levels below.
+ */
+static void timer_wheel_jump(timer_wheel_t *wheel, uint64_t now_us) {
+    uint64_t old = wheel->now_us;
+    wheel->now_us = now_us;
+
+    if ((old ^ now_us) >> (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+        timer_wheel_relink(wheel, TIMER_WHEEL_OVERFLOW);
+    for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; --level) {
+        unsigned index = (now_us >> (level * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK;
+        if (wheel->occupied[level] & (1ull << index))
+            timer_wheel_relink(wheel, level * TIMER_WHEEL_SLOTS + index);
+    }
+}
+
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t now_us) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->now_us = now_us;
+}
+
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, const char *name,
+                            timer_wheel_callback_t callback, void *data) {
+    memset(timer, 0, sizeof(*timer));
+    timer->name = name;
+    timer->callback = callback;
+    timer->data = data;
+}
+
+void timer_wheel_add(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint64_t deadline_us) {
+    if (timer->pending)
+        timer_wheel_unlink(wheel, timer);
+    timer->deadline_us = deadline_us;
+    timer_wheel_link(wheel, timer);
+}
+
+bool timer_wheel_cancel(timer_wheel_t *wheel, timer_wheel_timer_t *timer) {
+    if (!timer->pending)
+        return false;
+    timer_wheel_unlink(wheel, timer);
+    return true;
+}
+
+/**
+ * @brief Finds the earliest deadline.
+ *
+ * Every timer on a level is due before any timer on the levels above, and
+ * on levels above 0 every occupied slot lies ahead of the current time, so
+ * the lowest occupied slot of the lowest occupied level holds the earliest
+ * deadline. Only that slot's list is walked.
+ */
+bool timer_wheel_next(const timer_wheel_t *wheel, uint64_t *deadline_us) {
+    const timer_wheel_timer_t *timer = wheel->overflow;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+        if (wheel->occupied[level]) {
+            timer = wheel->slots[level][__builtin_ctzll(wheel->occupied[level])];
+            break;
+        }
+    }
+    if (!timer)
+        return false;
+
+    uint64_t earliest = timer->deadline_us;
+    for (timer = timer->next; timer; timer = timer->next) {
+        if (timer->deadline_us < earliest)
+            earliest = timer->deadline_us;
+    }
+    *deadline_us = earliest;
+    return true;
+}
+
+void timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_us) {
+    uint64_t next;
+    while (timer_wheel_next(wheel, &next) && next <= now_us) {
+        if (next > wheel->now_us)
+            timer_wheel_jump(wheel, next);
+
+        // The current level 0 slot only holds timers that are due
+        timer_wheel_timer_t **head = &wheel->slots[0][wheel->now_us & TIMER_WHEEL_MASK];
+        while (*head) {
+            timer_wheel_timer_t *timer = *head;
+            timer_wheel_unlink(wheel, timer);
+            timer->callback(timer, timer->data);
+        }
+    }
+    if (now_us > wheel->now_us)
+        timer_wheel_jump(wheel, now_us);
+}
+
+static void timer_wheel_dump_list(const timer_wheel_timer_t *timer, uint64_t now_us) {
+    for (; timer; timer = timer->next)
+        printf("%-12s %12llu\n", timer->name ? timer->name : "?",
+               (unsigned long long)timer_wheel_remaining_us(timer, now_us) / 1000);
+}
+
+void timer_wheel_dump(const timer_wheel_t *wheel, uint64_t now_us) {
+    printf("%-12s %12s\n", "timer", "left ms");
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+        uint64_t occupied = wheel->occupied[level];
+        while (occupied) {
+            int index = __builtin_ctzll(occupied);
+            occupied &= occupied - 1;
+            timer_wheel_dump_list(wheel->slots[level][index], now_us);
+        }
+    }
+    timer_wheel_dump_list(wheel->overflow, now_us);
+}
@@ -0,0 +1,114 @@
+/**
+ * @file timer_wheel.h
+ * @brief Hierarchical timer wheel over absolute microsecond deadlines.
+ *
+ * Timers are intrusive list nodes kept in TIMER_WHEEL_LEVELS wheels of
+ * TIMER_WHEEL_SLOTS slots. Level L holds the timers whose deadline shares
+ * every bit above 6 * (L + 1) with the wheel's current time, in the slot
+ * given by bits 6 * L to 6 * L + 5 of the deadline. Adding and cancelling
+ * a timer are O(1); as time advances a timer is moved down at most once
+ * per level before it expires. A bitmap per level finds the next deadline
+ * without scanning empty slots, so the wheel only needs to be serviced
+ * when something is actually due.
+ *
+ * Deadlines further ahead than the top level covers wait on an overflow
+ * list, which is sorted out each time the top level wraps around.
+ *
+ * Deadlines are absolute, so a timer that re-arms itself from its own
+ * deadline never accumulates the latency of its callbacks.
+ *
+ * The wheel is not interrupt-safe: use it from the main loop only.
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TIMER_WHEEL_BITS 6                           ///< log2 of the slots per level
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 7                         ///< 42 bits of microseconds, about 50 days
+#define TIMER_WHEEL_OVERFLOW (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS)
+
+typedef struct timer_wheel_timer timer_wheel_timer_t;
+typedef void (*timer_wheel_callback_t)(timer_wheel_timer_t *timer, void *data);
+
+/**
+ * @brief One timer. Owned by the caller, linked into the wheel while pending.
+ */
+struct timer_wheel_timer {
+    timer_wheel_timer_t *next;
+    timer_wheel_timer_t *prev;
+    uint64_t deadline_us;            ///< Absolute time_us_64() deadline
+    const char *name;                ///< For diagnostics
+    timer_wheel_callback_t callback;
+    void *data;
+    uint16_t slot;                   ///< level * TIMER_WHEEL_SLOTS + index, or TIMER_WHEEL_OVERFLOW
+    bool pending;
+};
+
+/**
+ * @brief The wheel.
+ */
+typedef struct {
+    uint64_t now_us;                                                ///< Time the wheel has advanced to
+    uint64_t occupied[TIMER_WHEEL_LEVELS];                          ///< Non-empty slots, one bit each
+    timer_wheel_timer_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    timer_wheel_timer_t *overflow;                                  ///< Beyond the top level
+    uint32_t cascades;                                              ///< Timers moved down a level so far
+} timer_wheel_t;
+
+/**
+ * @brief Empties the wheel and sets its current time.
+ */
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t now_us);
+
+/**
+ * @brief Prepares a timer; it is not pending until timer_wheel_add().
+ */
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, const char *name,
+                            timer_wheel_callback_t callback, void *data);
+
+/**
+ * @brief Arms a timer for an absolute deadline, re-arming it if pending.
+ *
+ * A deadline at or before the wheel's current time expires on the next
+ * timer_wheel_advance().
+ */
+void timer_wheel_add(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint64_t deadline_us);
+
+/**
+ * @brief Disarms a timer.
+ *
+ * @return false if the timer was not pending.
+ */
+bool timer_wheel_cancel(timer_wheel_t *wheel, timer_wheel_timer_t *timer);
+
+/**
+ * @brief Finds the earliest pending deadline.
+ *
+ * @return false if no timer is pending.
+ */
+bool timer_wheel_next(const timer_wheel_t *wheel, uint64_t *deadline_us);
+
+/**
+ * @brief Runs, in deadline order, the callbacks of every timer due at or
+ * before now_us. Each timer is disarmed before its callback runs.
+ * Callbacks may add and cancel timers, themselves included.
+ */
+void timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_us);
+
+/**
+ * @brief Time left until a pending timer's deadline, 0 once it is due.
+ */
+static inline uint64_t timer_wheel_remaining_us(const timer_wheel_timer_t *timer, uint64_t now_us) {
+    return timer->deadline_us > now_us ? timer->deadline_us - now_us : 0;
+}
+
+/**
+ * @brief Prints every pending timer with the time left, over stdio.
+ */
+void timer_wheel_dump(const timer_wheel_t *wheel, uint64_t now_us);
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,79 @@
+#include "tone.h"
+
+#if POMODORO_TONE
+
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware_init.h"
+
+static tone_schedule_t schedule;
+static uint tone_slice;
+static uint tone_channel;
+static uint control_dma;
+static uint data_dma;
+
+void tone_init(void) {
+    tone_slice = pwm_gpio_to_slice_num(BUZZER);
+    tone_channel = pwm_gpio_to_channel(BUZZER);
+    gpio_set_function(BUZZER, GPIO_FUNC_PWM);
+
+    // Silent, on a short period so that the first note starts at once
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_clkdiv_int(&config, TONE_CLOCK_DIV);
+    pwm_config_set_wrap(&config, tone_period(TONE_NOTE_MAX) - 1);
+    pwm_init(tone_slice, &config, true);
+
+    config = pwm_get_default_config();
+    pwm_config_set_clkdiv_int(&config, TONE_TICK_DIV);
+    pwm_config_set_wrap(&config, TONE_TICK_WRAP);
+    pwm_init(TONE_TICK_SLICE, &config, false);
+
+    control_dma = dma_claim_unused_channel(true);
+    data_dma = dma_claim_unused_channel(true);
+
+    // CC then TOP, from the step; the write address is set again by each
+    // control block, as the copy moves it on
+    dma_channel_config c = dma_channel_get_default_config(data_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    dma_channel_configure(data_dma, &c, &pwm_hw->slice[tone_slice].cc, NULL,
+                          sizeof(tone_step_t) / sizeof(uint32_t), false);
+}
+
+/**
+ * @brief The control channel writes the two words of a block into the
+ * same two registers each tick, through a ring of 8 bytes.
+ */
+void tone_play(const tone_sequence_t *sequence) {
+    tone_stop();
+    if (!tone_schedule_build(&schedule, sequence, tone_channel, &pwm_hw->slice[tone_slice].cc))
+        return;
+
+    dma_channel_config c = dma_channel_get_default_config(control_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, 3);
+    channel_config_set_dreq(&c, DREQ_PWM_WRAP0 + TONE_TICK_SLICE);
+    dma_channel_configure(control_dma, &c, &dma_hw->ch[data_dma].al2_read_addr, schedule.blocks,
+                          2 * (schedule.length + 1), true);
+
+    // The first wrap comes one count later
+    pwm_set_counter(TONE_TICK_SLICE, TONE_TICK_WRAP);
+    pwm_set_enabled(TONE_TICK_SLICE, true);
+}
+
+void tone_stop(void) {
+    pwm_set_enabled(TONE_TICK_SLICE, false);
+    dma_channel_abort(control_dma);
+    dma_channel_abort(data_dma);
+    pwm_set_chan_level(tone_slice, tone_channel, 0);
+}
+
+bool tone_busy(void) {
+    return dma_channel_is_busy(control_dma);
+}
+
+#endif
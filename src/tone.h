@@ -0,0 +1,72 @@
+/**
+ * @file tone.h
+ * @brief Alerts on the buzzer, played by DMA and PWM without the CPU.
+ *
+ * The buzzer's PWM slice makes the tone: TOP sets its period and CC the
+ * duty. tone_play() expands a sequence into a schedule (see
+ * tone_sequence.h) and starts two DMA channels on it. A second PWM slice,
+ * with no pin, wraps every half tick and paces the control channel, which
+ * moves one control block per tick into the data channel's AL2 registers:
+ * the step to read and, through the trigger alias, the CC register to
+ * write. Each write starts the data channel, which copies CC and TOP
+ * into the buzzer's slice; the slice takes them at its next wrap, so no
+ * period is ever cut short. No interrupt is raised and the core may sleep
+ * through the whole alert. The last block silences the buzzer, and the
+ * control channel stops once its count runs out.
+ *
+ * The schedule lives in RAM while it plays, under 2 KB.
+ *
+ * Alerts are only built with POMODORO_TONE defined to 1; otherwise the
+ * functions do nothing and no storage is reserved.
+ */
+
+#ifndef TONE_H
+#define TONE_H
+
+#include <stdbool.h>
+#include "tone_sequence.h"
+
+#define TONE_TICK_SLICE 4 ///< Paces the control channel; its pins, GPIO 8 and 9, are not used
+
+#if POMODORO_TONE
+
+/**
+ * @brief Sets up the buzzer's PWM slice, silent, the pacing slice and the
+ * two DMA channels.
+ */
+void tone_init(void);
+
+/**
+ * @brief Plays a sequence, cutting short the one playing. Returns at
+ * once; does nothing if the sequence does not fit a schedule.
+ */
+void tone_play(const tone_sequence_t *sequence);
+
+/**
+ * @brief Stops the sequence playing and silences the buzzer.
+ */
+void tone_stop(void);
+
+/**
+ * @brief Returns true while a sequence plays.
+ */
+bool tone_busy(void);
+
+#else
+
+static inline void tone_init(void) {
+}
+
+static inline void tone_play(const tone_sequence_t *sequence) {
+}
+
+static inline void tone_stop(void) {
+}
+
+static inline bool tone_busy(void) {
+    return false;
+}
+
+#endif
+
+#endif // TONE_H
@@ -0,0 +1,70 @@
+#include "tone_sequence.h"
+
+/**
+ * @brief Counts per period of the notes of the lowest octave, C2 to B2,
+ * at TONE_CLOCK_HZ. Each octave up halves them.
+ */
+static const uint16_t octave_periods[12] = {
+    47778, 45097, 42566, 40177, 37922, 35793, 33784, 31888, 30098, 28409, 26815, 25310,
+};
+
+static const tone_note_t work_done_notes[] = {
+    {84, 10}, {0, 2}, {88, 10}, {0, 2}, {91, 10}, {0, 2}, {96, 24},
+};
+
+static const tone_note_t break_done_notes[] = {
+    {91, 8}, {0, 4}, {91, 8}, {0, 4}, {96, 24},
+};
+
+const tone_sequence_t tone_work_done = {
+    work_done_notes, sizeof(work_done_notes) / sizeof(work_done_notes[0]), 128,
+};
+
+const tone_sequence_t tone_break_done = {
+    break_done_notes, sizeof(break_done_notes) / sizeof(break_done_notes[0]), 128,
+};
+
+uint16_t tone_period(uint8_t note) {
+    uint8_t octave = (note - TONE_NOTE_MIN) / 12;
+    uint16_t period = octave_periods[(note - TONE_NOTE_MIN) % 12];
+    // Rounded, so the error stays under half a count
+    return (uint16_t)((period + ((1u << octave) >> 1)) >> octave);
+}
+
+/**
+ * @brief A rest keeps the TOP of the note before it, so only the duty
+ * changes.
+ */
+bool tone_schedule_build(tone_schedule_t *schedule, const tone_sequence_t *sequence, uint8_t channel,
+                         volatile void *cc) {
+    uint32_t top = 0xFFFF;
+    uint16_t tick = 0;
+
+    if (sequence->count > TONE_MAX_NOTES)
+        return false;
+    for (uint8_t i = 0; i < sequence->count; ++i) {
+        const tone_note_t *note = &sequence->notes[i];
+        tone_step_t *step = &schedule->steps[i];
+        uint32_t level = 0;
+
+        if (note->note) {
+            if (note->note < TONE_NOTE_MIN || note->note > TONE_NOTE_MAX)
+                return false;
+            uint16_t period = tone_period(note->note);
+            top = period - 1u;
+            level = (uint32_t)period * sequence->volume >> 8;
+        }
+        step->cc = level << (16 * channel);
+        step->top = top;
+
+        if (tick + note->ticks > TONE_MAX_TICKS)
+            return false;
+        for (uint8_t t = 0; t < note->ticks; ++t)
+            schedule->blocks[tick++] = (tone_block_t){step, cc};
+    }
+
+    schedule->steps[sequence->count] = (tone_step_t){.cc = 0, .top = top};
+    schedule->blocks[tick] = (tone_block_t){&schedule->steps[sequence->count], cc};
+    schedule->length = tick;
+    return true;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file tone_sequence.h
+ * @brief Note sequences for the buzzer, and the register values DMA feeds
+ * to the PWM to play them.
+ *
+ * A sequence is compact data: two bytes per note, a MIDI note number and
+ * a length in ticks of TONE_TICK_US. Before it plays, it is expanded into
+ * a schedule the DMA follows alone (see tone.h): one step per note,
+ * holding the CC and TOP values of the buzzer's PWM slice in the order of
+ * the slice registers, and one control block per tick, the read and write
+ * addresses that make the data channel copy the step of that tick into
+ * the slice. The blocks end with a silent step.
+ *
+ * Nothing here touches the hardware, so the host checks schedules as
+ * they are built for the board.
+ */
+
+#ifndef TONE_SEQUENCE_H
+#define TONE_SEQUENCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TONE_SYS_HZ 125000000 ///< System clock the dividers are set for, the SDK default
+#define TONE_CLOCK_DIV 40     ///< Buzzer slice counts at 3.125 MHz
+#define TONE_CLOCK_HZ (TONE_SYS_HZ / TONE_CLOCK_DIV)
+#define TONE_TICK_DIV 250     ///< Pacing slice counts at 500 kHz...
+#define TONE_TICK_WRAP 2499   ///< ...and wraps every 5 ms, once per word of a control block
+#define TONE_TICK_US (2 * (TONE_TICK_WRAP + 1) * (uint64_t)TONE_TICK_DIV * 1000000 / TONE_SYS_HZ)
+
+#define TONE_NOTE_MIN 36   ///< C2, 65 Hz; lower periods overflow the 16-bit counter
+#define TONE_NOTE_MAX 108  ///< C8, 4186 Hz
+#define TONE_MAX_NOTES 32  ///< Per sequence
+#define TONE_MAX_TICKS 200 ///< Per sequence, 2 s
+
+/**
+ * @brief One note: a MIDI note number, 0 for a rest, held for ticks.
+ */
+typedef struct {
+    uint8_t note;
+    uint8_t ticks;
+} tone_note_t;
+
+/**
+ * @brief A melody.
+ */
+typedef struct {
+    const tone_note_t *notes;
+    uint8_t count;
+    uint8_t volume; ///< Duty cycle in 1/256 of the period; 128, a square wave, is the loudest
+} tone_sequence_t;
+
+/**
+ * @brief The CC and TOP values of one note, in register order.
+ */
+typedef struct {
+    uint32_t cc;
+    uint32_t top;
+} tone_step_t;
+
+/**
+ * @brief One tick: what the control channel writes into the data
+ * channel's AL2_READ_ADDR and AL2_WRITE_ADDR_TRIG registers.
+ */
+typedef struct {
+    const tone_step_t *read; ///< The step of the tick
+    volatile void *write;    ///< The CC register of the slice; writing it starts the copy
+} tone_block_t;
+
+/**
+ * @brief What DMA reads to play a sequence, under 2 KB on the board.
+ */
+typedef struct {
+    tone_step_t steps[TONE_MAX_NOTES + 1];    ///< One per note, then silence
+    tone_block_t blocks[TONE_MAX_TICKS + 1]; ///< One per tick, then silence
+    uint16_t length;                          ///< Ticks of the sequence
+} tone_schedule_t;
+
+extern const tone_sequence_t tone_work_done;  ///< Rising arpeggio: a break starts
+extern const tone_sequence_t tone_break_done; ///< Two calls and a high note: back to work
+
+/**
+ * @brief Counts of the buzzer slice per period of a note, TOP + 1.
+ */
+uint16_t tone_period(uint8_t note);
+
+/**
+ * @brief Expands a sequence into a schedule.
+ *
+ * @param schedule Receives the steps and the control blocks.
+ * @param sequence The melody.
+ * @param channel PWM channel of the buzzer pin, 0 for A and 1 for B.
+ * @param cc The CC register of the buzzer's slice, followed by TOP.
+ * @return false if the sequence is too long or has a note out of range.
+ */
+bool tone_schedule_build(tone_schedule_t *schedule, const tone_sequence_t *sequence, uint8_t channel,
+                         volatile void *cc);
+
+#endif // TONE_SEQUENCE_H
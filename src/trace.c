@@ -0,0 +1,96 @@
+#include "trace.h"
+
+#if POMODORO_TRACE
+
+#include <stdio.h>
+#include <string.h>
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+_Static_assert(LINK_TRACE_HEADER + LINK_TRACE_RECORDS * TRACE_RECORD_SIZE <= LINK_PAYLOAD_MAX,
+               "trace records fit in a message");
+
+static uint8_t ring[TRACE_CAPACITY][TRACE_RECORD_SIZE];
+static volatile uint32_t written;  ///< Records stored since boot
+static volatile uint32_t sent;     ///< Of those, streamed
+static volatile bool lost;         ///< The ring filled up; nothing is stored any more
+static volatile uint32_t dropped;  ///< Records made since
+static bool lost_sent;             ///< The host was told
+static bool streaming;
+static trace_tap_t trace_tap;
+static void *trace_tap_data;
+
+/**
+ * @brief The time is read with interrupts off, so the records are in time
+ * order even when an IRQ records something in between.
+ */
+void trace_record(trace_type_t type, uint8_t arg, uint32_t value) {
+    trace_record_t record = { .value = value, .type = (uint8_t)type, .arg = arg };
+
+    uint32_t status = save_and_disable_interrupts();
+    record.time_us = time_us_64();
+    if (!lost && written - sent == TRACE_CAPACITY)
+        lost = true;
+    if (lost) {
+        dropped++;
+    } else {
+        trace_pack(&record, ring[written % TRACE_CAPACITY]);
+        written++;
+    }
+    restore_interrupts(status);
+
+    if (trace_tap)
+        trace_tap(&record, trace_tap_data);
+}
+
+void trace_frame(const uint8_t *frame, size_t length) {
+    trace_record(TRACE_FRAME, 0, trace_hash(frame, length));
+}
+
+void trace_enable(bool enabled) {
+    streaming = enabled;
+}
+
+/**
+ * @brief Sends full messages while records are waiting, then the rest.
+ * The message with the last record before the ring filled up carries
+ * LINK_TRACE_LOST, on its own if nothing is left to send with it.
+ */
+void trace_stream(link_t *link) {
+    link_message_t message = { .type = LINK_TRACE, .seq = 0 };
+
+    while (streaming) {
+        bool ended = lost;
+        uint32_t waiting = written - sent;
+        uint32_t count = waiting < LINK_TRACE_RECORDS ? waiting : LINK_TRACE_RECORDS;
+        bool last = ended && count == waiting && !lost_sent;
+        if (count == 0 && !last)
+            return;
+
+        uint32_t index = sent;
+        for (int i = 0; i < 4; ++i)
+            message.payload[i] = (uint8_t)(index >> (8 * i));
+        message.payload[4] = last ? LINK_TRACE_LOST : 0;
+        for (uint32_t i = 0; i < count; ++i)
+            memcpy(&message.payload[LINK_TRACE_HEADER + i * TRACE_RECORD_SIZE],
+                   ring[(index + i) % TRACE_CAPACITY], TRACE_RECORD_SIZE);
+        message.length = (uint8_t)(LINK_TRACE_HEADER + count * TRACE_RECORD_SIZE);
+        link_send(link, &message);
+        sent = index + count;
+        lost_sent |= last;
+    }
+}
+
+void trace_report(void) {
+    printf("trace: %lu records, %lu streamed, %lu waiting of %d%s\n", (unsigned long)written,
+           (unsigned long)sent, (unsigned long)(written - sent), TRACE_CAPACITY, streaming ? ", streaming" : "");
+    if (lost)
+        printf("trace: ring full, %lu records dropped since\n", (unsigned long)dropped);
+}
+
+void trace_set_tap(trace_tap_t tap, void *data) {
+    trace_tap = tap;
+    trace_tap_data = data;
+}
+
+#endif // POMODORO_TRACE
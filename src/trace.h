@@ -0,0 +1,92 @@
+/**
+ * @file trace.h
+ * @brief Records the inputs of the firmware, to replay them on the host
+ * simulator.
+ *
+ * Button edges, alarm arrivals and console bytes go into a RAM ring as
+ * they happen, along with a hash of each frame sent to the panel (see
+ * trace_record.h). The ring is emptied over the USB link once the host
+ * asks for the trace with LINK_SET_TRACE. Until the timer is started
+ * almost nothing is recorded, so a host that connects before the first
+ * press gets the whole trace from boot. If the ring fills up, recording
+ * stops for good: a trace with a gap could not be replayed anyway.
+ *
+ * Frames are only hashed in the single-core build; with
+ * POMODORO_MULTICORE the framebuffer belongs to core1.
+ *
+ * Recording is only built with POMODORO_TRACE defined to 1; otherwise the
+ * functions do nothing and no storage is reserved.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "trace_record.h"
+#include "link.h"
+
+#define TRACE_CAPACITY 512 ///< Records waiting to be streamed, 6 KB; about 15 s of a running countdown
+
+/**
+ * @brief Sees every record as it is made, stored or not. The simulator
+ * records and replays traces through it.
+ */
+typedef void (*trace_tap_t)(const trace_record_t *record, void *data);
+
+#if POMODORO_TRACE
+
+/**
+ * @brief Adds a record, stamped with the current time. Safe from
+ * interrupt context.
+ */
+void trace_record(trace_type_t type, uint8_t arg, uint32_t value);
+
+/**
+ * @brief Adds a TRACE_FRAME record for a framebuffer just sent.
+ */
+void trace_frame(const uint8_t *frame, size_t length);
+
+/**
+ * @brief Starts or stops streaming the ring over the link. Starting picks
+ * up at the oldest record not yet sent.
+ */
+void trace_enable(bool enabled);
+
+/**
+ * @brief Sends the records not yet sent, if streaming. Main loop only,
+ * after the flush.
+ */
+void trace_stream(link_t *link);
+
+/**
+ * @brief Prints the record counters over stdio.
+ */
+void trace_report(void);
+
+void trace_set_tap(trace_tap_t tap, void *data);
+
+#else
+
+static inline void trace_record(trace_type_t type, uint8_t arg, uint32_t value) {
+}
+
+static inline void trace_frame(const uint8_t *frame, size_t length) {
+}
+
+static inline void trace_enable(bool enabled) {
+}
+
+static inline void trace_stream(link_t *link) {
+}
+
+static inline void trace_report(void) {
+}
+
+static inline void trace_set_tap(trace_tap_t tap, void *data) {
+}
+
+#endif // POMODORO_TRACE
+
+#endif // TRACE_H
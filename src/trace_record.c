@@ -0,0 +1,28 @@
+#include "trace_record.h"
+
+void trace_pack(const trace_record_t *record, uint8_t *out) {
+    for (int i = 0; i < 6; ++i)
+        out[i] = (uint8_t)(record->time_us >> (8 * i));
+    out[6] = record->type;
+    out[7] = record->arg;
+    for (int i = 0; i < 4; ++i)
+        out[8 + i] = (uint8_t)(record->value >> (8 * i));
+}
+
+void trace_unpack(const uint8_t *in, trace_record_t *record) {
+    record->time_us = 0;
+    for (int i = 0; i < 6; ++i)
+        record->time_us |= (uint64_t)in[i] << (8 * i);
+    record->type = in[6];
+    record->arg = in[7];
+    record->value = 0;
+    for (int i = 0; i < 4; ++i)
+        record->value |= (uint32_t)in[8 + i] << (8 * i);
+}
+
+uint32_t trace_hash(const uint8_t *data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i)
+        hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file trace_record.h
+ * @brief Records of an input trace, as kept in a trace file and sent in
+ * LINK_TRACE messages.
+ *
+ * A trace holds everything from outside that the firmware reacted to, in
+ * order: the button edges the GPIO IRQ saw, the arrival of each alarm of
+ * the timer wheel and the bytes read by the console. A hash of the
+ * framebuffer each time it is sent to the panel lets a replay check that
+ * it draws the same frames. A trace starts with TRACE_BOOT, which carries
+ * the durations loaded from flash.
+ *
+ * A record is TRACE_RECORD_SIZE bytes: time in microseconds since boot
+ * (48 bits), type, argument and value, little-endian. A trace file is its
+ * records one after the other. This file is shared by the firmware, the
+ * simulator and the host tools; it needs no SDK.
+ */
+
+#ifndef TRACE_RECORD_H
+#define TRACE_RECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACE_RECORD_SIZE 12
+
+/**
+ * @brief Record types.
+ */
+typedef enum {
+    TRACE_BOOT,  ///< arg work minutes, value break minutes, as loaded
+    TRACE_EDGE,  ///< arg GPIO, value its GPIO_IRQ_EDGE_* events
+    TRACE_TICK,  ///< The wheel alarm fired; value microseconds after its deadline
+    TRACE_RX,    ///< arg a byte read by the console
+    TRACE_FRAME, ///< The framebuffer was sent to the panel; value its trace_hash()
+} trace_type_t;
+
+/**
+ * @brief One record, unpacked.
+ */
+typedef struct {
+    uint64_t time_us;
+    uint32_t value;
+    uint8_t type;  ///< One of trace_type_t
+    uint8_t arg;
+} trace_record_t;
+
+void trace_pack(const trace_record_t *record, uint8_t *out);
+void trace_unpack(const uint8_t *in, trace_record_t *record);
+
+/**
+ * @brief FNV-1a of a framebuffer, for TRACE_FRAME.
+ */
+uint32_t trace_hash(const uint8_t *data, size_t length);
+
+#endif // TRACE_RECORD_H
@@ -0,0 +1,202 @@
+#include "widget.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief The screen each panel's framebuffer holds, NULL if unknown.
+ */
+static struct {
+    const ssd1306_t *ssd;
+    const widget_screen_t *screen;
+} widget_current[SSD1306_MAX_INSTANCES];
+
+/**
+ * @brief The entry of a panel, taking a free one the first time.
+ */
+static const widget_screen_t **widget_current_of(const ssd1306_t *ssd) {
+    for (uint8_t i = 0; i < SSD1306_MAX_INSTANCES; ++i) {
+        if (widget_current[i].ssd == ssd || !widget_current[i].ssd) {
+            widget_current[i].ssd = ssd;
+            return &widget_current[i].screen;
+        }
+    }
+    hard_assert(false);
+    return NULL;
+}
+
+void widget_text_init(widget_t *widget, const ssd1306_font_t *font, uint8_t x, uint8_t y,
+                      uint8_t chars, const char *text) {
+    if (chars > WIDGET_TEXT_MAX)
+        chars = WIDGET_TEXT_MAX;
+    *widget = (widget_t){
+        .kind = WIDGET_TEXT,
+        .x = x,
+        .y = y,
+        .width = (uint8_t)(chars * font->width),
+        .height = font->height,
+        .font = font,
+        .dirty = true,
+    };
+    widget_set_text(widget, text);
+}
+
+void widget_progress_init(widget_t *widget, uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    *widget = (widget_t){
+        .kind = WIDGET_PROGRESS,
+        .x = x,
+        .y = y,
+        .width = width,
+        .height = height,
+        .max = 1,
+        .dirty = true,
+    };
+}
+
+void widget_icon_init(widget_t *widget, uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    *widget = (widget_t){
+        .kind = WIDGET_ICON,
+        .x = x,
+        .y = y,
+        .width = width,
+        .height = height,
+        .dirty = true,
+    };
+}
+
+void widget_set_text(widget_t *widget, const char *text) {
+    char value[WIDGET_TEXT_MAX + 1];
+    uint8_t chars = widget->width / widget->font->width;
+
+    strncpy(value, text, chars);
+    value[chars] = '\0';
+    if (strcmp(value, widget->text) == 0)
+        return;
+    memcpy(widget->text, value, sizeof(value));
+    widget->dirty = true;
+}
+
+void widget_set_time(widget_t *widget, int minutes, int seconds) {
+    char text[WIDGET_TEXT_MAX + 1];
+    snprintf(text, sizeof(text), "%02d:%02d", minutes, seconds);
+    widget_set_text(widget, text);
+}
+
+void widget_set_progress(widget_t *widget, uint16_t value, uint16_t max) {
+    if (max == 0)
+        max = 1;
+    if (value > max)
+        value = max;
+    if ((uint32_t)value * widget->max == (uint32_t)widget->value * max)
+        return;
+    widget->value = value;
+    widget->max = max;
+    widget->dirty = true;
+}
+
+void widget_set_icon(widget_t *widget, const ssd1306_bitmap_t *icon) {
+    if (icon == widget->icon)
+        return;
+    widget->icon = icon;
+    widget->dirty = true;
+}
+
+/**
+ * @brief Redraws the cells whose character changed. Cells past the end of
+ * the text are blank.
+ */
+static void widget_render_text(ssd1306_t *ssd, widget_t *widget) {
+    const ssd1306_font_t *font = widget->font;
+    uint8_t chars = widget->width / font->width;
+    bool text_ended = false, shown_ended = false;
+
+    for (uint8_t i = 0; i < chars; ++i) {
+        text_ended = text_ended || widget->text[i] == '\0';
+        shown_ended = shown_ended || widget->shown[i] == '\0';
+        char now = text_ended ? ' ' : widget->text[i];
+        char was = shown_ended ? ' ' : widget->shown[i];
+        if (now != was)
+            ssd1306_draw_glyph(ssd, font, now, widget->x + i * font->width, widget->y);
+    }
+    memcpy(widget->shown, widget->text, sizeof(widget->shown));
+}
+
+/**
+ * @brief Fills or clears only the columns between the old and new fill,
+ * then draws the leading column, filled from the bottom.
+ */
+static void widget_render_progress(ssd1306_t *ssd, widget_t *widget) {
+    uint8_t inner = widget->width - 2, rows = widget->height - 2;
+    uint16_t filled = (uint16_t)((uint32_t)widget->value * inner * rows / widget->max);
+    uint8_t fill = filled / rows, shown_fill = widget->shown_rows / rows;
+    uint8_t left = widget->x + 1, top = widget->y + 1;
+
+    if (!widget->outlined) {
+        ssd1306_rect(ssd, widget->y, widget->x, widget->width, widget->height, true, false);
+        widget->outlined = true;
+    }
+    if (fill > shown_fill) {
+        ssd1306_rect(ssd, top, left + shown_fill, fill - shown_fill, rows, true, true);
+    } else if (fill < shown_fill) {
+        // Up to the old leading column, if it is inside the bar
+        uint8_t end = shown_fill < inner ? shown_fill + 1 : inner;
+        ssd1306_rect(ssd, top, left + fill + 1, end - fill - 1, rows, false, true);
+    }
+    if (fill < inner && filled != widget->shown_rows) {
+        uint8_t part = filled % rows;
+        ssd1306_vline(ssd, left + fill, top, top + rows - part - 1, false);
+        if (part > 0)
+            ssd1306_vline(ssd, left + fill, top + rows - part, top + rows - 1, true);
+    }
+    widget->shown_rows = filled;
+}
+
+/**
+ * @brief Copies the icon over the box, or clears the box.
+ */
+static void widget_render_icon(ssd1306_t *ssd, widget_t *widget) {
+    if (widget->icon == widget->shown_icon)
+        return;
+    if (widget->icon)
+        ssd1306_blit(ssd, widget->icon, widget->x, widget->y, SSD1306_ROP_COPY);
+    else
+        ssd1306_rect(ssd, widget->y, widget->x, widget->width, widget->height, false, true);
+    widget->shown_icon = widget->icon;
+}
+
+void widget_screen_render(ssd1306_t *ssd, const widget_screen_t *screen) {
+    const widget_screen_t **current = widget_current_of(ssd);
+    bool redraw = screen != *current;
+
+    if (redraw) {
+        ssd1306_fill(ssd, false);
+        if (screen->border)
+            ssd1306_rect(ssd, 0, 0, WIDTH, HEIGHT, true, false);
+        *current = screen;
+    }
+
+    for (uint8_t i = 0; i < screen->count; ++i) {
+        widget_t *widget = screen->widgets[i];
+        if (redraw) {
+            // The framebuffer is blank under every widget now
+            widget->shown[0] = '\0';
+            widget->shown_rows = 0;
+            widget->outlined = false;
+            widget->shown_icon = NULL;
+        } else if (!widget->dirty) {
+            continue;
+        }
+
+        if (widget->kind == WIDGET_TEXT)
+            widget_render_text(ssd, widget);
+        else if (widget->kind == WIDGET_PROGRESS)
+            widget_render_progress(ssd, widget);
+        else
+            widget_render_icon(ssd, widget);
+        widget->dirty = false;
+    }
+}
+
+void widget_invalidate(void) {
+    for (uint8_t i = 0; i < SSD1306_MAX_INSTANCES; ++i)
+        widget_current[i].screen = NULL;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file widget.h
+ * @brief Retained widgets: text, progress bars and icons that redraw only
+ * what changed.
+ *
+ * Every widget keeps its value and what it last drew. Setting a value
+ * only marks the widget dirty if the value is different, and rendering
+ * compares the two: a text widget redraws just the character cells that
+ * differ, a progress bar just the columns between the old and the new
+ * fill. A bar fills a column at a time and, inside the leading column,
+ * a row at a time from the bottom, so it moves in steps of one pixel of
+ * area rather than one column. An icon is blitted whole when it changes.
+ * The drawing primitives mark those boxes dirty, so the display
+ * driver sends only them.
+ *
+ * Widgets are grouped into screens. Switching screens clears the
+ * framebuffer once and draws every widget of the new screen. Each panel
+ * remembers its own screen; a screen, and so a widget, is only ever
+ * drawn on one panel.
+ */
+
+#ifndef WIDGET_H
+#define WIDGET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../inc/ssd1306.h"
+
+#define WIDGET_TEXT_MAX 16 ///< Characters of a text widget
+
+/**
+ * @brief Kinds of widgets.
+ */
+typedef enum {
+    WIDGET_TEXT,     ///< Labels, status text and the time readout
+    WIDGET_PROGRESS, ///< Outlined bar filled from the left
+    WIDGET_ICON,     ///< A bitmap the size of the box, or nothing
+} widget_kind_t;
+
+/**
+ * @brief One widget. Its bounding box never changes.
+ */
+typedef struct {
+    uint8_t kind;                       ///< One of widget_kind_t
+    uint8_t x, y, width, height;        ///< Bounding box
+    bool dirty;                         ///< Value differs from what was drawn
+    const ssd1306_font_t *font;         ///< Text: font of every cell
+    char text[WIDGET_TEXT_MAX + 1];     ///< Text: value
+    char shown[WIDGET_TEXT_MAX + 1];    ///< Text: what the framebuffer holds
+    uint16_t value, max;                ///< Progress: value out of max
+    uint16_t shown_rows;                ///< Progress: rows filled on the framebuffer, columns times height
+    bool outlined;                      ///< Progress: outline drawn
+    const ssd1306_bitmap_t *icon;       ///< Icon: value, NULL for none
+    const ssd1306_bitmap_t *shown_icon; ///< Icon: what the framebuffer holds
+} widget_t;
+
+/**
+ * @brief A set of widgets shown together, optionally inside a border
+ * around the whole display.
+ */
+typedef struct {
+    widget_t *const *widgets;
+    uint8_t count;
+    bool border;
+} widget_screen_t;
+
+/**
+ * @brief Prepares a text widget of up to chars cells, initially text.
+ */
+void widget_text_init(widget_t *widget, const ssd1306_font_t *font, uint8_t x, uint8_t y,
+                      uint8_t chars, const char *text);
+
+/**
+ * @brief Prepares a progress bar, initially empty.
+ */
+void widget_progress_init(widget_t *widget, uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+
+/**
+ * @brief Prepares an icon widget, initially empty.
+ */
+void widget_icon_init(widget_t *widget, uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+
+/**
+ * @brief Sets the text, cut to the widget's cells.
+ */
+void widget_set_text(widget_t *widget, const char *text);
+
+/**
+ * @brief Sets the text to minutes and seconds as MM:SS.
+ */
+void widget_set_time(widget_t *widget, int minutes, int seconds);
+
+/**
+ * @brief Sets the bar to value out of max.
+ */
+void widget_set_progress(widget_t *widget, uint16_t value, uint16_t max);
+
+/**
+ * @brief Sets the icon, a bitmap the size of the widget, or NULL to clear
+ * it.
+ */
+void widget_set_icon(widget_t *widget, const ssd1306_bitmap_t *icon);
+
+/**
+ * @brief Brings the framebuffer up to date with a screen.
+ *
+ * If another screen was shown, or after widget_invalidate(), the
+ * framebuffer is cleared and everything is drawn; otherwise only dirty
+ * widgets are redrawn, and only where they changed.
+ */
+void widget_screen_render(ssd1306_t *ssd, const widget_screen_t *screen);
+
+/**
+ * @brief Forgets what the framebuffers hold, for code that drew on them
+ * directly. The next render on each panel redraws the whole screen.
+ */
+void widget_invalidate(void);
+
+#endif // WIDGET_H
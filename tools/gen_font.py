@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Generates the SSD1306 font atlas from the text fonts in fonts/.
+
+Every glyph is stored in the panel's native layout: column by column,
+each column as consecutive page bytes with the top row in bit 0. The
+driver can then copy a glyph into the framebuffer a byte at a time. Each
+font also gets a 128-entry ASCII table mapping characters to glyphs;
+glyph 0 is the blank cell used for anything the source does not define.
+
+Large fonts are scaled from a small source at build time. Listing the
+characters to keep after "@" leaves the rest out of flash, so a 3x digit
+font costs only its eleven glyphs.
+
+Usage: gen_font.py OUTPUT.c NAME=SOURCE[:SCALE][@CHARS] [...]
+"""
+
+import os
+import sys
+
+
+def parse_font(path):
+    """Returns ((width, height), {char: [row strings]}) for a font source."""
+    size = None
+    glyphs = {}
+    current = None
+    with open(path) as f:
+        for lineno, raw in enumerate(f, 1):
+            line = raw.rstrip('\n')
+            if not line:
+                current = None
+            elif line.startswith('#') and current is None:
+                continue
+            elif line.startswith('size '):
+                w, h = line.split()[1:3]
+                size = (int(w), int(h))
+            elif line.startswith('char '):
+                ch = line[len("char '"):-1]
+                if len(ch) != 1 or not 32 <= ord(ch) < 127:
+                    sys.exit(f'{path}:{lineno}: bad character {line!r}')
+                current = ch
+                glyphs[ch] = []
+            elif current is not None:
+                if size is None or len(line) != size[0] or set(line) - set('#.'):
+                    sys.exit(f'{path}:{lineno}: bad glyph row {line!r}')
+                glyphs[current].append(line)
+                if len(glyphs[current]) == size[1]:
+                    current = None
+            else:
+                sys.exit(f'{path}:{lineno}: unexpected {line!r}')
+    for ch, rows in glyphs.items():
+        if len(rows) != size[1]:
+            sys.exit(f'{path}: glyph {ch!r} has {len(rows)} rows, expected {size[1]}')
+    return size, glyphs
+
+
+def scale_rows(rows, scale):
+    return [''.join(c * scale for c in row) for row in rows for _ in range(scale)]
+
+
+def to_columns(rows, width, pages):
+    """Packs rows into column-major page bytes, top row in bit 0."""
+    out = []
+    for x in range(width):
+        for page in range(pages):
+            byte = 0
+            for bit in range(8):
+                y = page * 8 + bit
+                if y < len(rows) and rows[y][x] == '#':
+                    byte |= 1 << bit
+            out.append(byte)
+    return out
+
+
+def emit_font(name, source, scale, chars):
+    (width, height), glyphs = parse_font(source)
+    if chars:
+        glyphs = {ch: rows for ch, rows in glyphs.items() if ch in chars}
+    width *= scale
+    height *= scale
+    pages = (height + 7) // 8
+    glyph_size = width * pages
+
+    data = [('blank', [0] * glyph_size)]
+    lookup = [0] * 128
+    for ch in sorted(glyphs):
+        columns = to_columns(scale_rows(glyphs[ch], scale), width, pages)
+        if not any(columns):
+            continue
+        lookup[ord(ch)] = len(data)
+        data.append((repr(ch), columns))
+    if len(data) > 256:
+        sys.exit(f'{source}: more than 255 glyphs')
+
+    lines = [f'// {name}: {os.path.basename(source)}, scale {scale}, '
+             f'{width}x{height}, {len(data)} glyphs',
+             f'static const uint8_t {name}_glyphs[] = {{']
+    for label, columns in data:
+        lines.append(f'    // {label}')
+        for i in range(0, len(columns), 16):
+            lines.append('    ' + ' '.join(f'0x{b:02x},' for b in columns[i:i + 16]))
+    lines.append('};')
+    lines.append('')
+    lines.append(f'static const uint8_t {name}_lookup[128] = {{')
+    for i in range(0, 128, 16):
+        lines.append('    ' + ' '.join(f'{g:3d},' for g in lookup[i:i + 16]))
+    lines.append('};')
+    lines.append('')
+    lines.append(f'const ssd1306_font_t {name} = {{')
+    lines.append(f'    .width = {width},')
+    lines.append(f'    .height = {height},')
+    lines.append(f'    .pages = {pages},')
+    lines.append(f'    .glyph_size = {glyph_size},')
+    lines.append(f'    .lookup = {name}_lookup,')
+    lines.append(f'    .glyphs = {name}_glyphs,')
+    lines.append('};')
+    lines.append('')
+    return lines
+
+
+def main(argv):
+    if len(argv) < 3:
+        sys.exit(__doc__)
+    output = argv[1]
+    lines = ['// Generated by tools/gen_font.py, do not edit.',
+             '// const data stays in flash and is read through XIP.',
+             '',
+             '#include "inc/font.h"',
+             '']
+    for spec in argv[2:]:
+        name, rest = spec.split('=', 1)
+        rest, _, chars = rest.partition('@')
+        source, _, scale = rest.partition(':')
+        lines += emit_font(name, source, int(scale or 1), chars)
+    with open(output, 'w') as f:
+        f.write('\n'.join(lines))
+
+
+if __name__ == '__main__':
+    main(sys.argv)